@@ -0,0 +1,391 @@
+/*
+  ==============================================================================
+
+	Archiver.cpp
+	Created: 19 Oct 2026 3:35:29pm
+	Author:  Tokamak
+
+  ==============================================================================
+*/
+
+#include "Archiver.h"
+#include "Tracer.h"
+
+class Archiver::ExportJob : public juce::ThreadPoolJob
+{
+public:
+	ExportJob(Archiver& owner, juce::int64 start, juce::int64 length, int rate, int channels, ExportFormat formatToWrite,
+		const juce::File& fileToWrite, std::function<void(juce::int64)> callback)
+		: juce::ThreadPoolJob("Export " + fileToWrite.getFileName()), archiver(owner), startMillis(start), numSamples(length),
+		sampleRate(rate), numChannels(channels), format(formatToWrite), file(fileToWrite), onFinished(std::move(callback))
+	{
+	}
+
+	JobStatus runJob() override
+	{
+		TRACE_ZONE("archiveExport");
+		juce::int64 found = -1;
+		file.deleteFile();
+		std::unique_ptr<juce::FileOutputStream> fileStream(file.createOutputStream());
+		std::unique_ptr<juce::AudioFormatWriter> writer;
+		if (fileStream != nullptr)
+			writer = AudioExport::createWriter(format, fileStream.get(), sampleRate, numChannels);
+		if (writer != nullptr)
+		{
+			fileStream.release();
+			found = archiver.writeRange(startMillis, numSamples, sampleRate, *writer, *this);
+		}
+
+		//the writer finishes the file when it goes, a file without archived audio in it is not kept
+		writer.reset();
+		fileStream.reset();
+		if (found <= 0)
+		{
+			file.deleteFile();
+			found = 0;
+		}
+		juce::MessageManager::callAsync([callback = std::move(onFinished), found]
+			{
+				if (callback)
+					callback(found);
+			});
+		return jobHasFinished;
+	}
+
+private:
+	Archiver& archiver;
+	juce::int64 startMillis;
+	juce::int64 numSamples;
+	int sampleRate;
+	int numChannels;
+	ExportFormat format;
+	juce::File file;
+	std::function<void(juce::int64)> onFinished;
+};
+
+Archiver::Archiver(BufferManager& manager, juce::PropertiesFile& settings)
+	: juce::Thread("ReSampler Archiver"), bufferManager(manager)
+{
+	archiveRoot = juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory).getChildFile("ReSampler").getChildFile("Archive");
+	quotaBytes = static_cast<juce::int64>(settings.getIntValue("archiveQuotaGB", 5)) << 30;
+
+	//every instance writes its own session folder and index, the quota covers all of them
+	auto now = juce::Time::getCurrentTime();
+	sessionFolder = archiveRoot.getChildFile(now.formatted("%Y%m%d_%H%M%S_") + juce::String::toHexString(juce::Random::getSystemRandom().nextInt(0x10000)));
+	archiveId = juce::Uuid().toString();
+
+	setEnabled(settings.getBoolValue("archiveEnabled", false));
+	startThread(juce::Thread::Priority::background);
+}
+
+Archiver::~Archiver()
+{
+	exportPool.removeAllJobs(true, 10000);
+	stopThread(5000);
+	closeSegment();
+}
+
+void Archiver::setEnabled(bool shouldBeEnabled)
+{
+	enabled = shouldBeEnabled;
+	notify();
+}
+
+void Archiver::setArchiveId(const juce::String& id)
+{
+	if (id.isEmpty())
+		return;
+	juce::ScopedLock lock(indexLock);
+	archiveId = id;
+}
+
+juce::String Archiver::getArchiveId() const
+{
+	juce::ScopedLock lock(indexLock);
+	return archiveId;
+}
+
+void Archiver::run()
+{
+	//polls the ring while archiving, parked until setEnabled while not
+	while (!threadShouldExit())
+	{
+		if (enabled)
+		{
+			archivePending();
+			wait(100);
+		}
+		else
+		{
+			closeSegment();
+			ringGeneration = -1;
+			wait(-1);
+		}
+	}
+	closeSegment();
+}
+
+void Archiver::archivePending()
+{
+	TRACE_ZONE("archivePending");
+	if (bufferManager.getRingSamples() == 0)
+		return;
+
+	//a new ring starts a new segment, archiving begins with what is written from now on
+	if (ringGeneration != bufferManager.getRingGeneration())
+	{
+		closeSegment();
+		ringGeneration = bufferManager.getRingGeneration();
+		ringSamples = bufferManager.getRingSamples();
+		sampleRate = bufferManager.getBufferSampleRate();
+		chunk.setSize(bufferManager.getBufferNumChannels(), chunkSamples);
+		nextSample = bufferManager.getTotalSamplesWritten();
+	}
+	if (sampleRate <= 0 || ringSamples <= chunkSamples)
+		return;
+
+	while (!threadShouldExit())
+	{
+		juce::int64 written = bufferManager.getTotalSamplesWritten();
+		juce::int64 nowMillis = juce::Time::currentTimeMillis();
+		if (nextSample >= written)
+			break;
+
+		//fell too far behind, the audio in between is lost
+		if (written - nextSample > ringSamples - chunkSamples)
+		{
+			juce::int64 resume = written - ringSamples / 2;
+			droppedSamples += resume - nextSample;
+			nextSample = resume;
+			closeSegment();
+		}
+
+		int numSamples = static_cast<int>(juce::jmin<juce::int64>(chunkSamples, written - nextSample));
+		if (!bufferManager.readHistory(nextSample, chunk, 0, numSamples))
+		{
+			nextSample = bufferManager.getTotalSamplesWritten();
+			closeSegment();
+			continue;
+		}
+
+		//a segment must stay contiguous in time, recording pauses start a new one
+		juce::int64 chunkMillis = nowMillis - (written - nextSample) * 1000 / sampleRate;
+		if (writer != nullptr)
+		{
+			juce::int64 expectedMillis = current.startMillis + current.numSamples * 1000 / sampleRate;
+			if (std::abs(chunkMillis - expectedMillis) > 1000 || current.numSamples >= static_cast<juce::int64>(segmentSeconds * sampleRate))
+				closeSegment();
+		}
+		if (writer == nullptr && !openSegment(chunkMillis))
+			return;
+
+		writer->writeFromAudioSampleBuffer(chunk, 0, numSamples);
+		current.numSamples += numSamples;
+		nextSample += numSamples;
+	}
+}
+
+bool Archiver::openSegment(juce::int64 startMillis)
+{
+	if (!sessionFolder.isDirectory() && !sessionFolder.createDirectory())
+		return false;
+
+	current = Segment();
+	current.startMillis = startMillis;
+	current.sampleRate = sampleRate;
+	current.numChannels = chunk.getNumChannels();
+	current.fileName = "TKRS_" + juce::Time(startMillis).formatted("%Y%m%d_%H%M%S_") + juce::String(startMillis % 1000).paddedLeft('0', 3) + ".flac";
+
+	juce::File file = sessionFolder.getChildFile(current.fileName);
+	std::unique_ptr<juce::FileOutputStream> stream(file.createOutputStream());
+	if (stream == nullptr)
+		return false;
+
+	juce::FlacAudioFormat flacFormat;
+	writer.reset(flacFormat.createWriterFor(stream.get(), sampleRate, static_cast<unsigned int>(current.numChannels), bitsPerSample, {}, 5));
+	if (writer == nullptr)
+		return false;
+	stream.release();
+	return true;
+}
+
+void Archiver::closeSegment()
+{
+	if (writer == nullptr)
+		return;
+	writer.reset();
+
+	if (current.numSamples > 0)
+	{
+		juce::ScopedLock lock(indexLock);
+		current.archiveId = archiveId;
+		current.folder = sessionFolder;
+		//one line per finished segment, appended so a crash never loses earlier entries
+		sessionFolder.getChildFile("index.txt").appendText(juce::String(current.startMillis) + " " + juce::String(current.numSamples) + " "
+			+ juce::String(current.sampleRate) + " " + juce::String(current.numChannels) + " " + current.fileName + " " + current.archiveId + "\n");
+		segments.add(current);
+	}
+	else
+		sessionFolder.getChildFile(current.fileName).deleteFile();
+
+	enforceQuota();
+}
+
+void Archiver::enforceQuota()
+{
+	//segment names are timestamps, so sorting by name is oldest first across all sessions
+	auto files = archiveRoot.findChildFiles(juce::File::findFiles, true, "*.flac");
+	std::sort(files.begin(), files.end(), [](const juce::File& a, const juce::File& b) { return a.getFileName() < b.getFileName(); });
+
+	juce::int64 total = 0;
+	for (auto& file : files)
+		total += file.getSize();
+
+	for (auto& file : files)
+	{
+		if (total <= quotaBytes.load())
+			break;
+		total -= file.getSize();
+		file.deleteFile();
+
+		if (file.getParentDirectory() == sessionFolder)
+		{
+			juce::ScopedLock lock(indexLock);
+			segments.removeIf([&file](const Segment& segment) { return segment.fileName == file.getFileName(); });
+		}
+	}
+}
+
+juce::Array<Archiver::Segment> Archiver::getSegments() const
+{
+	juce::ScopedLock lock(indexLock);
+	return segments;
+}
+
+bool Archiver::exportToFile(juce::int64 startMillis, juce::int64 numSamples, int destSampleRate, int numChannels, ExportFormat format,
+	const juce::File& file, std::function<void(juce::int64 numFound)> onFinished)
+{
+	if (isExporting() || numSamples <= 0 || destSampleRate <= 0 || numChannels <= 0)
+		return false;
+	exportPool.addJob(new ExportJob(*this, startMillis, numSamples, destSampleRate, numChannels, format, file, std::move(onFinished)), true);
+	return true;
+}
+
+juce::int64 Archiver::writeRange(juce::int64 startMillis, juce::int64 numSamples, int destSampleRate, juce::AudioFormatWriter& writer, const juce::ThreadPoolJob& job)
+{
+	//one chunk at a time from the segment's reader into the writer, gaps between segments are written as silence
+	juce::AudioBuffer<float> block(static_cast<int>(writer.numChannels), chunkSamples);
+	juce::int64 position = 0;
+	juce::int64 found = 0;
+	auto writeSilence = [&](juce::int64 end)
+		{
+			block.clear();
+			while (position < end)
+			{
+				int num = static_cast<int>(juce::jmin<juce::int64>(chunkSamples, end - position));
+				if (job.shouldExit() || !writer.writeFromAudioSampleBuffer(block, 0, num))
+					return false;
+				position += num;
+			}
+			return true;
+		};
+
+	juce::int64 endMillis = startMillis + numSamples * 1000 / destSampleRate;
+
+	auto index = loadIndex(getArchiveId());
+	//sorted by start time, find the first one that ends after startMillis
+	auto first = std::partition_point(index.begin(), index.end(), [startMillis](const Segment& segment)
+		{
+			return segment.startMillis + segment.numSamples * 1000 / juce::jmax(1, segment.sampleRate) <= startMillis;
+		});
+
+	juce::FlacAudioFormat flacFormat;
+	for (auto it = first; it != index.end() && it->startMillis < endMillis; ++it)
+	{
+		//segments at another rate would need resampling, they are skipped
+		if (it->sampleRate != destSampleRate)
+			continue;
+
+		//sessions of the same track may overlap, what is already written stays
+		juce::int64 segmentStart = (it->startMillis - startMillis) * destSampleRate / 1000;
+		juce::int64 destStart = juce::jmax(position, segmentStart);
+		juce::int64 destEnd = juce::jmin(numSamples, segmentStart + it->numSamples);
+		if (destEnd <= destStart)
+			continue;
+
+		//deleted by the quota since the index was read
+		juce::File file = it->folder.getChildFile(it->fileName);
+		if (!file.existsAsFile())
+			continue;
+		std::unique_ptr<juce::AudioFormatReader> reader(flacFormat.createReaderFor(new juce::FileInputStream(file), true));
+		if (reader == nullptr)
+			continue;
+
+		//the first read makes the FLAC decoder seek (FLAC__stream_decoder_seek_absolute), only the frames
+		//covering the range are decoded
+		if (!writeSilence(destStart))
+			return -1;
+		while (position < destEnd)
+		{
+			int num = static_cast<int>(juce::jmin<juce::int64>(chunkSamples, destEnd - position));
+			reader->read(&block, 0, num, position - segmentStart, true, true);
+			if (job.shouldExit() || !writer.writeFromAudioSampleBuffer(block, 0, num))
+				return -1;
+			position += num;
+			found += num;
+		}
+	}
+	return writeSilence(numSamples) ? found : -1;
+}
+
+juce::Array<Archiver::Segment> Archiver::loadIndex(const juce::String& id)
+{
+	//index files only ever grow, one that kept its size is not read again
+	juce::ScopedLock lock(sessionIndexLock);
+	auto indexFiles = archiveRoot.findChildFiles(juce::File::findFiles, true, "index.txt");
+	std::map<juce::String, SessionIndex> current;
+	for (auto& indexFile : indexFiles)
+	{
+		auto path = indexFile.getFullPathName();
+		auto& session = current[path];
+		auto previous = sessionIndexes.find(path);
+		if (previous != sessionIndexes.end() && previous->second.size == indexFile.getSize())
+		{
+			session = std::move(previous->second);
+			continue;
+		}
+		session.size = indexFile.getSize();
+		parseIndex(indexFile, session.segments);
+	}
+	sessionIndexes = std::move(current);
+
+	juce::Array<Segment> result;
+	for (auto& entry : sessionIndexes)
+		for (auto& segment : entry.second.segments)
+			if (segment.archiveId == id)
+				result.add(segment);
+	std::sort(result.begin(), result.end(), [](const Segment& a, const Segment& b) { return a.startMillis < b.startMillis; });
+	return result;
+}
+
+void Archiver::parseIndex(const juce::File& indexFile, juce::Array<Segment>& result)
+{
+	result.clearQuick();
+	juce::StringArray lines;
+	indexFile.readLines(lines);
+	for (auto& line : lines)
+	{
+		auto fields = juce::StringArray::fromTokens(line, " ", "");
+		if (fields.size() < 6)
+			continue;
+		Segment segment;
+		segment.startMillis = fields[0].getLargeIntValue();
+		segment.numSamples = fields[1].getLargeIntValue();
+		segment.sampleRate = fields[2].getIntValue();
+		segment.numChannels = fields[3].getIntValue();
+		segment.fileName = fields[4];
+		segment.archiveId = fields[5];
+		segment.folder = indexFile.getParentDirectory();
+		result.add(segment);
+	}
+}
@@ -0,0 +1,123 @@
+/*
+  ==============================================================================
+
+	Archiver.h
+	Created: 19 Oct 2026 3:35:29pm
+	Author:  Tokamak
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <map>
+#include "BufferManager.h"
+#include "AudioExport.h"
+
+//==============================================================================
+/**
+	Streams everything written to the ring into rolling FLAC segments on its own
+	thread, so audio is kept after the ring overwrites it. The handoff from the
+	audio thread is the ring itself: the archiver follows the absolute sample
+	counter and copies through BufferManager::readHistory, which never blocks
+	writeToBuffer. If it falls a whole ring behind the missed audio becomes a gap.
+
+	Every segment is contiguous in time (pauses, gaps and ring reallocations start
+	a new one) and is listed in an append-only index with its start time, so a
+	time range maps to a file and a sample offset without decoding anything else.
+	The oldest segments are deleted once the archive folder exceeds its quota.
+
+	Each processor runs its own session folder, and every index line carries
+	the archive id the processor keeps in its state. exportToFile() reads the
+	indexes of all session folders, re-parsing only the ones that grew, and uses
+	the segments with the same id, so a reloaded project still finds what earlier
+	sessions of the same track archived. Exports run on a thread of their own and
+	go segment by segment into the writer, a range is never held in memory.
+*/
+class Archiver : private juce::Thread
+{
+public:
+	struct Segment
+	{
+		juce::int64 startMillis = 0;	//wall clock time of the first sample
+		juce::int64 numSamples = 0;
+		int sampleRate = 0;
+		int numChannels = 0;
+		juce::String fileName;
+		juce::String archiveId;
+		juce::File folder;
+	};
+
+	Archiver(BufferManager& bufferManager, juce::PropertiesFile& settings);
+	~Archiver() override;
+
+	void setEnabled(bool shouldBeEnabled);
+	bool isEnabled() const { return enabled.load(); }
+	void setQuota(juce::int64 bytes) { quotaBytes = bytes; }
+	juce::int64 getQuota() const { return quotaBytes.load(); }
+	juce::File getArchiveFolder() const { return archiveRoot; }
+	juce::int64 getNumDroppedSamples() const { return droppedSamples.load(); }
+	//saved with the processor state, ties the sessions of one track together
+	void setArchiveId(const juce::String& id);
+	juce::String getArchiveId() const;
+
+	//writes numSamples of this track's archived audio from startMillis into file in the background, from every
+	//session, unarchived parts stay silent. onFinished gets the number of archived samples written on the message
+	//thread; with none, a failed write or a cancelled export the file is deleted. Segments still being written are
+	//not readable. False while the previous export is still running
+	bool exportToFile(juce::int64 startMillis, juce::int64 numSamples, int sampleRate, int numChannels, ExportFormat format,
+		const juce::File& file, std::function<void(juce::int64 numFound)> onFinished);
+	bool isExporting() const { return exportPool.getNumJobs() > 0; }
+	juce::Array<Segment> getSegments() const;
+
+	static constexpr double segmentSeconds = 60.0;
+	static constexpr int chunkSamples = 16384;
+	static constexpr int bitsPerSample = 24;
+
+private:
+	class ExportJob;
+
+	void run() override;
+	void archivePending();
+	bool openSegment(juce::int64 startMillis);
+	void closeSegment();
+	void enforceQuota();
+	juce::Array<Segment> loadIndex(const juce::String& id);
+	static void parseIndex(const juce::File& indexFile, juce::Array<Segment>& result);
+	//-1 if the writer failed or the job was cancelled, otherwise the number of archived samples written
+	juce::int64 writeRange(juce::int64 startMillis, juce::int64 numSamples, int sampleRate, juce::AudioFormatWriter& writer, const juce::ThreadPoolJob& job);
+
+	BufferManager& bufferManager;
+	std::atomic<bool> enabled{ false };
+	std::atomic<juce::int64> quotaBytes{ 0 };
+	std::atomic<juce::int64> droppedSamples{ 0 };
+
+	juce::File archiveRoot;
+	juce::File sessionFolder;
+
+	//archiver thread state
+	int ringGeneration = -1;
+	int ringSamples = 0;
+	int sampleRate = 0;
+	juce::int64 nextSample = 0;
+	juce::AudioBuffer<float> chunk;
+	std::unique_ptr<juce::AudioFormatWriter> writer;
+	Segment current;
+
+	mutable juce::CriticalSection indexLock;
+	juce::Array<Segment> segments;
+	juce::String archiveId;
+
+	//parsed index files of every session, keyed by path, with the size they had
+	struct SessionIndex
+	{
+		juce::int64 size = 0;
+		juce::Array<Segment> segments;
+	};
+	juce::CriticalSection sessionIndexLock;
+	std::map<juce::String, SessionIndex> sessionIndexes;
+
+	juce::ThreadPool exportPool{ juce::ThreadPoolOptions().withThreadName("ReSampler Archive Export").withNumberOfThreads(1) };
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Archiver)
+};
@@ -0,0 +1,113 @@
+/*
+  ==============================================================================
+
+	AudioExport.cpp
+	Created: 19 Oct 2026 4:01:54pm
+	Author:  Tokamak
+
+  ==============================================================================
+*/
+
+#include "AudioExport.h"
+#include "ParallelFlacEncoder.h"
+#include "PcmWriter.h"
+#include "Tracer.h"
+
+juce::String AudioExport::getFormatName(ExportFormat format)
+{
+	switch (format)
+	{
+	case Wav16:			return "WAV 16-bit";
+	case Wav24:			return "WAV 24-bit";
+	case Wav32Float:	return "WAV 32-bit float";
+	case Flac16:		return "FLAC 16-bit";
+	case Flac24:		return "FLAC 24-bit";
+	case Aiff24:		return "AIFF 24-bit";
+	case Wav16Dither:	return "WAV 16-bit dithered";
+	default:			return {};
+	}
+}
+
+juce::String AudioExport::getFileExtension(ExportFormat format)
+{
+	if (isFlac(format))
+		return ".flac";
+	return format == Aiff24 ? ".aiff" : ".wav";
+}
+
+int AudioExport::getBitsPerSample(ExportFormat format)
+{
+	switch (format)
+	{
+	case Wav16:
+	case Wav16Dither:
+	case Flac16:		return 16;
+	case Wav32Float:	return 32;
+	default:			return 24;
+	}
+}
+
+std::unique_ptr<juce::AudioFormatWriter> AudioExport::createWriter(ExportFormat format, juce::OutputStream* stream, double sampleRate, int numChannels)
+{
+	//WAV is converted and interleaved in blocks, 32 bits are IEEE float like WavAudioFormat writes them
+	if (format == Wav16 || format == Wav16Dither || format == Wav24 || format == Wav32Float)
+	{
+		auto encoding = format == Wav24 ? PcmWriter::Encoding::int24 : (format == Wav32Float ? PcmWriter::Encoding::float32 : PcmWriter::Encoding::int16);
+		return std::make_unique<PcmWriter>(stream, sampleRate, numChannels, encoding, format == Wav16Dither);
+	}
+
+	std::unique_ptr<juce::AudioFormat> audioFormat;
+	if (isFlac(format))
+		audioFormat = std::make_unique<juce::FlacAudioFormat>();
+	else
+		audioFormat = std::make_unique<juce::AiffAudioFormat>();
+
+	return std::unique_ptr<juce::AudioFormatWriter>(audioFormat->createWriterFor(stream, sampleRate,
+		static_cast<unsigned int>(numChannels), getBitsPerSample(format), {}, isFlac(format) ? ParallelFlacEncoder::quality : 0));
+}
+
+bool AudioExport::writeFile(const juce::AudioBuffer<float>& audio, int startSample, int numSamples, double sampleRate, ExportFormat format, const juce::File& file)
+{
+	TRACE_ZONE("AudioExport::writeFile");
+	if (isFlac(format))
+		return ParallelFlacEncoder::writeFile(audio, startSample, numSamples, sampleRate, getBitsPerSample(format), file);
+
+	std::unique_ptr<juce::FileOutputStream> stream(file.createOutputStream());
+	if (stream == nullptr)
+		return false;
+	auto writer = createWriter(format, stream.get(), sampleRate, audio.getNumChannels());
+	if (writer == nullptr)
+		return false;
+	stream.release();
+	return writer->writeFromAudioSampleBuffer(audio, startSample, numSamples);
+}
+
+bool AudioExport::writeRing(const juce::AudioBuffer<float>& ring, int startSample, int numSamples, double sampleRate, ExportFormat format, const juce::File& file)
+{
+	TRACE_ZONE("AudioExport::writeRing");
+	int firstPart = juce::jmin(numSamples, ring.getNumSamples() - startSample);
+	if (firstPart == numSamples)
+		return writeFile(ring, startSample, numSamples, sampleRate, format, file);
+
+	//the parallel FLAC encoder cuts one contiguous buffer into parts
+	if (isFlac(format))
+	{
+		juce::AudioBuffer<float> joined(ring.getNumChannels(), numSamples);
+		for (int channel = 0; channel < ring.getNumChannels(); channel++)
+		{
+			joined.copyFrom(channel, 0, ring, channel, startSample, firstPart);
+			joined.copyFrom(channel, firstPart, ring, channel, 0, numSamples - firstPart);
+		}
+		return writeFile(joined, 0, numSamples, sampleRate, format, file);
+	}
+
+	std::unique_ptr<juce::FileOutputStream> stream(file.createOutputStream());
+	if (stream == nullptr)
+		return false;
+	auto writer = createWriter(format, stream.get(), sampleRate, ring.getNumChannels());
+	if (writer == nullptr)
+		return false;
+	stream.release();
+	return writer->writeFromAudioSampleBuffer(ring, startSample, firstPart)
+		&& writer->writeFromAudioSampleBuffer(ring, 0, numSamples - firstPart);
+}
@@ -0,0 +1,46 @@
+/*
+  ==============================================================================
+
+	AudioExport.h
+	Created: 19 Oct 2026 4:01:54pm
+	Author:  Tokamak
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+enum ExportFormat
+{
+	Wav16,
+	Wav24,
+	Wav32Float,
+	Flac16,
+	Flac24,
+	Aiff24,
+	Wav16Dither,
+	numExportFormats
+};
+
+//==============================================================================
+/**
+	The file formats exports can be written in. Writers for chunked exports come
+	from createWriter, WAV goes through PcmWriter; a whole buffer goes through
+	writeFile, which encodes FLAC on all cores, and a range of the ring through
+	writeRing, which writes both sides of the wrap without copying them first.
+*/
+class AudioExport
+{
+public:
+	static juce::String getFormatName(ExportFormat format);
+	static juce::String getFileExtension(ExportFormat format);
+	static int getBitsPerSample(ExportFormat format);
+	static bool isFlac(ExportFormat format) { return format == Flac16 || format == Flac24; }
+
+	//takes ownership of stream when a writer is returned
+	static std::unique_ptr<juce::AudioFormatWriter> createWriter(ExportFormat format, juce::OutputStream* stream, double sampleRate, int numChannels);
+	static bool writeFile(const juce::AudioBuffer<float>& audio, int startSample, int numSamples, double sampleRate, ExportFormat format, const juce::File& file);
+	//startSample + numSamples may run past the end of the ring and continue at its start
+	static bool writeRing(const juce::AudioBuffer<float>& ring, int startSample, int numSamples, double sampleRate, ExportFormat format, const juce::File& file);
+};
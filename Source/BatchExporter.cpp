@@ -0,0 +1,128 @@
+/*
+  ==============================================================================
+
+	BatchExporter.cpp
+	Created: 19 Oct 2026 3:38:36pm
+	Author:  Tokamak
+
+  ==============================================================================
+*/
+
+#include "BatchExporter.h"
+#include "Tracer.h"
+
+class BatchExporter::ExportJob : public juce::ThreadPoolJob
+{
+public:
+	ExportJob(BatchExporter& owner, BufferManager& manager, std::shared_ptr<BufferSnapshot> snapshotToRead, const Region& regionToExport, double rate, ExportFormat formatToWrite)
+		: juce::ThreadPoolJob("Export " + regionToExport.file.getFileName()),
+		exporter(owner), bufferManager(manager), snapshot(std::move(snapshotToRead)), region(regionToExport), sampleRate(rate), format(formatToWrite)
+	{
+	}
+
+	bool isFrom(const BatchExporter& owner) const { return &exporter == &owner; }
+
+	JobStatus runJob() override
+	{
+		TRACE_ZONE("exportRegion");
+		if (!exportRegion())
+		{
+			region.file.deleteFile();
+			exporter.numFailed++;
+		}
+		exporter.numFinished++;
+		exporter.numPending--;
+		return jobHasFinished;
+	}
+
+private:
+	bool exportRegion()
+	{
+		//regions already run in parallel, so each FLAC region is encoded by one writer
+		std::unique_ptr<juce::FileOutputStream> fileStream(region.file.createOutputStream());
+		if (fileStream == nullptr)
+			return false;
+
+		auto writer = AudioExport::createWriter(format, fileStream.get(), sampleRate, snapshot->getNumChannels());
+		if (writer == nullptr)
+			return false;
+		fileStream.release();
+
+		juce::AudioBuffer<float> chunk(snapshot->getNumChannels(), juce::jmin(chunkSamples, region.numSamples));
+		for (int done = 0; done < region.numSamples && !shouldExit();)
+		{
+			int numSamples = juce::jmin(chunk.getNumSamples(), region.numSamples - done);
+			int ringStart = (region.ringStart + done) % snapshot->getNumSamples();
+			bufferManager.readFromSnapshot(*snapshot, chunk, ringStart, numSamples);
+			if (!writer->writeFromAudioSampleBuffer(chunk, 0, numSamples))
+				return false;
+			done += numSamples;
+			exporter.samplesDone += numSamples;
+		}
+
+		//a cancelled region is incomplete, the caller deletes the file once the writer has closed it
+		return !shouldExit();
+	}
+
+	BatchExporter& exporter;
+	BufferManager& bufferManager;
+	std::shared_ptr<BufferSnapshot> snapshot;
+	Region region;
+	double sampleRate;
+	ExportFormat format;
+};
+
+BatchExporter::BatchExporter()
+{
+}
+
+BatchExporter::~BatchExporter()
+{
+	cancel();
+}
+
+bool BatchExporter::start(BufferManager& bufferManager, std::shared_ptr<BufferSnapshot> snapshot, const juce::Array<Region>& regions, double sampleRate, ExportFormat format)
+{
+	if (isRunning() || snapshot == nullptr || regions.isEmpty())
+		return false;
+
+	samplesDone = 0;
+	numFinished = 0;
+	numFailed = 0;
+	numRegions = regions.size();
+	numPending = regions.size();
+	totalSamples = 0;
+	for (auto& region : regions)
+		totalSamples += region.numSamples;
+
+	//longest regions first so the pool does not end with one long job on one core
+	auto sorted = regions;
+	std::sort(sorted.begin(), sorted.end(), [](const Region& a, const Region& b) { return a.numSamples > b.numSamples; });
+	for (auto& region : sorted)
+		exportPool->pool.addJob(new ExportJob(*this, bufferManager, snapshot, region, sampleRate, format), true);
+	return true;
+}
+
+void BatchExporter::cancel()
+{
+	//the pool is shared, only this exporter's jobs are removed
+	struct OwnJobs : public juce::ThreadPool::JobSelector
+	{
+		explicit OwnJobs(const BatchExporter& exporterToMatch) : owner(exporterToMatch) {}
+		bool isJobSuitable(juce::ThreadPoolJob* job) override
+		{
+			auto* exportJob = dynamic_cast<ExportJob*>(job);
+			return exportJob != nullptr && exportJob->isFrom(owner);
+		}
+		const BatchExporter& owner;
+	};
+
+	OwnJobs ownJobs(*this);
+	exportPool->pool.removeAllJobs(true, 10000, &ownJobs);
+	numPending = 0;
+}
+
+double BatchExporter::getProgress() const
+{
+	return totalSamples > 0 ? static_cast<double>(samplesDone.load()) / totalSamples : 1.0;
+}
@@ -0,0 +1,66 @@
+/*
+  ==============================================================================
+
+	BatchExporter.h
+	Created: 19 Oct 2026 3:38:36pm
+	Author:  Tokamak
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "BufferManager.h"
+#include "AudioExport.h"
+
+//==============================================================================
+/**
+	Exports a list of regions concurrently, one job per region on a pool with a
+	thread per core that every instance in the process shares. Jobs read the
+	ring through a snapshot in fixed size chunks without taking the audio lock,
+	so no region is ever copied as a whole and the live ring can keep recording.
+	A region that could not be written, or whose job was cancelled, leaves no
+	file behind and counts as failed.
+*/
+class BatchExporter
+{
+public:
+	struct Region
+	{
+		int ringStart = 0;
+		int numSamples = 0;
+		juce::File file;
+	};
+
+	BatchExporter();
+	~BatchExporter();
+
+	//every job holds a reference to the snapshot, it is released when the last one finishes
+	bool start(BufferManager& bufferManager, std::shared_ptr<BufferSnapshot> snapshot, const juce::Array<Region>& regions, double sampleRate, ExportFormat format);
+	void cancel();
+
+	bool isRunning() const { return numPending.load() > 0; }
+	double getProgress() const;
+	//regions done so far, written or failed
+	int getNumFinished() const { return numFinished.load(); }
+	int getNumFailed() const { return numFailed.load(); }
+	int getNumRegions() const { return numRegions; }
+
+	static constexpr int chunkSamples = 65536;
+
+private:
+	class ExportJob;
+
+	struct ExportPool
+	{
+		juce::ThreadPool pool{ juce::ThreadPoolOptions().withThreadName("ReSampler Export").withNumberOfThreads(juce::jmax(1, juce::SystemStats::getNumCpus())) };
+	};
+
+	juce::SharedResourcePointer<ExportPool> exportPool;
+	std::atomic<juce::int64> samplesDone{ 0 };
+	std::atomic<int> numPending{ 0 };
+	std::atomic<int> numFinished{ 0 };
+	std::atomic<int> numFailed{ 0 };
+	juce::int64 totalSamples = 0;
+	int numRegions = 0;
+};
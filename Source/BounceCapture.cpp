@@ -0,0 +1,115 @@
+/*
+  ==============================================================================
+
+	BounceCapture.cpp
+	Created: 19 Oct 2026 3:51:37pm
+	Author:  Tokamak
+
+  ==============================================================================
+*/
+
+#include "BounceCapture.h"
+#include "Tracer.h"
+
+BounceCapture::BounceCapture(juce::PropertiesFile& settingsToUse)
+	: settings(settingsToUse)
+{
+	enabled = settings.getBoolValue("captureBounces", false);
+}
+
+BounceCapture::~BounceCapture()
+{
+	finish();
+	writerThread.stopThread(5000);
+}
+
+void BounceCapture::setEnabled(bool shouldBeEnabled)
+{
+	enabled = shouldBeEnabled;
+	if (!shouldBeEnabled)
+		finish();
+}
+
+juce::File BounceCapture::getLastFile() const
+{
+	const juce::ScopedLock lock(writerLock);
+	return lastFile;
+}
+
+bool BounceCapture::open(int numChannels, double sampleRate)
+{
+	//same folder as the drag exports, read when the bounce starts so a changed path applies
+	juce::File folder(settings.getValue("recordingPath",
+		juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory).getFullPathName() + "\\ReSampler\\Recordings"));
+	if (!folder.createDirectory())
+		return false;
+
+	juce::String timestamp = juce::Time::getCurrentTime().formatted("%Y%m%d_%H%M%S");
+	auto file = folder.getNonexistentChildFile("TKRS_bounce_" + timestamp, ".wav", false);
+
+	auto stream = std::make_unique<juce::FileOutputStream>(file);
+	if (!stream->openedOk())
+		return false;
+
+	juce::WavAudioFormat wavFormat;
+	std::unique_ptr<juce::AudioFormatWriter> fileWriter(wavFormat.createWriterFor(stream.get(), sampleRate,
+		static_cast<unsigned int>(numChannels), bitsPerSample, {}, 0));
+	if (fileWriter == nullptr)
+		return false;
+	stream.release();
+
+	if (!writerThread.isThreadRunning())
+		writerThread.startThread(juce::Thread::Priority::normal);
+	writer = std::make_unique<juce::AudioFormatWriter::ThreadedWriter>(fileWriter.release(), writerThread, fifoSamples);
+	currentFile = file;
+	writerChannels = numChannels;
+	return true;
+}
+
+void BounceCapture::write(const juce::AudioBuffer<float>& buffer, int numChannels, double sampleRate)
+{
+	TRACE_ZONE("BounceCapture::write");
+	if (!enabled.load())
+		return;
+
+	const juce::ScopedLock lock(writerLock);
+	if (writer == nullptr)
+	{
+		//one attempt per bounce, a failed open is not retried every block
+		if (openFailed)
+			return;
+		openFailed = buffer.getNumChannels() == 0 || !open(juce::jlimit(1, maxChannels, juce::jmin(numChannels, buffer.getNumChannels())), sampleRate);
+		if (openFailed)
+			return;
+		capturing = true;
+	}
+
+	//the render is not realtime, so wait for the encoder instead of dropping
+	int numSamples = buffer.getNumSamples();
+	for (int done = 0; done < numSamples;)
+	{
+		int chunk = juce::jmin(numSamples - done, fifoSamples / 4);
+		const float* channels[maxChannels] = {};
+		for (int channel = 0; channel < writerChannels; channel++)
+			channels[channel] = buffer.getReadPointer(juce::jmin(channel, buffer.getNumChannels() - 1), done);
+
+		if (writer->write(channels, chunk))
+			done += chunk;
+		else
+			juce::Thread::sleep(1);
+	}
+}
+
+void BounceCapture::finish()
+{
+	const juce::ScopedLock lock(writerLock);
+	openFailed = false;
+	if (writer == nullptr)
+		return;
+
+	//ThreadedWriter flushes its FIFO when destroyed
+	writer.reset();
+	lastFile = currentFile;
+	currentFile = juce::File();
+	capturing = false;
+}
@@ -0,0 +1,56 @@
+/*
+  ==============================================================================
+
+	BounceCapture.h
+	Created: 19 Oct 2026 3:51:37pm
+	Author:  Tokamak
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+	Writes a whole offline bounce straight to a file, which the ring cannot hold
+	once the render is longer than the buffer length. The file is opened on the
+	first non-realtime block and closed when the host switches back to realtime
+	or releases resources. Encoding runs on a background thread behind a FIFO;
+	an offline render may wait for it, so nothing is ever dropped.
+*/
+class BounceCapture
+{
+public:
+	explicit BounceCapture(juce::PropertiesFile& settingsToUse);
+	~BounceCapture();
+
+	void setEnabled(bool shouldBeEnabled);
+	bool isEnabled() const { return enabled.load(); }
+	bool isCapturing() const { return capturing.load(); }
+	juce::File getLastFile() const;
+
+	//offline audio thread only
+	void write(const juce::AudioBuffer<float>& buffer, int numChannels, double sampleRate);
+	//closes the current file, safe from any thread
+	void finish();
+
+	static constexpr int fifoSamples = 1 << 18;
+	static constexpr int bitsPerSample = 24;
+	static constexpr int maxChannels = 32;
+
+private:
+	bool open(int numChannels, double sampleRate);
+
+	juce::PropertiesFile& settings;
+
+	juce::TimeSliceThread writerThread{ "ReSampler Bounce Writer" };
+	std::unique_ptr<juce::AudioFormatWriter::ThreadedWriter> writer;
+	juce::CriticalSection writerLock;
+	std::atomic<bool> enabled{ false };
+	std::atomic<bool> capturing{ false };
+	bool openFailed = false;
+	int writerChannels = 0;
+	juce::File currentFile;
+	juce::File lastFile;
+};
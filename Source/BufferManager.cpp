@@ -9,114 +9,843 @@
 */
 
 #include "BufferManager.h"
+#if JUCE_INTEL
+ #include <xmmintrin.h>
+#endif
 
 BufferManager::BufferManager()
 {
+	spillPublished.signal();
 }
 
 BufferManager::~BufferManager()
 {
+	if (hibernated.load())
+		spillFile.deleteFile();
 }
 
-void BufferManager::initializeBuffer(int numChannels, int sampleRate)
+void BufferManager::initializeBuffer(int numChannels, int sampleRate, int length)
 {
+	int previousRate = bufferParameters.sampleRate;
+	int previousChannels = bufferParameters.numChannels;
+
+	//hosts call prepareToPlay again without changing anything, the history stays
+	if (recordBuffer != nullptr && numChannels == previousChannels && sampleRate == previousRate && length == bufferLength)
+		return;
+
+	//a new sample rate: record at the new rate from now on and convert the old history in the background,
+	//leaving room for it in front of the write head with a second to spare before the head comes around.
+	//Any other change starts an empty ring, so a hibernated history is never restored here
+	juce::AudioBuffer<float> history;
+	std::function<bool(juce::AudioBuffer<float>&)> loadHistory;
+	int reserved = 0;
+	if (recordBuffer != nullptr && sampleRate != previousRate && previousRate > 0 && getTotalSamplesWritten() > 0)
+	{
+		int newRing = length * sampleRate;
+		juce::int64 written = getTotalSamplesWritten();
+		juce::int64 oldValid = juce::jmin<juce::int64>(written, getRingSamples());
+		reserved = static_cast<int>(juce::jmin<juce::int64>(std::llround(oldValid * static_cast<double>(sampleRate) / previousRate),
+			newRing - juce::jmin(newRing / 2, sampleRate)));
+		int oldNeeded = static_cast<int>(juce::jmin<juce::int64>(oldValid, static_cast<juce::int64>(std::ceil(reserved * static_cast<double>(previousRate) / sampleRate)) + 1));
+
+		//a hibernated history is read back from disk on the conversion thread, prepareToPlay does not wait for it
+		if (reserved > 0 && isHibernated())
+			loadHistory = detachSpill(written - oldNeeded, oldNeeded);
+		if (loadHistory == nullptr)
+		{
+			history.setSize(previousChannels, oldNeeded);
+			if (reserved <= 0 || !readHistory(written - oldNeeded, history, 0, oldNeeded))
+				reserved = 0;
+		}
+	}
+
 	//ÉèÖÃbuffer²ÎÊý
 	bufferParameters.numChannels = numChannels;
 	bufferParameters.sampleRate = sampleRate;
+	reallocateRing(length, reserved);
 
-	//¶ÁÈ¡ÅäÖÃÎÄ¼þ
-	juce::PropertiesFile::Options options;
-	options.applicationName = "TKRS";
-	options.filenameSuffix = ".settings";
-	options.folderName = (juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory).getFullPathName() + "\\ReSampler").toStdString();
-	options.storageFormat = juce::PropertiesFile::storeAsXML;
-	juce::PropertiesFile propertiesFile(options);
-	if (propertiesFile.containsKey("bufferLength"))
+	if (reserved > 0)
 	{
-		setBufferLength(propertiesFile.getIntValue("bufferLength"));
+		if (historyResampler == nullptr)
+			historyResampler = std::make_unique<HistoryResampler>(*this);
+		historyResampler->start(std::move(history), previousRate, sampleRate, reserved, getRingGeneration(), std::move(loadHistory));
 	}
-	else
-		setBufferLength(30);
 }
 
 void BufferManager::setBufferLength(int length)
 {
+	reallocateRing(length, 0);
+}
+
+void BufferManager::reallocateRing(int length, int reservedSamples)
+{
+	TRACE_ZONE("setBufferLength");
+	juce::ScopedLock historyLock(historyReadLock);
 	juce::ScopedLock lock(bufferLock);
 	bufferLength = length;
+	discardHibernation();
 
 	if (recordBuffer == nullptr)
 	{
 		recordBuffer = std::make_unique<juce::AudioBuffer<float>>(bufferParameters.numChannels, bufferLength * bufferParameters.sampleRate);
 		recordBuffer->clear();
 	}
-	else
+	else if (sharedHistory == nullptr)
 	{
 		recordBuffer->setSize(bufferParameters.numChannels, bufferLength * bufferParameters.sampleRate);
 		recordBuffer->clear();
-		bufferState.writePosition = 0;
 	}
+
+	//a fresh mapping is already zeroed
+	if (sharedHistory != nullptr && !placeRingInSharedMemory(false, ringGeneration.load() + 1))
+	{
+		recordBuffer->setSize(bufferParameters.numChannels, bufferLength * bufferParameters.sampleRate);
+		recordBuffer->clear();
+	}
+
+	//the ring layout changed, existing snapshots no longer describe it and stop counting towards maxSnapshots
+	for (auto* snapshot : activeSnapshots)
+		snapshot->valid.store(false, std::memory_order_release);
+	activeSnapshots.clearQuick();
+	snapshotPool.setSize(0, 0);
+	freePoolSlots.clear();
+	poolSlotUsers.clear();
+
+	//recording continues after the room reserved for converted history
+	ringSamples.store(recordBuffer->getNumSamples(), std::memory_order_release);
+	bufferState.writePosition = reservedSamples;
+	writeEnd.store(reservedSamples, std::memory_order_relaxed);
+	samplesWritten.store(reservedSamples, std::memory_order_release);
+	ringGeneration.fetch_add(1, std::memory_order_acq_rel);
+}
+
+bool BufferManager::spliceHistory(const juce::AudioBuffer<float>& source, int sourceStart, int numSamples, int generation)
+{
+	TRACE_ZONE("spliceHistory");
+	//the room starts at absolute sample 0, copied in short locked chunks so the audio thread barely waits,
+	//anything the write head has already come around to is newer audio and is left alone
+	for (int done = 0; done < numSamples; done += spliceChunkSamples)
+	{
+		juce::ScopedLock historyLock(historyReadLock);
+		juce::ScopedLock lock(bufferLock);
+		if (recordBuffer == nullptr || ringGeneration.load() != generation)
+			return false;
+
+		int ringSamples = recordBuffer->getNumSamples();
+		int end = juce::jmin(numSamples, done + spliceChunkSamples, ringSamples);
+		int first = static_cast<int>(juce::jlimit<juce::int64>(done, end, samplesWritten.load() - ringSamples));
+		int numChannels = juce::jmin(source.getNumChannels(), recordBuffer->getNumChannels());
+		for (int channel = 0; channel < numChannels && first < end; channel++)
+			recordBuffer->copyFrom(channel, first, source, channel, sourceStart + first, end - first);
+	}
+
+	historySplices.fetch_add(1, std::memory_order_acq_rel);
+	return true;
 }
 
 void BufferManager::writeToBuffer(const juce::AudioBuffer<float>& buffer)
 {
-	juce::ScopedLock lock(bufferLock);
+	TRACE_ZONE("writeToBuffer");
+	TimedScopedLock lock(bufferLock, profiler);
 	if (recordBuffer == nullptr || bufferState.isRecording == false)
 		return;
+	if (hibernated.load(std::memory_order_relaxed))
+	{
+		writeWakeSegment(buffer);
+		return;
+	}
 
 	int numChannels = buffer.getNumChannels();
 	int numSamples = buffer.getNumSamples();
-	
-	if (bufferState.writePosition + numSamples > recordBuffer->getNumSamples())
+
+	if (!activeSnapshots.isEmpty())
+		preserveSnapshotSegments(bufferState.writePosition, numSamples);
+	publishWriteEnd(samplesWritten.load(std::memory_order_relaxed) + numSamples);
+
+	//a bounce longer than the ring only needs its tail, and big offline blocks skip the cache
+	int ringSamples = recordBuffer->getNumSamples();
+	int skipped = juce::jmax(0, numSamples - ringSamples);
+	int toWrite = numSamples - skipped;
+	int writeStart = static_cast<int>((bufferState.writePosition + static_cast<juce::int64>(skipped)) % ringSamples);
+	bool streaming = offlineMode.load(std::memory_order_relaxed) && toWrite >= streamingThreshold;
+	numChannels = juce::jmin(numChannels, recordBuffer->getNumChannels());
+
+	if (writeStart + toWrite > ringSamples)
 	{
-		int overlap = bufferState.writePosition + numSamples - recordBuffer->getNumSamples();
+		int overlap = writeStart + toWrite - ringSamples;
 		for (int channel = 0; channel < numChannels; channel++)
 		{
-			recordBuffer->copyFrom(channel, bufferState.writePosition, buffer, channel, 0, recordBuffer->getNumSamples() - bufferState.writePosition);
-			recordBuffer->copyFrom(channel, 0, buffer, channel, recordBuffer->getNumSamples() - bufferState.writePosition, overlap);
+			writeSegment(channel, writeStart, buffer, skipped, ringSamples - writeStart, streaming);
+			writeSegment(channel, 0, buffer, skipped + ringSamples - writeStart, overlap, streaming);
 		}
 		bufferState.writePosition = overlap;
 	}
 	else
 	{
 		for (int channel = 0; channel < numChannels; channel++)
+			writeSegment(channel, writeStart, buffer, skipped, toWrite, streaming);
+		bufferState.writePosition = (writeStart + toWrite) % ringSamples;
+	}
+#if JUCE_INTEL
+	if (streaming)
+		_mm_sfence();
+#endif
+
+	samplesWritten.store(samplesWritten.load(std::memory_order_relaxed) + numSamples, std::memory_order_release);
+	if (sharedHistory != nullptr)
+		sharedHistory->publish(samplesWritten.load(std::memory_order_relaxed));
+}
+
+void BufferManager::readFromBuffer(juce::AudioBuffer<float>& buffer)
+{
+	TRACE_ZONE("readFromBuffer");
+	TimedScopedLock lock(bufferLock, profiler);
+	if (recordBuffer == nullptr || bufferState.isPlaying == false || hibernated.load(std::memory_order_relaxed))
+		return;
+
+	int numChannels = juce::jmin(buffer.getNumChannels(), recordBuffer->getNumChannels());
+	int numSamples = buffer.getNumSamples();
+	int ringSamples = recordBuffer->getNumSamples();
+
+	//snapshot playback goes through a scratch buffer that only grows, the live ring is mixed in place
+	if (playbackSnapshot != nullptr && playbackSnapshot->isValid())
+	{
+		//the scratch buffer was sized on the message thread, blocks larger than it are mixed in chunks
+		int scratchSamples = playbackScratch.getNumSamples();
+		numChannels = juce::jmin(numChannels, playbackScratch.getNumChannels());
+		for (int done = 0; done < numSamples && scratchSamples > 0; done += scratchSamples)
 		{
-			recordBuffer->copyFrom(channel, bufferState.writePosition, buffer, channel, 0, numSamples);
+			int chunk = juce::jmin(scratchSamples, numSamples - done);
+			copySnapshotRange(*playbackSnapshot, playbackScratch, 0, bufferState.readPosition, chunk);
+			for (int channel = 0; channel < numChannels; channel++)
+				buffer.addFrom(channel, done, playbackScratch, channel, 0, chunk);
+			bufferState.readPosition = (bufferState.readPosition + chunk) % ringSamples;
 		}
-		bufferState.writePosition += numSamples;
+		return;
+	}
+
+	int position = bufferState.readPosition;
+	for (int done = 0; done < numSamples;)
+	{
+		int chunk = juce::jmin(numSamples - done, ringSamples - position);
+		for (int channel = 0; channel < numChannels; channel++)
+			buffer.addFrom(channel, done, *recordBuffer, channel, position, chunk);
+		done += chunk;
+		position = (position + chunk) % ringSamples;
 	}
+	bufferState.readPosition = position;
 }
 
-void BufferManager::readFromBuffer(juce::AudioBuffer<float>& buffer)
+void BufferManager::writeSegment(int channel, int ringStart, const juce::AudioBuffer<float>& source, int sourceStart, int numSamples, bool streaming)
 {
+	float* dest = recordBuffer->getWritePointer(channel, ringStart);
+	const float* src = source.getReadPointer(channel, sourceStart);
+#if JUCE_INTEL
+	if (streaming)
+	{
+		//non-temporal stores from the first 16 byte boundary, the edges are copied normally
+		int head = juce::jmin(numSamples, static_cast<int>(((16 - (reinterpret_cast<juce::pointer_sized_uint>(dest) & 15)) & 15) / sizeof(float)));
+		juce::FloatVectorOperations::copy(dest, src, head);
+		int i = head;
+		for (; i + 4 <= numSamples; i += 4)
+			_mm_stream_ps(dest + i, _mm_loadu_ps(src + i));
+		juce::FloatVectorOperations::copy(dest + i, src + i, numSamples - i);
+		return;
+	}
+#else
+	juce::ignoreUnused(streaming);
+#endif
+	juce::FloatVectorOperations::copy(dest, src, numSamples);
+}
+
+std::shared_ptr<BufferSnapshot> BufferManager::takeSnapshot()
+{
+	TRACE_ZONE("takeSnapshot");
+	//a snapshot of a hibernated history becomes possible once IdleHibernator has brought it back
+	if (isHibernated())
+	{
+		requestRestore();
+		return nullptr;
+	}
+	//readFromSnapshot reads the pool under historyReadLock
+	juce::ScopedLock historyLock(historyReadLock);
 	juce::ScopedLock lock(bufferLock);
-	if (recordBuffer == nullptr || bufferState.isPlaying == false)
+	if (recordBuffer == nullptr || hibernated.load() || activeSnapshots.size() >= maxSnapshots)
+		return nullptr;
+
+	int numSegments = getNumSegments();
+
+	//the pool is allocated here on the message thread, never in writeToBuffer
+	if (snapshotPool.getNumSamples() == 0)
+	{
+		snapshotPool.setSize(recordBuffer->getNumChannels(), numSegments * snapshotSegmentSize);
+		freePoolSlots.clear();
+		freePoolSlots.reserve(numSegments);
+		for (int slot = numSegments - 1; slot >= 0; slot--)
+			freePoolSlots.push_back(slot);
+		poolSlotUsers.assign(numSegments, 0);
+		activeSnapshots.ensureStorageAllocated(maxSnapshots);
+	}
+
+	auto* snapshot = new BufferSnapshot();
+	snapshot->numSamples = recordBuffer->getNumSamples();
+	snapshot->numChannels = recordBuffer->getNumChannels();
+	snapshot->writePosition = bufferState.writePosition;
+	snapshot->samplesWritten = samplesWritten.load();
+	snapshot->segmentSlots = std::make_unique<std::atomic<int>[]>(static_cast<size_t>(numSegments));
+	for (int segment = 0; segment < numSegments; segment++)
+		snapshot->segmentSlots[segment].store(BufferSnapshot::sharedWithRing, std::memory_order_relaxed);
+	activeSnapshots.add(snapshot);
+
+	return std::shared_ptr<BufferSnapshot>(snapshot, [this](BufferSnapshot* s) { releaseSnapshot(s); });
+}
+
+void BufferManager::releaseSnapshot(BufferSnapshot* snapshot)
+{
+	{
+		juce::ScopedLock lock(bufferLock);
+		//a slot goes back to the pool when the last snapshot using it is gone
+		if (snapshot->isValid())
+		{
+			for (int segment = 0; segment < (snapshot->numSamples + snapshotSegmentSize - 1) / snapshotSegmentSize; segment++)
+			{
+				int slot = snapshot->segmentSlots[segment].load(std::memory_order_relaxed);
+				if (slot >= 0 && --poolSlotUsers[static_cast<size_t>(slot)] == 0)
+					freePoolSlots.push_back(slot);
+			}
+		}
+		activeSnapshots.removeFirstMatchingValue(snapshot);
+	}
+	delete snapshot;
+}
+
+void BufferManager::setPlaybackSnapshot(std::shared_ptr<BufferSnapshot> snapshot)
+{
+	//the scratch buffer snapshot playback mixes through is allocated here, never in readFromBuffer
+	juce::AudioBuffer<float> scratch;
+	if (snapshot != nullptr)
+		scratch.setSize(snapshot->getNumChannels(), maximumBlockSize.load());
+
+	std::shared_ptr<BufferSnapshot> previous;
+	{
+		juce::ScopedLock lock(bufferLock);
+		previous = std::move(playbackSnapshot);
+		playbackSnapshot = std::move(snapshot);
+		if (playbackSnapshot != nullptr && (playbackScratch.getNumChannels() < scratch.getNumChannels() || playbackScratch.getNumSamples() < scratch.getNumSamples()))
+			std::swap(playbackScratch, scratch);
+	}
+}
+
+void BufferManager::readFromSnapshot(const BufferSnapshot& snapshot, juce::AudioBuffer<float>& dest, int startSample, int numSamples)
+{
+	TRACE_ZONE("readFromSnapshot");
+	//background readers leave bufferLock to the audio thread, historyReadLock keeps the ring and the pool in place
+	//and copySnapshotRange takes care of segments the write head preserves in the middle of the copy
+	juce::ScopedLock historyLock(historyReadLock);
+	if (recordBuffer == nullptr || !snapshot.isValid())
+	{
+		dest.clear();
 		return;
+	}
+	copySnapshotRange(snapshot, dest, 0, startSample, numSamples);
+}
 
-	juce::AudioBuffer<float> tmpBuffer(buffer.getNumChannels(), buffer.getNumSamples());
-	int numChannels = buffer.getNumChannels();
-	int numSamples = buffer.getNumSamples();
+void BufferManager::preserveSnapshotSegments(int startSample, int numSamples)
+{
+	int ringSamples = recordBuffer->getNumSamples();
+	int position = startSample;
+	int remaining = juce::jmin(numSamples, ringSamples);
+
+	while (remaining > 0)
+	{
+		int segment = position / snapshotSegmentSize;
+		int segmentStart = segment * snapshotSegmentSize;
+		int segmentLength = juce::jmin(snapshotSegmentSize, ringSamples - segmentStart);
+
+		//every snapshot still sharing the segment needs the same old contents, they share one copy
+		int slot = BufferSnapshot::sharedWithRing;
+		for (auto* snapshot : activeSnapshots)
+		{
+			if (snapshot->segmentSlots[segment].load(std::memory_order_relaxed) != BufferSnapshot::sharedWithRing)
+				continue;
+
+			if (slot == BufferSnapshot::sharedWithRing)
+			{
+				if (freePoolSlots.empty())
+					slot = BufferSnapshot::lost;
+				else
+				{
+					slot = freePoolSlots.back();
+					freePoolSlots.pop_back();
+					for (int channel = 0; channel < snapshotPool.getNumChannels(); channel++)
+						snapshotPool.copyFrom(channel, slot * snapshotSegmentSize, *recordBuffer, channel, segmentStart, segmentLength);
+				}
+			}
+
+			snapshot->segmentSlots[segment].store(slot, std::memory_order_release);
+			if (slot >= 0)
+				poolSlotUsers[static_cast<size_t>(slot)]++;
+			else
+				snapshot->numLostSegments++;
+		}
+
+		int chunk = juce::jmin(remaining, segmentStart + segmentLength - position);
+		remaining -= chunk;
+		position = (position + chunk) % ringSamples;
+	}
+}
+
+void BufferManager::copySnapshotRange(const BufferSnapshot& snapshot, juce::AudioBuffer<float>& dest, int destStartSample, int startSample, int numSamples) const
+{
+	int ringSamples = recordBuffer->getNumSamples();
+	int numChannels = juce::jmin(dest.getNumChannels(), recordBuffer->getNumChannels());
+	int position = startSample % ringSamples;
+	int copied = 0;
+
+	while (copied < numSamples)
+	{
+		int segment = position / snapshotSegmentSize;
+		int offsetInSegment = position - segment * snapshotSegmentSize;
+		int segmentLength = juce::jmin(snapshotSegmentSize, ringSamples - segment * snapshotSegmentSize);
+		int chunk = juce::jmin(numSamples - copied, segmentLength - offsetInSegment);
+		int slot = snapshot.segmentSlots[segment].load(std::memory_order_acquire);
+
+		//a segment read from the ring is checked again afterwards, like readHistory: if the write head preserved it
+		//meanwhile (the slot is stored before the ring is overwritten, see publishWriteEnd) the copy comes from the pool
+		for (int pass = 0; pass < 2; pass++)
+		{
+			for (int channel = 0; channel < numChannels; channel++)
+			{
+				if (slot == BufferSnapshot::sharedWithRing)
+					dest.copyFrom(channel, destStartSample + copied, *recordBuffer, channel, position, chunk);
+				else if (slot >= 0)
+					dest.copyFrom(channel, destStartSample + copied, snapshotPool, channel, slot * snapshotSegmentSize + offsetInSegment, chunk);
+				else
+					dest.clear(channel, destStartSample + copied, chunk);
+			}
+			if (slot != BufferSnapshot::sharedWithRing)
+				break;
+			std::atomic_thread_fence(std::memory_order_acquire);
+			slot = snapshot.segmentSlots[segment].load(std::memory_order_acquire);
+			if (slot == BufferSnapshot::sharedWithRing)
+				break;
+		}
+
+		copied += chunk;
+		position = (position + chunk) % ringSamples;
+	}
+}
+
+bool BufferManager::readHistory(juce::int64 startSample, juce::AudioBuffer<float>& dest, int destStartSample, int numSamples)
+{
+	TRACE_ZONE("readHistory");
+	//background readers copy without bufferLock so the audio thread never waits on them,
+	//the copy is only trusted if the write head has not lapped it in the meantime
+	juce::ScopedLock historyLock(historyReadLock);
+	auto* source = getHistorySource(startSample);
+	if (source == nullptr)
+		return false;
+
+	int ringSamples = source->getNumSamples();
+	juce::int64 written = samplesWritten.load(std::memory_order_acquire);
+	if (numSamples > ringSamples || startSample < written - ringSamples || startSample + numSamples > written)
+		return false;
+
+	int numChannels = juce::jmin(dest.getNumChannels(), source->getNumChannels());
+	int position = static_cast<int>(startSample % ringSamples);
+	int firstPart = juce::jmin(numSamples, ringSamples - position);
+	for (int channel = 0; channel < numChannels; channel++)
+	{
+		dest.copyFrom(channel, destStartSample, *source, channel, position, firstPart);
+		if (firstPart < numSamples)
+			dest.copyFrom(channel, destStartSample + firstPart, *source, channel, 0, numSamples - firstPart);
+	}
+
+	return wasNotLapped(startSample, ringSamples);
+}
+
+bool BufferManager::visitHistory(juce::int64 startSample, int numSamples, const std::function<void(const float* const* channels, int numChannels, int numSamples)>& visitor)
+{
+	TRACE_ZONE("visitHistory");
+	//same contract as readHistory, the visitor reads the ring in place and the result says whether it was lapped
+	juce::ScopedLock historyLock(historyReadLock);
+	auto* source = getHistorySource(startSample);
+	if (source == nullptr)
+		return false;
+
+	int ringSamples = source->getNumSamples();
+	juce::int64 written = samplesWritten.load(std::memory_order_acquire);
+	if (numSamples > ringSamples || startSample < written - ringSamples || startSample + numSamples > written)
+		return false;
+
+	int numChannels = source->getNumChannels();
+	const float* channels[32];
+	numChannels = juce::jmin(numChannels, static_cast<int>(std::size(channels)));
+	int position = static_cast<int>(startSample % ringSamples);
+	int firstPart = juce::jmin(numSamples, ringSamples - position);
 
-	if (bufferState.readPosition + numSamples > recordBuffer->getNumSamples())
+	for (int channel = 0; channel < numChannels; channel++)
+		channels[channel] = source->getReadPointer(channel, position);
+	visitor(channels, numChannels, firstPart);
+	if (firstPart < numSamples)
 	{
-		int overlap = bufferState.readPosition + numSamples - recordBuffer->getNumSamples();
 		for (int channel = 0; channel < numChannels; channel++)
+			channels[channel] = source->getReadPointer(channel);
+		visitor(channels, numChannels, numSamples - firstPart);
+	}
+
+	return wasNotLapped(startSample, ringSamples);
+}
+
+void BufferManager::publishWriteEnd(juce::int64 end)
+{
+	//announced before the block is copied, the fence keeps the copy from being seen ahead of it
+	writeEnd.store(end, std::memory_order_relaxed);
+	if (sharedHistory != nullptr)
+		sharedHistory->beginBlock(end);
+	std::atomic_thread_fence(std::memory_order_release);
+}
+
+bool BufferManager::wasNotLapped(juce::int64 startSample, int ringSamples) const
+{
+	//pairs with publishWriteEnd, everything read before the fence is checked against every block begun so far
+	std::atomic_thread_fence(std::memory_order_acquire);
+	return startSample >= writeEnd.load(std::memory_order_relaxed) - ringSamples;
+}
+
+bool BufferManager::setSharedMemoryEnabled(bool shouldShare)
+{
+	TRACE_ZONE("setSharedMemoryEnabled");
+	juce::ScopedLock historyLock(historyReadLock);
+	restoreLocked(nullptr);
+	juce::ScopedLock lock(bufferLock);
+	if (shouldShare == (sharedHistory != nullptr))
+		return true;
+
+	if (!shouldShare)
+	{
+		moveRingToHeap();
+		return true;
+	}
+
+	if (!SharedHistory::isSupported())
+		return false;
+	sharedHistory = std::make_unique<SharedHistory>();
+	//without a ring yet the segment is created by the first setBufferLength
+	return recordBuffer == nullptr || placeRingInSharedMemory(true, ringGeneration.load());
+}
+
+bool BufferManager::placeRingInSharedMemory(bool keepContents, int generation)
+{
+	//both locks are held by the caller
+	int numChannels = bufferParameters.numChannels;
+	int ringSamples = bufferLength * bufferParameters.sampleRate;
+	float* const* planes = sharedHistory->create(numChannels, ringSamples, bufferParameters.sampleRate, generation);
+	if (planes == nullptr)
+	{
+		moveRingToHeap();
+		return false;
+	}
+
+	if (keepContents)
+	{
+		for (int channel = 0; channel < juce::jmin(numChannels, recordBuffer->getNumChannels()); channel++)
+			juce::FloatVectorOperations::copy(planes[channel], recordBuffer->getReadPointer(channel), juce::jmin(ringSamples, recordBuffer->getNumSamples()));
+		sharedHistory->beginBlock(writeEnd.load(std::memory_order_relaxed));
+		sharedHistory->publish(samplesWritten.load(std::memory_order_relaxed));
+	}
+
+	recordBuffer->setDataToReferTo(planes, numChannels, ringSamples);
+	sharedHistory->releasePrevious();
+	return true;
+}
+
+void BufferManager::moveRingToHeap()
+{
+	//copy out of the mapping before it goes away, the ring object itself stays where it is
+	if (recordBuffer != nullptr && sharedHistory != nullptr)
+	{
+		juce::AudioBuffer<float> heapRing(recordBuffer->getNumChannels(), recordBuffer->getNumSamples());
+		for (int channel = 0; channel < heapRing.getNumChannels(); channel++)
+			heapRing.copyFrom(channel, 0, *recordBuffer, channel, 0, heapRing.getNumSamples());
+		*recordBuffer = std::move(heapRing);
+	}
+	sharedHistory.reset();
+}
+
+bool BufferManager::hibernate(const juce::File& file)
+{
+	TRACE_ZONE("hibernate");
+	int numChannels = bufferParameters.numChannels;
+	auto detached = std::make_unique<juce::AudioBuffer<float>>(numChannels, 0);
+	juce::AudioBuffer<float> wake(numChannels, wakeSegmentSeconds * bufferParameters.sampleRate);
+	wake.clear();
+	{
+		//a shared ring has external readers and snapshots point into the ring, both keep it resident;
+		//from here on the audio thread writes into the wake segment and the old ring is spilled at leisure.
+		//Readers are only held up for the swap, the detached ring then belongs to this thread alone
+		juce::ScopedLock historyLock(historyReadLock);
+		juce::ScopedLock lock(bufferLock);
+		if (recordBuffer == nullptr || hibernated.load() || sharedHistory != nullptr || !activeSnapshots.isEmpty()
+			|| playbackSnapshot != nullptr || bufferState.isPlaying || (historyResampler != nullptr && historyResampler->isConverting()))
+			return false;
+		//the wake segment starts out with the newest history, readers just behind the write head never restore
+		juce::int64 written = samplesWritten.load();
+		int ring = recordBuffer->getNumSamples();
+		int wakeSamples = wake.getNumSamples();
+		for (juce::int64 position = juce::jmax<juce::int64>(0, written - juce::jmin(ring, wakeSamples)); position < written;)
 		{
-			tmpBuffer.copyFrom(channel, 0, *recordBuffer, channel, bufferState.readPosition, recordBuffer->getNumSamples() - bufferState.readPosition);
-			tmpBuffer.copyFrom(channel, recordBuffer->getNumSamples() - bufferState.readPosition, *recordBuffer, channel, 0, overlap);
+			int ringPosition = static_cast<int>(position % ring);
+			int wakePosition = static_cast<int>(position % wakeSamples);
+			int chunk = static_cast<int>(juce::jmin<juce::int64>(written - position, ring - ringPosition, wakeSamples - wakePosition));
+			for (int channel = 0; channel < numChannels; channel++)
+				wake.copyFrom(channel, wakePosition, *recordBuffer, channel, ringPosition, chunk);
+			position += chunk;
 		}
-		bufferState.readPosition = overlap;
+		std::swap(recordBuffer, detached);
+		wakeSegment = std::move(wake);
+		hibernatedEnd.store(written, std::memory_order_release);
+		restoreRequested.store(false, std::memory_order_relaxed);
+		hibernated.store(true, std::memory_order_release);
+		spilling = true;
+		spillPublished.reset();
 	}
-	else
+
+	int ring = detached->getNumSamples();
+	std::vector<juce::int64> offsets;
+	offsets.reserve(static_cast<size_t>(ring / spillChunkSamples + 1));
+	file.deleteFile();
+	std::unique_ptr<juce::FileOutputStream> stream(file.createOutputStream(1 << 20));
+	bool spilled = stream != nullptr;
+	for (int chunkStart = 0; chunkStart < ring && spilled; chunkStart += spillChunkSamples)
+	{
+		int numSamples = juce::jmin(spillChunkSamples, ring - chunkStart);
+		bool silent = true;
+		for (int channel = 0; channel < numChannels && silent; channel++)
+		{
+			auto range = juce::FloatVectorOperations::findMinAndMax(detached->getReadPointer(channel, chunkStart), numSamples);
+			silent = range.getStart() == 0.0f && range.getEnd() == 0.0f;
+		}
+		if (silent)
+		{
+			offsets.push_back(-1);
+			continue;
+		}
+
+		offsets.push_back(stream->getPosition());
+		for (int channel = 0; channel < numChannels && spilled; channel++)
+			spilled = stream->write(detached->getReadPointer(channel, chunkStart), static_cast<size_t>(numSamples) * sizeof(float));
+	}
+	if (stream != nullptr)
+	{
+		stream->flush();
+		spilled = spilled && stream->getStatus().wasOk();
+		stream.reset();
+	}
+
+	//published under the lock, a restore waiting in waitForSpill goes on from here
+	juce::ScopedLock historyLock(historyReadLock);
+	spilling = false;
+	spillPublished.signal();
+	if (!hibernated.load())
+	{
+		//the ring was reallocated while spilling, nothing refers to this history any more
+		file.deleteFile();
+		return false;
+	}
+	spillFile = file;
+	spillOffsets = std::move(offsets);
+	if (!spilled)
 	{
+		//the disk is full or unwritable, take the ring back as it is
+		restoreLocked(std::move(detached));
+		return false;
+	}
+	return true;
+}
+
+const juce::AudioBuffer<float>* BufferManager::getHistorySource(juce::int64 startSample)
+{
+	//historyReadLock is held by the caller. While hibernated the audio since waking up is read
+	//from the wake segment; older audio is unavailable until the background restore has run
+	if (isHibernated())
+	{
+		if (startSample >= samplesWritten.load(std::memory_order_acquire) - wakeSegment.getNumSamples())
+			return &wakeSegment;
+		requestRestore();
+		return nullptr;
+	}
+	return recordBuffer.get();
+}
+
+void BufferManager::restoreHistory()
+{
+	juce::ScopedLock historyLock(historyReadLock);
+	restoreLocked(nullptr);
+}
+
+void BufferManager::restoreLocked(std::unique_ptr<juce::AudioBuffer<float>> restored)
+{
+	//historyReadLock is held once by the caller
+	waitForSpill();
+	if (!hibernated.load(std::memory_order_acquire))
+		return;
+	TRACE_ZONE("restoreHistory");
+
+	int ring = getRingSamples();
+	if (restored == nullptr)
+		restored = readSpill(spillFile, spillOffsets, wakeSegment.getNumChannels(), ring);
+
+	{
+		juce::ScopedLock lock(bufferLock);
+		juce::int64 written = samplesWritten.load(std::memory_order_relaxed);
+		copyWakeSegment(wakeSegment, *restored, hibernatedEnd.load(), written);
+		std::swap(recordBuffer, restored);
+		bufferState.writePosition = static_cast<int>(written % ring);
+		hibernated.store(false, std::memory_order_release);
+	}
+
+	discardHibernation();
+}
+
+void BufferManager::waitForSpill()
+{
+	//historyReadLock is held once by the caller and let go while the hibernator thread finishes the spill,
+	//which it publishes under the lock
+	while (spilling)
+	{
+		juce::ScopedUnlock unlock(historyReadLock);
+		spillPublished.wait(-1);
+	}
+}
+
+std::unique_ptr<juce::AudioBuffer<float>> BufferManager::readSpill(const juce::File& file, const std::vector<juce::int64>& offsets, int numChannels, int ringSamples)
+{
+	auto ring = std::make_unique<juce::AudioBuffer<float>>(numChannels, ringSamples);
+	ring->clear();
+
+	//a spill file that went missing only loses the old history, recording carries on
+	std::unique_ptr<juce::FileInputStream> stream(file.createInputStream());
+	for (size_t chunk = 0; stream != nullptr && chunk < offsets.size(); chunk++)
+	{
+		if (offsets[chunk] < 0)
+			continue;
+		int chunkStart = static_cast<int>(chunk) * spillChunkSamples;
+		int numSamples = juce::jmin(spillChunkSamples, ringSamples - chunkStart);
+		stream->setPosition(offsets[chunk]);
+		for (int channel = 0; channel < numChannels; channel++)
+			stream->read(ring->getWritePointer(channel, chunkStart), numSamples * static_cast<int>(sizeof(float)));
+	}
+	return ring;
+}
+
+void BufferManager::copyWakeSegment(const juce::AudioBuffer<float>& wake, juce::AudioBuffer<float>& ring, juce::int64 hibernatedEnd, juce::int64 written)
+{
+	//the audio recorded since waking up, older wake audio the segment could not hold is silence
+	int ringSamples = ring.getNumSamples();
+	int wakeSamples = wake.getNumSamples();
+	int numChannels = juce::jmin(ring.getNumChannels(), wake.getNumChannels());
+	juce::int64 from = juce::jmax(written - wakeSamples, hibernatedEnd);
+	for (juce::int64 position = juce::jmax(hibernatedEnd, written - ringSamples); position < written;)
+	{
+		int ringPosition = static_cast<int>(position % ringSamples);
+		int wakePosition = static_cast<int>(position % wakeSamples);
+		bool kept = position >= from;
+		int chunk = static_cast<int>(juce::jmin<juce::int64>(written - position, ringSamples - ringPosition, kept ? wakeSamples - wakePosition : from - position));
 		for (int channel = 0; channel < numChannels; channel++)
 		{
-			tmpBuffer.copyFrom(channel, 0, *recordBuffer, channel, bufferState.readPosition, numSamples);
+			if (kept)
+				ring.copyFrom(channel, ringPosition, wake, channel, wakePosition, chunk);
+			else
+				ring.clear(channel, ringPosition, chunk);
 		}
-		bufferState.readPosition += numSamples;
+		position += chunk;
 	}
+}
 
-	for (int channel = 0; channel < numChannels; channel++)
+struct BufferManager::DetachedSpill
+{
+	~DetachedSpill() { file.deleteFile(); }
+
+	juce::File file;
+	std::vector<juce::int64> offsets;
+	juce::AudioBuffer<float> wake;
+	juce::int64 hibernatedEnd = 0;
+	juce::int64 written = 0;
+	int ringSamples = 0;
+};
+
+std::function<bool(juce::AudioBuffer<float>&)> BufferManager::detachSpill(juce::int64 startSample, int numSamples)
+{
+	//the spill file and a copy of the wake segment move to the loader, which runs on the conversion thread;
+	//the file is deleted with the last copy of the loader
+	juce::ScopedLock historyLock(historyReadLock);
+	waitForSpill();
+	juce::int64 written = samplesWritten.load();
+	if (!hibernated.load() || startSample < written - getRingSamples() || startSample + numSamples > written)
+		return {};
+
+	auto spill = std::make_shared<DetachedSpill>();
+	spill->file = spillFile;
+	spill->offsets = spillOffsets;
+	spill->ringSamples = getRingSamples();
+	{
+		juce::ScopedLock lock(bufferLock);
+		spill->wake.makeCopyOf(wakeSegment);
+		spill->hibernatedEnd = hibernatedEnd.load();
+		spill->written = samplesWritten.load();
+	}
+	spillFile = juce::File();
+
+	return [spill, startSample, numSamples](juce::AudioBuffer<float>& history)
+		{
+			auto ring = readSpill(spill->file, spill->offsets, spill->wake.getNumChannels(), spill->ringSamples);
+			copyWakeSegment(spill->wake, *ring, spill->hibernatedEnd, spill->written);
+
+			history.setSize(ring->getNumChannels(), numSamples);
+			int position = static_cast<int>(startSample % spill->ringSamples);
+			int firstPart = juce::jmin(numSamples, spill->ringSamples - position);
+			for (int channel = 0; channel < ring->getNumChannels(); channel++)
+			{
+				history.copyFrom(channel, 0, *ring, channel, position, firstPart);
+				if (firstPart < numSamples)
+					history.copyFrom(channel, firstPart, *ring, channel, 0, numSamples - firstPart);
+			}
+			return true;
+		};
+}
+
+void BufferManager::discardHibernation()
+{
+	//both locks are held or hibernated is already cleared, the audio thread no longer touches the wake segment
+	hibernated.store(false, std::memory_order_release);
+	restoreRequested.store(false, std::memory_order_release);
+	if (spillFile != juce::File())
+		spillFile.deleteFile();
+	spillFile = juce::File();
+	spillOffsets.clear();
+	wakeSegment.setSize(0, 0);
+}
+
+void BufferManager::writeWakeSegment(const juce::AudioBuffer<float>& buffer)
+{
+	//the ring is on disk, the block goes into the wake segment as a small ring of its own
+	int wakeSamples = wakeSegment.getNumSamples();
+	int numSamples = buffer.getNumSamples();
+	int numChannels = juce::jmin(buffer.getNumChannels(), wakeSegment.getNumChannels());
+	juce::int64 written = samplesWritten.load(std::memory_order_relaxed);
+	int skipped = juce::jmax(0, numSamples - wakeSamples);
+	publishWriteEnd(written + numSamples);
+
+	for (int done = skipped; done < numSamples;)
 	{
-		buffer.addFrom(channel, 0, tmpBuffer, channel, 0, numSamples, 1.0f);
+		int position = static_cast<int>((written + done) % wakeSamples);
+		int chunk = juce::jmin(numSamples - done, wakeSamples - position);
+		for (int channel = 0; channel < numChannels; channel++)
+			wakeSegment.copyFrom(channel, position, buffer, channel, done, chunk);
+		done += chunk;
 	}
+
+	bufferState.writePosition = static_cast<int>((written + numSamples) % getRingSamples());
+	samplesWritten.store(written + numSamples, std::memory_order_release);
 }
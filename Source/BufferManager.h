@@ -10,6 +10,9 @@
 
 #pragma once
 #include <JuceHeader.h>
+#include "CallbackProfiler.h"
+#include "SharedHistory.h"
+#include "HistoryResampler.h"
 
 struct BufferParameters
 {
@@ -25,27 +28,174 @@ struct BufferState
 	int readPosition = 0;
 };
 
+//==============================================================================
+/**
+	A frozen, copy-on-write view of the ring buffer.
+
+	The ring is split into fixed-size segments. A snapshot initially shares every
+	segment with the live ring; right before the write head overwrites a segment
+	for the first time, BufferManager copies the old contents into a slot of its
+	snapshot pool and redirects the snapshot to that copy. All snapshots still
+	sharing the segment get the same slot, which is reference counted. Once the
+	pool is used up, further overwritten segments are marked as lost instead of
+	allocating.
+*/
+class BufferSnapshot
+{
+public:
+	int getNumSamples() const { return numSamples; }
+	int getNumChannels() const { return numChannels; }
+	int getWritePosition() const { return writePosition; }
+	bool isValid() const { return valid.load(std::memory_order_acquire); }
+	int getNumLostSegments() const { return numLostSegments.load(std::memory_order_relaxed); }
+	juce::int64 getSamplesWritten() const { return samplesWritten; }
+
+private:
+	friend class BufferManager;
+
+	enum SegmentSlot
+	{
+		sharedWithRing = -1,
+		lost = -2
+	};
+
+	int numSamples = 0;
+	int numChannels = 0;
+	int writePosition = 0;
+	juce::int64 samplesWritten = 0;
+	//written by the audio thread under bufferLock, read lock-free by readFromSnapshot
+	std::atomic<int> numLostSegments{ 0 };
+	std::atomic<bool> valid{ true };
+	std::unique_ptr<std::atomic<int>[]> segmentSlots;
+};
+
 class BufferManager
 {
 public:
 	BufferManager();
 	~BufferManager();
 
-	void initializeBuffer(int numChannels, int sampleRate);
+	//length in seconds, the processor passes the one from the settings
+	void initializeBuffer(int numChannels, int sampleRate, int length);
 	void setBufferLength(int length);
 	int getBufferLength() const { return bufferLength; }
 	int getBufferSampleRate() const { return bufferParameters.sampleRate; }
-	juce::AudioBuffer<float>* getBufferPointer() const { return recordBuffer.get(); }
+	int getBufferNumChannels() const { return bufferParameters.numChannels; }
+	//the ring size in samples, also while hibernated and the ring itself is gone; 0 before the first
+	//initializeBuffer. The ring is never handed out, hibernation frees it on another thread
+	int getRingSamples() const { return ringSamples.load(std::memory_order_acquire); }
 
 	void writeToBuffer(const juce::AudioBuffer<float>& buffer);
 	void readFromBuffer(juce::AudioBuffer<float>& buffer);
+	void setProfiler(CallbackProfiler* profilerToUse) { profiler = profilerToUse; }
+	//prepareToPlay, sizes what the audio thread mixes through so it never allocates
+	void setMaximumBlockSize(int numSamples) { maximumBlockSize.store(juce::jmax(1, numSamples)); }
+	//offline bounces write large blocks with streaming stores that bypass the cache
+	void setOfflineMode(bool isOffline) { offlineMode.store(isOffline, std::memory_order_relaxed); }
+
+	std::shared_ptr<BufferSnapshot> takeSnapshot();
+	void readFromSnapshot(const BufferSnapshot& snapshot, juce::AudioBuffer<float>& dest, int startSample, int numSamples);
+	void setPlaybackSnapshot(std::shared_ptr<BufferSnapshot> snapshot);
+	int getNumSnapshots() const { return activeSnapshots.size(); }
+	size_t getSnapshotMemoryUsage() const { return static_cast<size_t>(snapshotPool.getNumChannels()) * snapshotPool.getNumSamples() * sizeof(float); }
+
+	//absolute (never wrapping) sample counter, ring position is samplesWritten % ring size
+	juce::int64 getTotalSamplesWritten() const { return samplesWritten.load(std::memory_order_acquire); }
+	int getRingGeneration() const { return ringGeneration.load(std::memory_order_acquire); }
+	bool readHistory(juce::int64 startSample, juce::AudioBuffer<float>& dest, int destStartSample, int numSamples);
+	//like readHistory, but hands the visitor pointers straight into the ring in at most two contiguous parts
+	bool visitHistory(juce::int64 startSample, int numSamples, const std::function<void(const float* const* channels, int numChannels, int numSamples)>& visitor);
+	//called by HistoryResampler, fills the room left in front of the write head after a sample rate change
+	bool spliceHistory(const juce::AudioBuffer<float>& source, int sourceStart, int numSamples, int generation);
+	//counts splices, history before the write head changed although the generation did not
+	int getHistorySpliceCount() const { return historySplices.load(std::memory_order_acquire); }
+	//process sample clock position = absolute sample + offset, see InstanceRegistry::advanceClock
+	void setClockOffset(juce::int64 offset) { clockOffset.store(offset, std::memory_order_release); }
+	juce::int64 getClockOffset() const { return clockOffset.load(std::memory_order_acquire); }
+
+	//moves the ring into a named shared memory segment for external readers, keeping its contents
+	bool setSharedMemoryEnabled(bool shouldShare);
+	bool isSharedMemoryEnabled() const { return sharedHistory != nullptr; }
+	juce::String getSharedMemoryName() const { return sharedHistory != nullptr ? sharedHistory->getName() : juce::String(); }
+
+	//an idle instance spills its history to a file and frees the ring, new audio goes into a small
+	//wake segment until IdleHibernator restores the history in the background. Readers asking for
+	//older audio meanwhile get nothing and leave a request for the restore
+	bool hibernate(const juce::File& file);
+	void restoreHistory();
+	bool isHibernated() const { return hibernated.load(std::memory_order_acquire); }
+	void requestRestore() { restoreRequested.store(true, std::memory_order_release); }
+	bool isRestoreRequested() const { return restoreRequested.load(std::memory_order_acquire); }
+
+	static constexpr int snapshotSegmentSize = 8192;
+	static constexpr int maxSnapshots = 4;
+	static constexpr int streamingThreshold = 4096;
+	static constexpr int spliceChunkSamples = 8192;
+	static constexpr int spillChunkSamples = 65536;
+	static constexpr int wakeSegmentSeconds = 5;
 
 	BufferState bufferState;
 
 private:
+	void releaseSnapshot(BufferSnapshot* snapshot);
+	void reallocateRing(int length, int reservedSamples);
+	bool placeRingInSharedMemory(bool keepContents, int generation);
+	void writeSegment(int channel, int ringStart, const juce::AudioBuffer<float>& source, int sourceStart, int numSamples, bool streaming);
+	void moveRingToHeap();
+	struct DetachedSpill;
+
+	void restoreLocked(std::unique_ptr<juce::AudioBuffer<float>> restored);
+	void waitForSpill();
+	std::function<bool(juce::AudioBuffer<float>&)> detachSpill(juce::int64 startSample, int numSamples);
+	static std::unique_ptr<juce::AudioBuffer<float>> readSpill(const juce::File& file, const std::vector<juce::int64>& offsets, int numChannels, int ringSamples);
+	static void copyWakeSegment(const juce::AudioBuffer<float>& wake, juce::AudioBuffer<float>& ring, juce::int64 hibernatedEnd, juce::int64 written);
+	const juce::AudioBuffer<float>* getHistorySource(juce::int64 startSample);
+	void discardHibernation();
+	void writeWakeSegment(const juce::AudioBuffer<float>& buffer);
+	void publishWriteEnd(juce::int64 end);
+	bool wasNotLapped(juce::int64 startSample, int ringSamples) const;
+	void preserveSnapshotSegments(int startSample, int numSamples);
+	void copySnapshotRange(const BufferSnapshot& snapshot, juce::AudioBuffer<float>& dest, int destStartSample, int startSample, int numSamples) const;
+	int getNumSegments() const { return (recordBuffer->getNumSamples() + snapshotSegmentSize - 1) / snapshotSegmentSize; }
+
 	int bufferLength = 30;
 	BufferParameters bufferParameters;
 	juce::CriticalSection bufferLock;
+	CallbackProfiler* profiler = nullptr;
+	//guards the ring allocation against background readers, never taken by the audio thread
+	juce::CriticalSection historyReadLock;
+	std::atomic<juce::int64> samplesWritten{ 0 };
+	//end of the block being written, published before its samples are copied into the ring
+	std::atomic<juce::int64> writeEnd{ 0 };
+	std::atomic<bool> restoreRequested{ false };
+	std::atomic<juce::int64> clockOffset{ 0 };
+	std::atomic<bool> offlineMode{ false };
+	juce::AudioBuffer<float> playbackScratch;
+	std::atomic<int> maximumBlockSize{ 4096 };
+	std::atomic<int> ringGeneration{ 0 };
+	std::atomic<int> historySplices{ 0 };
+	std::atomic<int> ringSamples{ 0 };
 	std::unique_ptr<juce::AudioBuffer<float>> recordBuffer;
-};
+	std::unique_ptr<SharedHistory> sharedHistory;
+
+	//snapshot pool, shared by all snapshots and capped at the size of the ring
+	juce::AudioBuffer<float> snapshotPool;
+	std::vector<int> freePoolSlots;
+	//how many snapshots hold each pool slot
+	std::vector<int> poolSlotUsers;
+	juce::Array<BufferSnapshot*> activeSnapshots;
+	std::shared_ptr<BufferSnapshot> playbackSnapshot;
 
+	//hibernation, the spill file holds the ring chunk by chunk with -1 for chunks of digital silence
+	std::atomic<bool> hibernated{ false };
+	std::atomic<juce::int64> hibernatedEnd{ 0 };
+	juce::File spillFile;
+	std::vector<juce::int64> spillOffsets;
+	juce::AudioBuffer<float> wakeSegment;
+	//the spill is written without historyReadLock and published under it, restores wait for that
+	bool spilling = false;
+	juce::WaitableEvent spillPublished{ true };
+
+	//last, so a conversion still running stops before the ring goes away
+	std::unique_ptr<HistoryResampler> historyResampler;
+};
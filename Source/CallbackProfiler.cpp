@@ -0,0 +1,116 @@
+/*
+  ==============================================================================
+
+	CallbackProfiler.cpp
+	Created: 19 Oct 2026 3:28:02pm
+	Author:  Tokamak
+
+  ==============================================================================
+*/
+
+#include "CallbackProfiler.h"
+
+CallbackProfiler::CallbackProfiler()
+{
+	ticksToMicros = 1.0e6 / static_cast<double>(juce::Time::getHighResolutionTicksPerSecond());
+	clear();
+}
+
+void CallbackProfiler::clear()
+{
+	numCallbacks.store(0, std::memory_order_relaxed);
+	numDeadlineMisses.store(0, std::memory_order_relaxed);
+	numLockWaits.store(0, std::memory_order_relaxed);
+	totalTicks.store(0, std::memory_order_relaxed);
+	maxTicks.store(0, std::memory_order_relaxed);
+	lockWaitTicks.store(0, std::memory_order_relaxed);
+	maxLockWaitTicks.store(0, std::memory_order_relaxed);
+	maxLoad.store(0.0, std::memory_order_relaxed);
+	lastMissTime.store(0, std::memory_order_relaxed);
+	for (auto& bin : histogram)
+		bin.store(0, std::memory_order_relaxed);
+}
+
+void CallbackProfiler::addCallback(juce::int64 startTicks, juce::int64 endTicks, int numSamples, double sampleRate)
+{
+	//reset is only requested by readers, the audio thread stays the single writer
+	if (resetRequested.exchange(false, std::memory_order_relaxed))
+		clear();
+
+	juce::int64 ticks = endTicks - startTicks;
+	double micros = ticks * ticksToMicros;
+	int bin = micros < 1.0 ? 0 : juce::jmin(numBins - 1, static_cast<int>(std::log2(micros) * binsPerOctave));
+	histogram[bin].store(histogram[bin].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+	increment(numCallbacks);
+	totalTicks.store(totalTicks.load(std::memory_order_relaxed) + ticks, std::memory_order_relaxed);
+	if (ticks > maxTicks.load(std::memory_order_relaxed))
+		maxTicks.store(ticks, std::memory_order_relaxed);
+
+	if (sampleRate > 0.0 && numSamples > 0)
+	{
+		double load = micros / (numSamples * 1.0e6 / sampleRate);
+		if (load > maxLoad.load(std::memory_order_relaxed))
+			maxLoad.store(load, std::memory_order_relaxed);
+		if (load > 1.0)
+		{
+			increment(numDeadlineMisses);
+			lastMissTime.store(juce::Time::getMillisecondCounter(), std::memory_order_relaxed);
+		}
+	}
+}
+
+void CallbackProfiler::addLockWait(juce::int64 ticks)
+{
+	increment(numLockWaits);
+	lockWaitTicks.store(lockWaitTicks.load(std::memory_order_relaxed) + ticks, std::memory_order_relaxed);
+	if (ticks > maxLockWaitTicks.load(std::memory_order_relaxed))
+		maxLockWaitTicks.store(ticks, std::memory_order_relaxed);
+}
+
+CallbackProfiler::Stats CallbackProfiler::getStats() const
+{
+	Stats stats;
+	stats.numCallbacks = numCallbacks.load(std::memory_order_relaxed);
+	stats.numDeadlineMisses = numDeadlineMisses.load(std::memory_order_relaxed);
+	stats.numLockWaits = numLockWaits.load(std::memory_order_relaxed);
+	stats.maxMicros = maxTicks.load(std::memory_order_relaxed) * ticksToMicros;
+	stats.meanMicros = stats.numCallbacks > 0 ? totalTicks.load(std::memory_order_relaxed) * ticksToMicros / stats.numCallbacks : 0.0;
+	stats.maxLoad = maxLoad.load(std::memory_order_relaxed);
+	stats.lockWaitMicros = lockWaitTicks.load(std::memory_order_relaxed) * ticksToMicros;
+	stats.maxLockWaitMicros = maxLockWaitTicks.load(std::memory_order_relaxed) * ticksToMicros;
+	stats.lastMissTime = lastMissTime.load(std::memory_order_relaxed);
+	for (int bin = 0; bin < numBins; bin++)
+		stats.histogram[bin] = histogram[bin].load(std::memory_order_relaxed);
+	return stats;
+}
+
+juce::String CallbackProfiler::toText() const
+{
+	auto stats = getStats();
+	juce::String text;
+	text << "callbacks: " << juce::String(stats.numCallbacks) << "\n";
+	text << "mean: " << juce::String(stats.meanMicros, 1) << " us, max: " << juce::String(stats.maxMicros, 1) << " us\n";
+	text << "worst load: " << juce::String(stats.maxLoad * 100.0, 1) << "% of the block deadline\n";
+	text << "deadline misses: " << juce::String(stats.numDeadlineMisses);
+	if (stats.numDeadlineMisses > 0)
+		text << " (last " << juce::String((juce::Time::getMillisecondCounter() - stats.lastMissTime) / 1000.0, 1) << " s ago)";
+	text << "\n";
+	text << "lock waits: " << juce::String(stats.numLockWaits) << ", total " << juce::String(stats.lockWaitMicros, 1)
+		<< " us, max " << juce::String(stats.maxLockWaitMicros, 1) << " us\n";
+
+	text << "\nhistogram (us):\n";
+	for (int bin = 0; bin < numBins; bin++)
+	{
+		if (stats.histogram[bin] == 0)
+			continue;
+		text << juce::String(getBinStartMicros(bin), 1).paddedLeft(' ', 9) << " - " << juce::String(getBinStartMicros(bin + 1), 1).paddedLeft(' ', 9)
+			<< ": " << juce::String(stats.histogram[bin]) << "\n";
+	}
+	return text;
+}
+
+bool CallbackProfiler::dumpToFile(const juce::File& file) const
+{
+	return file.replaceWithText(toText());
+}
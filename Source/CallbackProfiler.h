@@ -0,0 +1,103 @@
+/*
+  ==============================================================================
+
+	CallbackProfiler.h
+	Created: 19 Oct 2026 3:28:02pm
+	Author:  Tokamak
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "Tracer.h"
+
+//==============================================================================
+/**
+	Always-on timing of the audio callback. The audio thread is the only writer,
+	it reads the high resolution clock twice per block and bins the duration into
+	a log-spaced histogram. Lock waits cost nothing unless the lock is contended.
+	Readers on other threads take relaxed snapshots of the counters.
+*/
+class CallbackProfiler
+{
+public:
+	struct Stats
+	{
+		juce::uint64 numCallbacks = 0;
+		juce::uint64 numDeadlineMisses = 0;
+		juce::uint64 numLockWaits = 0;
+		double maxMicros = 0.0;
+		double meanMicros = 0.0;
+		double maxLoad = 0.0;	//worst duration / block deadline
+		double lockWaitMicros = 0.0;
+		double maxLockWaitMicros = 0.0;
+		juce::uint32 lastMissTime = 0;
+		std::array<juce::uint32, 64> histogram{};
+	};
+
+	CallbackProfiler();
+
+	//audio thread
+	void addCallback(juce::int64 startTicks, juce::int64 endTicks, int numSamples, double sampleRate);
+	void addLockWait(juce::int64 ticks);
+
+	//any thread
+	Stats getStats() const;
+	void reset() { resetRequested = true; }
+	juce::String toText() const;
+	bool dumpToFile(const juce::File& file) const;
+
+	static constexpr int numBins = 64;
+	static constexpr int binsPerOctave = 4;
+	//lower edge of a bin in microseconds, bin 0 also holds everything below one microsecond
+	static double getBinStartMicros(int bin) { return bin == 0 ? 0.0 : std::exp2(static_cast<double>(bin) / binsPerOctave); }
+
+private:
+	static void increment(std::atomic<juce::uint64>& counter) { counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed); }
+	void clear();
+
+	double ticksToMicros = 0.0;
+
+	std::atomic<bool> resetRequested{ false };
+	std::atomic<juce::uint64> numCallbacks{ 0 };
+	std::atomic<juce::uint64> numDeadlineMisses{ 0 };
+	std::atomic<juce::uint64> numLockWaits{ 0 };
+	std::atomic<juce::int64> totalTicks{ 0 };
+	std::atomic<juce::int64> maxTicks{ 0 };
+	std::atomic<juce::int64> lockWaitTicks{ 0 };
+	std::atomic<juce::int64> maxLockWaitTicks{ 0 };
+	std::atomic<double> maxLoad{ 0.0 };
+	std::atomic<juce::uint32> lastMissTime{ 0 };
+	std::atomic<juce::uint32> histogram[numBins];
+};
+
+//==============================================================================
+/**
+	ScopedLock that reports to a CallbackProfiler how long it had to wait.
+	The uncontended path is a single tryEnter, no clock reads.
+*/
+class TimedScopedLock
+{
+public:
+	TimedScopedLock(const juce::CriticalSection& lockToTake, CallbackProfiler* profilerToUse)
+		: lock(lockToTake)
+	{
+		if (!lock.tryEnter())
+		{
+			auto start = juce::Time::getHighResolutionTicks();
+			lock.enter();
+			auto end = juce::Time::getHighResolutionTicks();
+			if (profilerToUse != nullptr)
+				profilerToUse->addLockWait(end - start);
+			Tracer::getInstance().addEvent("bufferLock wait", start, end);
+		}
+	}
+
+	~TimedScopedLock() { lock.exit(); }
+
+private:
+	const juce::CriticalSection& lock;
+
+	JUCE_DECLARE_NON_COPYABLE(TimedScopedLock)
+};
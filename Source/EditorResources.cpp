@@ -0,0 +1,39 @@
+/*
+  ==============================================================================
+
+	EditorResources.cpp
+	Created: 19 Oct 2026 4:09:32pm
+	Author:  Tokamak
+
+  ==============================================================================
+*/
+
+#include "EditorResources.h"
+
+EditorResources::EditorResources()
+{
+	juce::PropertiesFile::Options options;
+	options.applicationName = "TKRS";
+	options.filenameSuffix = ".settings";
+	options.folderName = (juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory).getFullPathName() + "\\ReSampler").toStdString();
+	options.storageFormat = juce::PropertiesFile::storeAsXML;
+	settings = std::make_unique<juce::PropertiesFile>(options);
+}
+
+void EditorResources::addTimeToFirstFrame(double millis)
+{
+	juce::ScopedLock lock(statsLock);
+	numOpened++;
+	lastMillis = millis;
+	totalMillis += millis;
+	worstMillis = juce::jmax(worstMillis, millis);
+}
+
+juce::String EditorResources::getTimeToFirstFrameText() const
+{
+	juce::ScopedLock lock(statsLock);
+	if (numOpened == 0)
+		return {};
+	return "first frame " + juce::String(lastMillis, 1) + " ms, mean " + juce::String(totalMillis / numOpened, 1)
+		+ " ms, worst " + juce::String(worstMillis, 1) + " ms (" + juce::String(numOpened) + " opened)";
+}
@@ -0,0 +1,41 @@
+/*
+  ==============================================================================
+
+	EditorResources.h
+	Created: 19 Oct 2026 4:09:32pm
+	Author:  Tokamak
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+	What every editor in the process shares, held through a SharedResourcePointer
+	by each processor so it already exists when an editor opens. The settings
+	file is parsed once and all editors read and write the same copy.
+
+	Also collects how long editors take from construction to their first painted
+	frame.
+*/
+class EditorResources
+{
+public:
+	EditorResources();
+
+	juce::PropertiesFile& getSettings() { return *settings; }
+
+	void addTimeToFirstFrame(double millis);
+	juce::String getTimeToFirstFrameText() const;
+
+private:
+	std::unique_ptr<juce::PropertiesFile> settings;
+
+	juce::CriticalSection statsLock;
+	int numOpened = 0;
+	double lastMillis = 0.0;
+	double totalMillis = 0.0;
+	double worstMillis = 0.0;
+};
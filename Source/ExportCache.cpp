@@ -0,0 +1,215 @@
+/*
+  ==============================================================================
+
+	ExportCache.cpp
+	Created: 19 Oct 2026 3:40:51pm
+	Author:  Tokamak
+
+  ==============================================================================
+*/
+
+#include "ExportCache.h"
+#include "Tracer.h"
+
+bool ExportCache::Request::matches(const Request& other) const
+{
+	//an absolute range of one ring generation is the same audio whether it is read live or frozen
+	return absoluteStart == other.absoluteStart && ringStart == other.ringStart
+		&& numSamples == other.numSamples && ringGeneration == other.ringGeneration && sampleRate == other.sampleRate
+		&& format == other.format && folder == other.folder;
+}
+
+ExportCache::ExportCache(BufferManager& manager)
+	: juce::Thread("ReSampler Export Cache"), bufferManager(manager)
+{
+	startThread(juce::Thread::Priority::background);
+}
+
+ExportCache::~ExportCache()
+{
+	stopThread(5000);
+}
+
+void ExportCache::prerender(const Request& request)
+{
+	{
+		juce::ScopedLock lock(requestLock);
+		if (readyFile.existsAsFile() && ready.matches(request))
+			return;
+		pending = std::make_unique<Request>(request);
+		requestCounter++;
+	}
+	notify();
+}
+
+juce::File ExportCache::getOrRender(const Request& request)
+{
+	TRACE_ZONE("getOrRender");
+	if (!isReadable(request))
+		return {};
+
+	{
+		//let a background render of the same request finish, anything else is cancelled
+		juce::ScopedLock lock(requestLock);
+		pending.reset();
+		if (!isRenderingInBackground || !rendering.matches(request))
+			requestCounter++;
+	}
+
+	juce::ScopedLock lock(renderLock);
+	{
+		juce::ScopedLock resultLock(requestLock);
+		if (readyFile.existsAsFile() && ready.matches(request))
+		{
+			readyFile.setLastAccessTime(juce::Time::getCurrentTime());
+			return readyFile;
+		}
+	}
+	return render(request, false);
+}
+
+void ExportCache::run()
+{
+	while (!threadShouldExit())
+	{
+		wait(-1);
+
+		juce::ScopedLock lock(renderLock);
+		std::unique_ptr<Request> request;
+		{
+			juce::ScopedLock requestLocker(requestLock);
+			request = std::move(pending);
+			if (request == nullptr || !isReadable(*request))
+				continue;
+			rendering = *request;
+			isRenderingInBackground = true;
+		}
+
+		TRACE_ZONE("prerender");
+		render(*request, true);
+
+		juce::ScopedLock requestLocker(requestLock);
+		isRenderingInBackground = false;
+		rendering = Request();
+	}
+}
+
+bool ExportCache::isReadable(const Request& request) const
+{
+	if (request.numSamples <= 0 || request.sampleRate <= 0)
+		return false;
+	if (request.snapshot != nullptr)
+		return request.snapshot->isValid();
+
+	//live selections that contain the write head are not one contiguous piece of history
+	return request.ringGeneration == bufferManager.getRingGeneration()
+		&& request.absoluteStart + request.numSamples <= bufferManager.getTotalSamplesWritten();
+}
+
+juce::File ExportCache::render(const Request& request, bool canAbort)
+{
+	int requestId = requestCounter.load();
+	int numChannels = request.snapshot != nullptr ? request.snapshot->getNumChannels() : (bufferManager.getRingSamples() > 0 ? bufferManager.getBufferNumChannels() : 0);
+	if (numChannels == 0)
+		return {};
+
+	audio.setSize(numChannels, request.numSamples, false, false, true);
+	if (request.snapshot != nullptr)
+		bufferManager.readFromSnapshot(*request.snapshot, audio, request.ringStart, request.numSamples);
+	else if (!bufferManager.readHistory(request.absoluteStart, audio, 0, request.numSamples))
+		return {};
+
+	if (!request.folder.exists())
+		request.folder.createDirectory();
+	juce::File file = request.folder.getChildFile("TKRS_" + juce::String::toHexString(static_cast<juce::int64>(hashAudio(audio, request))).paddedLeft('0', 16) + AudioExport::getFileExtension(request.format));
+
+	if (!file.existsAsFile())
+	{
+		//write next to the target and move it in place, a half written file is never handed out
+		juce::File temp = request.folder.getNonexistentChildFile("render", ".tmp", false);
+		if (AudioExport::isFlac(request.format))
+		{
+			//FLAC is encoded in parallel parts in one go, too short to be worth aborting
+			if (!AudioExport::writeFile(audio, 0, request.numSamples, request.sampleRate, request.format, temp))
+			{
+				temp.deleteFile();
+				return {};
+			}
+		}
+		else
+		{
+			std::unique_ptr<juce::FileOutputStream> fileStream(temp.createOutputStream());
+			if (fileStream == nullptr)
+				return {};
+			auto writer = AudioExport::createWriter(request.format, fileStream.get(), request.sampleRate, numChannels);
+			if (writer == nullptr)
+				return {};
+			fileStream.release();
+
+			for (int done = 0; done < request.numSamples; done += chunkSamples)
+			{
+				//a newer selection or a drag makes this render pointless
+				if (canAbort && (threadShouldExit() || requestCounter.load() != requestId))
+				{
+					writer.reset();
+					temp.deleteFile();
+					return {};
+				}
+				writer->writeFromAudioSampleBuffer(audio, done, juce::jmin(chunkSamples, request.numSamples - done));
+			}
+		}
+		if (!temp.moveFileTo(file))
+		{
+			temp.deleteFile();
+			return {};
+		}
+		enforceSizeLimit(request.folder, file);
+	}
+	file.setLastAccessTime(juce::Time::getCurrentTime());
+
+	juce::ScopedLock lock(requestLock);
+	ready = request;
+	ready.snapshot.reset();
+	readyFile = file;
+	return file;
+}
+
+void ExportCache::enforceSizeLimit(const juce::File& folder, const juce::File& keep)
+{
+	auto files = folder.findChildFiles(juce::File::findFiles, false, "TKRS_*");
+	std::sort(files.begin(), files.end(), [](const juce::File& a, const juce::File& b) { return a.getLastAccessTime() < b.getLastAccessTime(); });
+
+	juce::int64 totalBytes = 0;
+	for (auto& file : files)
+		totalBytes += file.getSize();
+
+	for (auto& file : files)
+	{
+		if (totalBytes <= sizeLimit.load())
+			break;
+		if (file == keep)
+			continue;
+		juce::int64 size = file.getSize();
+		if (file.deleteFile())
+			totalBytes -= size;
+	}
+}
+
+juce::uint64 ExportCache::hashAudio(const juce::AudioBuffer<float>& audio, const Request& request)
+{
+	//FNV-1a over the raw sample words, then the format, so a different bit depth gets its own file
+	juce::uint64 hash = 14695981039346656037ull;
+	auto mix = [&hash](juce::uint64 value) { hash = (hash ^ value) * 1099511628211ull; };
+
+	for (int channel = 0; channel < audio.getNumChannels(); channel++)
+	{
+		auto* words = reinterpret_cast<const juce::uint32*>(audio.getReadPointer(channel));
+		for (int i = 0; i < request.numSamples; i++)
+			mix(words[i]);
+	}
+	mix(static_cast<juce::uint64>(request.numSamples));
+	mix(static_cast<juce::uint64>(audio.getNumChannels()));
+	mix(static_cast<juce::uint64>(request.sampleRate));
+	mix(static_cast<juce::uint64>(request.format));
+	return hash;
+}
@@ -0,0 +1,80 @@
+/*
+  ==============================================================================
+
+	ExportCache.h
+	Created: 19 Oct 2026 3:40:51pm
+	Author:  Tokamak
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "BufferManager.h"
+#include "AudioExport.h"
+
+//==============================================================================
+/**
+	Renders the current selection to a file before it is dragged out.
+
+	Files are named after a hash of the audio, the sample rate and the format, so
+	dragging the same audio again hands over the file that already exists. A
+	background thread pre-renders the latest request, the drag itself only waits
+	if that render is still running. The cache folder is trimmed to a size limit,
+	least recently used files first.
+*/
+class ExportCache : private juce::Thread
+{
+public:
+	struct Request
+	{
+		std::shared_ptr<BufferSnapshot> snapshot;	//frozen view, nullptr reads the live history
+		juce::int64 absoluteStart = 0;
+		int ringStart = 0;
+		int numSamples = 0;
+		int ringGeneration = 0;
+		int sampleRate = 0;
+		ExportFormat format = Wav24;
+		juce::File folder;
+
+		bool matches(const Request& other) const;
+	};
+
+	ExportCache(BufferManager& bufferManager);
+	~ExportCache() override;
+
+	//replaces whatever was waiting to be pre-rendered
+	void prerender(const Request& request);
+	//returns the cached file for request, rendering it on the calling thread if needed,
+	//or an invalid file if the range is no longer a contiguous part of the history
+	juce::File getOrRender(const Request& request);
+
+	void setSizeLimit(juce::int64 bytes) { sizeLimit = bytes; }
+
+	static constexpr juce::int64 defaultSizeLimit = static_cast<juce::int64>(2) << 30;
+	static constexpr int chunkSamples = 65536;
+
+private:
+	void run() override;
+	bool isReadable(const Request& request) const;
+	juce::File render(const Request& request, bool canAbort);
+	void enforceSizeLimit(const juce::File& folder, const juce::File& keep);
+	static juce::uint64 hashAudio(const juce::AudioBuffer<float>& audio, const Request& request);
+
+	BufferManager& bufferManager;
+	std::atomic<juce::int64> sizeLimit{ defaultSizeLimit };
+	std::atomic<int> requestCounter{ 0 };
+
+	juce::CriticalSection requestLock;
+	std::unique_ptr<Request> pending;
+	Request rendering;
+	bool isRenderingInBackground = false;
+	Request ready;
+	juce::File readyFile;
+
+	//held for a whole render so a drag waits for the background render instead of repeating it
+	juce::CriticalSection renderLock;
+	juce::AudioBuffer<float> audio;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ExportCache)
+};
@@ -0,0 +1,216 @@
+/*
+  ==============================================================================
+
+	FingerprintIndex.cpp
+	Created: 19 Oct 2026 4:05:05pm
+	Author:  Tokamak
+
+  ==============================================================================
+*/
+
+#include "FingerprintIndex.h"
+#include "Tracer.h"
+#include <unordered_map>
+
+void FingerprintIndex::prepare(int ringSamples, int numChannels, int sampleRate, int hopSize)
+{
+	juce::ScopedLock lock(indexLock);
+	hop = hopSize;
+	ringFrames = ringSamples / hopSize + 1;
+
+	//half the most landmarks a frame can make is plenty for real audio, the oldest go first if not
+	landmarks.assign(static_cast<size_t>(ringFrames) * landmarksPerFrame / 2, Landmark());
+	buckets.assign(static_cast<size_t>(1) << tableBits, -1);
+	frameStarts.assign(static_cast<size_t>(ringFrames), 0);
+	nextSequence = 0;
+	oldestSequence = 0;
+	newestFrame = -1;
+
+	//log spaced bands, so low notes get as many peaks as the top end
+	for (int band = 0; band <= numBands; band++)
+	{
+		float frequency = minimumFrequency * std::pow(maximumFrequency / minimumFrequency, static_cast<float>(band) / numBands);
+		bandEdges[band] = juce::jlimit(1, HistoryAnalyser::numBins - 2, juce::roundToInt(frequency * HistoryAnalyser::fftSize / sampleRate));
+	}
+	for (auto& frame : peakFrames)
+		frame = -1;
+}
+
+juce::uint32 FingerprintIndex::makeHash(int firstBin, int secondBin, int frameDistance)
+{
+	//half a bin of slack on both frequencies, a passage played again is rarely tuned identically
+	return (static_cast<juce::uint32>(firstBin >> 1) & 0x1FF) << 14
+		| (static_cast<juce::uint32>(secondBin >> 1) & 0x1FF) << 5
+		| (static_cast<juce::uint32>(frameDistance) & 0x1F);
+}
+
+void FingerprintIndex::addLandmark(juce::uint32 hash, juce::int64 frame)
+{
+	auto capacity = static_cast<juce::int64>(landmarks.size());
+	if (nextSequence - oldestSequence >= capacity)
+		oldestSequence++;
+
+	size_t bucket = (hash * 2654435761u) >> (32 - tableBits);
+	auto& landmark = landmarks[static_cast<size_t>(nextSequence % capacity)];
+	landmark.hash = hash;
+	landmark.frame = frame;
+	landmark.previous = buckets[bucket];
+	buckets[bucket] = nextSequence++;
+}
+
+void FingerprintIndex::processFrame(const AnalysisFrame& frame)
+{
+	TRACE_ZONE("FingerprintIndex::processFrame");
+	if (landmarks.empty())
+		return;
+
+	//strongest bin per band, if it stands out of its band, normalised for a hann window
+	float normalise = 4.0f / frame.fftSize;
+	juce::int64 frameIndex = frame.startSample / frame.hopSize;
+	int slot = static_cast<int>(frameIndex % (fanWindow + 1));
+	peakFrames[slot] = frameIndex;
+	numPeaks[slot] = 0;
+	for (int band = 0; band < numBands; band++)
+	{
+		int best = bandEdges[band];
+		float sum = 0.0f;
+		for (int bin = bandEdges[band]; bin < juce::jmax(bandEdges[band] + 1, bandEdges[band + 1]); bin++)
+		{
+			sum += frame.magnitudes[bin];
+			if (frame.magnitudes[bin] > frame.magnitudes[best])
+				best = bin;
+		}
+		float mean = sum / juce::jmax(1, bandEdges[band + 1] - bandEdges[band]);
+		float magnitude = frame.magnitudes[best];
+		if (magnitude * normalise > minimumMagnitude && magnitude > 3.0f * mean
+			&& magnitude >= frame.magnitudes[best - 1] && magnitude >= frame.magnitudes[best + 1])
+			peaks[slot][numPeaks[slot]++] = { best, magnitude };
+	}
+
+	juce::ScopedLock lock(indexLock);
+	frameStarts[static_cast<size_t>(frameIndex % ringFrames)] = nextSequence;
+	newestFrame = frameIndex;
+
+	//this frame completes the target zone of the anchor fanWindow frames back, which pairs with the
+	//strongest peaks of the whole zone; every anchor of that frame pairs with the same ones
+	juce::int64 anchorFrame = frameIndex - fanWindow;
+	int anchorSlot = static_cast<int>(anchorFrame % (fanWindow + 1));
+	if (anchorFrame >= 0 && peakFrames[anchorSlot] == anchorFrame && numPeaks[anchorSlot] > 0)
+	{
+		struct Target
+		{
+			int bin = 0;
+			int distance = 0;
+			float magnitude = 0.0f;
+		};
+		Target strongest[fanOut];
+		int numTargets = 0;
+		for (int distance = minimumDistance; distance <= fanWindow; distance++)
+		{
+			int targetSlot = static_cast<int>((anchorFrame + distance) % (fanWindow + 1));
+			if (peakFrames[targetSlot] != anchorFrame + distance)
+				continue;
+			for (int target = 0; target < numPeaks[targetSlot]; target++)
+			{
+				//kept sorted strongest first, a weaker peak than all fanOut kept is dropped
+				Target candidate{ peaks[targetSlot][target].bin, distance, peaks[targetSlot][target].magnitude };
+				int position = numTargets < fanOut ? numTargets++ : fanOut;
+				while (position > 0 && strongest[position - 1].magnitude < candidate.magnitude)
+				{
+					if (position < fanOut)
+						strongest[position] = strongest[position - 1];
+					position--;
+				}
+				if (position < fanOut)
+					strongest[position] = candidate;
+			}
+		}
+
+		for (int anchor = 0; anchor < numPeaks[anchorSlot]; anchor++)
+			for (int target = 0; target < numTargets; target++)
+				addLandmark(makeHash(peaks[anchorSlot][anchor].bin, strongest[target].bin, strongest[target].distance), anchorFrame);
+	}
+
+	//landmarks of audio the ring has overwritten
+	while (oldestSequence < nextSequence && getLandmark(oldestSequence).frame < frameIndex - ringFrames)
+		oldestSequence++;
+}
+
+void FingerprintIndex::findSimilar(juce::int64 start, juce::int64 end, juce::Array<Match>& results) const
+{
+	TRACE_ZONE("findSimilar");
+	juce::ScopedLock lock(indexLock);
+	if (landmarks.empty() || newestFrame < 0)
+		return;
+
+	//frames that lie entirely inside the selection
+	juce::int64 firstFrame = (start + hop - 1) / hop;
+	juce::int64 lastFrame = juce::jmin(newestFrame, (end - HistoryAnalyser::fftSize) / hop);
+	firstFrame = juce::jmax(firstFrame, newestFrame - ringFrames + 2);
+	if (lastFrame <= firstFrame)
+		return;
+
+	//landmarks are stored once the anchor's target zone is complete, so the run starts fanWindow frames later
+	if (firstFrame + fanWindow > newestFrame)
+		return;
+	juce::int64 firstSequence = juce::jmax(oldestSequence, frameStarts[static_cast<size_t>((firstFrame + fanWindow) % ringFrames)]);
+	juce::int64 lastSequence = lastFrame + fanWindow < newestFrame ? frameStarts[static_cast<size_t>((lastFrame + fanWindow + 1) % ringFrames)] : nextSequence;
+
+	//every matching hash votes for the shift between the two first peaks
+	std::unordered_map<juce::int64, int> votes;
+	int numQuery = 0;
+	for (juce::int64 sequence = firstSequence; sequence < lastSequence; sequence++)
+	{
+		const auto& query = getLandmark(sequence);
+		if (query.frame < firstFrame || query.frame > lastFrame)
+			continue;
+		numQuery++;
+
+		size_t bucket = (query.hash * 2654435761u) >> (32 - tableBits);
+		for (juce::int64 other = buckets[bucket]; other >= oldestSequence && other >= 0; other = getLandmark(other).previous)
+		{
+			const auto& candidate = getLandmark(other);
+			if (candidate.hash == query.hash)
+				votes[candidate.frame - query.frame]++;
+		}
+	}
+	if (numQuery == 0)
+		return;
+
+	//shifts that are a peak of their neighbourhood, counted with a frame of timing slack either side
+	juce::int64 lengthFrames = juce::jmax<juce::int64>(1, (end - start) / hop);
+	auto getVotes = [&votes](juce::int64 shift) { auto it = votes.find(shift); return it != votes.end() ? it->second : 0; };
+	juce::Array<std::pair<juce::int64, int>> candidates;
+	for (auto& [shift, count] : votes)
+	{
+		if (std::abs(shift) < lengthFrames || count < getVotes(shift - 1) || count <= getVotes(shift + 1))
+			continue;
+		int total = getVotes(shift - 1) + count + getVotes(shift + 1);
+		if (total >= juce::jmax(minimumVotes, juce::roundToInt(minimumScore * numQuery)))
+			candidates.add({ shift, total });
+	}
+	std::sort(candidates.begin(), candidates.end(), [](const auto& a, const auto& b) { return a.second > b.second; });
+
+	//strongest first, a weaker match overlapping one already taken is the same occurrence
+	juce::Array<juce::int64> taken;
+	for (auto& [shift, total] : candidates)
+	{
+		bool overlaps = false;
+		for (auto other : taken)
+			overlaps = overlaps || std::abs(other - shift) < lengthFrames;
+		if (overlaps)
+			continue;
+		taken.add(shift);
+
+		Match match;
+		match.startSample = start + shift * hop;
+		match.score = juce::jmin(1.0f, static_cast<float>(total) / numQuery);
+		results.add(match);
+	}
+}
+
+int FingerprintIndex::getNumLandmarks() const
+{
+	juce::ScopedLock lock(indexLock);
+	return static_cast<int>(nextSequence - oldestSequence);
+}
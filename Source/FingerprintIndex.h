@@ -0,0 +1,96 @@
+/*
+  ==============================================================================
+
+	FingerprintIndex.h
+	Created: 19 Oct 2026 4:05:05pm
+	Author:  Tokamak
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "HistoryAnalyser.h"
+
+//==============================================================================
+/**
+	Landmark fingerprints of everything in the ring, for finding the other places
+	a passage was played.
+
+	Every frame contributes its strongest spectral peak per band. Each peak, the
+	anchor, is paired with the fanOut strongest peaks of its target zone, the
+	frames minimumDistance to fanWindow ahead of it, so the pairs span a fixed
+	stretch of time instead of piling up on the neighbouring frames. Every pair
+	becomes a hash of both frequencies and their distance in frames, stored
+	with the frame of the anchor once its whole zone has been analysed. A
+	passage played again produces the same hashes shifted by a constant number
+	of frames, so a search looks up the hashes of the selection and votes for
+	shifts instead of correlating audio.
+
+	Landmarks live in a fixed ring in the order they were made, chained per hash
+	bucket from newest to oldest. Evicting is advancing the oldest sequence
+	number, either when the audio was overwritten or when the ring is full.
+*/
+class FingerprintIndex : public AnalysisStage
+{
+public:
+	struct Match
+	{
+		juce::int64 startSample = 0;	//absolute position lined up with the start of the query
+		float score = 0.0f;				//share of the query landmarks found at this shift
+	};
+
+	void prepare(int ringSamples, int numChannels, int sampleRate, int hopSize) override;
+	void processFrame(const AnalysisFrame& frame) override;
+
+	//other occurrences of [start, end), best first, excluding the passage itself
+	void findSimilar(juce::int64 start, juce::int64 end, juce::Array<Match>& results) const;
+	int getNumLandmarks() const;
+
+	static constexpr int numBands = 8;
+	static constexpr float minimumFrequency = 60.0f;
+	static constexpr float maximumFrequency = 6000.0f;
+	static constexpr float minimumMagnitude = 0.001f;	//amplitude of a peak, -60 dBFS
+	static constexpr int minimumDistance = 3;		//first frame of the target zone
+	static constexpr int fanWindow = 24;			//last frame of the target zone
+	static constexpr int fanOut = 4;				//pairs per peak
+	static constexpr int landmarksPerFrame = numBands * fanOut;
+	static constexpr int tableBits = 19;
+	static constexpr int minimumVotes = 6;
+	static constexpr float minimumScore = 0.08f;
+
+private:
+	struct Peak
+	{
+		int bin = 0;
+		float magnitude = 0.0f;
+	};
+
+	struct Landmark
+	{
+		juce::int64 previous = -1;		//older landmark in the same bucket
+		juce::int64 frame = 0;			//frame of the first peak
+		juce::uint32 hash = 0;
+	};
+
+	static juce::uint32 makeHash(int firstBin, int secondBin, int frameDistance);
+	void addLandmark(juce::uint32 hash, juce::int64 frame);
+	const Landmark& getLandmark(juce::int64 sequence) const { return landmarks[static_cast<size_t>(sequence % static_cast<juce::int64>(landmarks.size()))]; }
+
+	mutable juce::CriticalSection indexLock;
+	std::vector<Landmark> landmarks;
+	std::vector<juce::int64> buckets;
+	//first landmark made when each frame arrived (anchors fanWindow frames older), so a time range maps to a run of sequences
+	std::vector<juce::int64> frameStarts;
+	juce::int64 nextSequence = 0;
+	juce::int64 oldestSequence = 0;
+	juce::int64 newestFrame = -1;
+
+	int ringFrames = 0;
+	int hop = 512;
+	int bandEdges[numBands + 1] = {};
+	//peaks of the last frames, an anchor's zone is complete once its last frame is here
+	Peak peaks[fanWindow + 1][numBands];
+	int numPeaks[fanWindow + 1] = {};
+	juce::int64 peakFrames[fanWindow + 1] = {};
+};
@@ -0,0 +1,162 @@
+/*
+  ==============================================================================
+
+	HistoryAnalyser.cpp
+	Created: 19 Oct 2026 3:16:58pm
+	Author:  Tokamak
+
+  ==============================================================================
+*/
+
+#include "HistoryAnalyser.h"
+#include "Tracer.h"
+
+HistoryAnalyser::HistoryAnalyser(BufferManager& manager)
+	: bufferManager(manager)
+{
+	frameSamples.resize(fftSize);
+	fftData.resize(fftSize * 2);
+	analysisThread->addAnalyser(this);
+}
+
+HistoryAnalyser::~HistoryAnalyser()
+{
+	analysisThread->removeAnalyser(this);
+}
+
+void HistoryAnalyser::addStage(AnalysisStage* stage)
+{
+	juce::ScopedLock lock(stageLock);
+	stages.addIfNotAlreadyThere(stage);
+	ringGeneration = -1;
+}
+
+void HistoryAnalyser::reset(bool historySpliced)
+{
+	ringGeneration = bufferManager.getRingGeneration();
+	ringSamples = bufferManager.getRingSamples();
+	readBuffer.setSize(ringSamples > 0 ? bufferManager.getBufferNumChannels() : 0, fftSize);
+
+	//only audio written from now on is analysed, unless converted history was spliced in front of it
+	historySplices = bufferManager.getHistorySpliceCount();
+	catchUpEnd = bufferManager.getTotalSamplesWritten();
+	nextFrameStart = historySpliced ? juce::jmax<juce::int64>(0, catchUpEnd - ringSamples) : catchUpEnd;
+	nextFrameStart -= nextFrameStart % hopSize;
+
+	for (auto* stage : stages)
+		stage->prepare(ringSamples, readBuffer.getNumChannels(), bufferManager.getBufferSampleRate(), hopSize);
+}
+
+int HistoryAnalyser::processPendingFrames(int maxFrames)
+{
+	TRACE_ZONE("processPendingFrames");
+	juce::ScopedLock lock(stageLock);
+	if (stages.isEmpty() || bufferManager.getRingSamples() == 0)
+		return 0;
+
+	if (ringGeneration != bufferManager.getRingGeneration())
+		reset(false);
+	else if (historySplices != bufferManager.getHistorySpliceCount())
+		reset(true);
+	if (ringSamples < fftSize || readBuffer.getNumChannels() == 0)
+		return 0;
+
+	juce::int64 written = bufferManager.getTotalSamplesWritten();
+
+	//fell behind by more than half a ring, skip ahead rather than chase the write head
+	if (written - nextFrameStart > ringSamples / 2 && nextFrameStart >= catchUpEnd)
+	{
+		nextFrameStart = written - ringSamples / 4;
+		nextFrameStart -= nextFrameStart % hopSize;
+	}
+
+	int processed = 0;
+	while (processed < maxFrames && nextFrameStart + fftSize <= written)
+	{
+		if (!bufferManager.readHistory(nextFrameStart, readBuffer, 0, fftSize))
+		{
+			nextFrameStart += hopSize;
+			continue;
+		}
+
+		for (auto* stage : stages)
+			stage->processSamples(nextFrameStart + fftSize - hopSize, readBuffer, fftSize - hopSize, hopSize);
+
+		//mono mix
+		juce::FloatVectorOperations::copy(frameSamples.data(), readBuffer.getReadPointer(0), fftSize);
+		for (int channel = 1; channel < readBuffer.getNumChannels(); channel++)
+			juce::FloatVectorOperations::add(frameSamples.data(), readBuffer.getReadPointer(channel), fftSize);
+		juce::FloatVectorOperations::multiply(frameSamples.data(), 1.0f / readBuffer.getNumChannels(), fftSize);
+		window.multiplyWithWindowingTable(frameSamples.data(), fftSize);
+
+		std::fill(fftData.begin(), fftData.end(), 0.0f);
+		juce::FloatVectorOperations::copy(fftData.data(), frameSamples.data(), fftSize);
+		fft.performFrequencyOnlyForwardTransform(fftData.data(), true);
+
+		AnalysisFrame frame;
+		frame.startSample = nextFrameStart;
+		frame.samples = frameSamples.data();
+		frame.magnitudes = fftData.data();
+		frame.numBins = numBins;
+		frame.fftSize = fftSize;
+		frame.hopSize = hopSize;
+		frame.sampleRate = bufferManager.getBufferSampleRate();
+
+		for (auto* stage : stages)
+			stage->processFrame(frame);
+
+		nextFrameStart += hopSize;
+		processed++;
+	}
+
+	return processed;
+}
+
+//==============================================================================
+AnalysisThread::AnalysisThread()
+	: juce::Thread("ReSampler Analysis")
+{
+}
+
+AnalysisThread::~AnalysisThread()
+{
+	stopThread(2000);
+}
+
+void AnalysisThread::addAnalyser(HistoryAnalyser* analyser)
+{
+	juce::ScopedLock lock(analyserLock);
+	analysers.addIfNotAlreadyThere(analyser);
+	if (!isThreadRunning())
+		startThread(juce::Thread::Priority::low);
+}
+
+void AnalysisThread::removeAnalyser(HistoryAnalyser* analyser)
+{
+	juce::ScopedLock lock(analyserLock);
+	analysers.removeFirstMatchingValue(analyser);
+}
+
+void AnalysisThread::run()
+{
+	while (!threadShouldExit())
+	{
+		{
+			juce::ScopedLock lock(analyserLock);
+			int budget = framesPerTick;
+			int idleAnalysers = 0;
+
+			while (budget > 0 && !analysers.isEmpty() && idleAnalysers < analysers.size())
+			{
+				nextAnalyser = nextAnalyser % analysers.size();
+				int share = juce::jmax(1, framesPerTick / analysers.size());
+				int processed = analysers[nextAnalyser]->processPendingFrames(juce::jmin(share, budget));
+				idleAnalysers = processed == 0 ? idleAnalysers + 1 : 0;
+				budget -= processed;
+				nextAnalyser++;
+			}
+		}
+
+		wait(tickMilliseconds);
+	}
+}
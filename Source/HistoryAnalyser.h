@@ -0,0 +1,117 @@
+/*
+  ==============================================================================
+
+	HistoryAnalyser.h
+	Created: 19 Oct 2026 3:16:58pm
+	Author:  Tokamak
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "BufferManager.h"
+
+class AnalysisThread;
+
+struct AnalysisFrame
+{
+	juce::int64 startSample = 0;	//absolute position of the first sample in the window
+	const float* samples = nullptr;	//mono, windowed
+	const float* magnitudes = nullptr;
+	int numBins = 0;
+	int fftSize = 0;
+	int hopSize = 0;
+	int sampleRate = 44100;
+};
+
+//==============================================================================
+/**
+	A consumer of the spectral frames produced by HistoryAnalyser.
+	Both methods are called on the shared analysis thread only.
+*/
+class AnalysisStage
+{
+public:
+	virtual ~AnalysisStage() = default;
+
+	//called whenever the ring is (re)allocated, before any frame of that ring
+	virtual void prepare(int ringSamples, int numChannels, int sampleRate, int hopSize) = 0;
+	virtual void processFrame(const AnalysisFrame& frame) = 0;
+
+	//the newest hop of each frame, unwindowed and with all channels
+	virtual void processSamples(juce::int64 startSample, const juce::AudioBuffer<float>& buffer, int startInBuffer, int numSamples) {}
+};
+
+//==============================================================================
+/**
+	Follows the write head of one BufferManager, runs one FFT per hop over the
+	newly written audio and hands the frames to its stages. The work itself is
+	done by a single process-wide AnalysisThread, so the cost is bounded by a
+	per-tick frame budget no matter how many instances or editors are open.
+*/
+class HistoryAnalyser
+{
+public:
+	HistoryAnalyser(BufferManager& bufferManager);
+	~HistoryAnalyser();
+
+	void addStage(AnalysisStage* stage);
+
+	static constexpr int fftOrder = 11;
+	static constexpr int fftSize = 1 << fftOrder;
+	static constexpr int hopSize = 512;
+	static constexpr int numBins = fftSize / 2 + 1;
+
+	//returns the number of frames processed, at most maxFrames. Normally driven by the
+	//AnalysisThread, offline tools may call it directly to catch up, calls are serialised by stageLock
+	int processPendingFrames(int maxFrames);
+
+private:
+	friend class AnalysisThread;
+
+	void reset(bool historySpliced);
+
+	BufferManager& bufferManager;
+	juce::Array<AnalysisStage*> stages;
+	juce::CriticalSection stageLock;
+
+	int ringGeneration = -1;
+	int historySplices = 0;
+	int ringSamples = 0;
+	juce::int64 nextFrameStart = 0;
+	//after a splice the history in front of this is analysed without skipping ahead
+	juce::int64 catchUpEnd = 0;
+
+	juce::dsp::FFT fft{ fftOrder };
+	juce::dsp::WindowingFunction<float> window{ fftSize, juce::dsp::WindowingFunction<float>::hann, false };
+	juce::AudioBuffer<float> readBuffer;
+	std::vector<float> frameSamples;
+	std::vector<float> fftData;
+
+	juce::SharedResourcePointer<AnalysisThread> analysisThread;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(HistoryAnalyser)
+};
+
+//==============================================================================
+class AnalysisThread : public juce::Thread
+{
+public:
+	AnalysisThread();
+	~AnalysisThread() override;
+
+	void addAnalyser(HistoryAnalyser* analyser);
+	void removeAnalyser(HistoryAnalyser* analyser);
+
+	//~20 ms per tick, the budget is shared round-robin between all analysers
+	static constexpr int tickMilliseconds = 20;
+	static constexpr int framesPerTick = 64;
+
+private:
+	void run() override;
+
+	juce::CriticalSection analyserLock;
+	juce::Array<HistoryAnalyser*> analysers;
+	int nextAnalyser = 0;
+};
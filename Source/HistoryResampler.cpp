@@ -0,0 +1,148 @@
+/*
+  ==============================================================================
+
+	HistoryResampler.cpp
+	Created: 19 Oct 2026 3:57:19pm
+	Author:  Tokamak
+
+  ==============================================================================
+*/
+
+#include "HistoryResampler.h"
+#include "BufferManager.h"
+#include "Tracer.h"
+
+HistoryResampler::HistoryResampler(BufferManager& manager)
+	: juce::Thread("ReSampler History Resampler"), bufferManager(manager)
+{
+}
+
+HistoryResampler::~HistoryResampler()
+{
+	stopThread(5000);
+}
+
+void HistoryResampler::start(juce::AudioBuffer<float>&& history, double sourceRate, double targetRate, int numTargetSamples, int ringGeneration,
+	std::function<bool(juce::AudioBuffer<float>&)> loadHistory)
+{
+	//the loop checks for exit after every chunk, so this waits for one chunk at most
+	stopThread(5000);
+
+	source = std::move(history);
+	historyLoader = std::move(loadHistory);
+	speedRatio = sourceRate / targetRate;
+	targetSampleRate = targetRate;
+	numTarget = numTargetSamples;
+	generation = ringGeneration;
+	//the interpolator output lags its input, produce that much extra and drop it
+	numDiscarded = static_cast<int>(std::ceil(juce::WindowedSincInterpolator::getBaseLatency() / speedRatio));
+
+	if (numTarget > 0 && (source.getNumSamples() > 0 || historyLoader != nullptr))
+		startThread(juce::Thread::Priority::background);
+}
+
+void HistoryResampler::run()
+{
+	TRACE_ZONE("HistoryResampler::run");
+	if (historyLoader != nullptr)
+	{
+		bool loaded = historyLoader(source);
+		historyLoader = nullptr;
+		if (!loaded || threadShouldExit())
+			return;
+	}
+	converted.setSize(source.getNumChannels(), numDiscarded + numTarget);
+	if (speedRatio > 1.0)
+		lowPassKernel = designLowPass(0.5 / speedRatio);
+	for (int channel = 0; channel < source.getNumChannels(); channel++)
+	{
+		if (!convertChannel(source.getWritePointer(channel), source.getNumSamples(), converted.getWritePointer(channel), converted.getNumSamples()))
+			return;
+	}
+
+	bufferManager.spliceHistory(converted, numDiscarded, numTarget, generation);
+	source.setSize(0, 0);
+	converted.setSize(0, 0);
+	filtered = {};
+}
+
+bool HistoryResampler::convertChannel(float* input, int numInput, float* output, int numOutput)
+{
+	//band-limit in place before going down in rate, the copy is ours
+	if (speedRatio > 1.0 && !lowPass(input, numInput))
+		return false;
+
+	juce::WindowedSincInterpolator interpolator;
+	int used = 0;
+	for (int produced = 0; produced < numOutput;)
+	{
+		if (threadShouldExit())
+			return false;
+		int n = juce::jmin(chunkSamples, numOutput - produced);
+		used += interpolator.process(speedRatio, input + used, output + produced, n, juce::jmax(0, numInput - used), 0);
+		used = juce::jmin(used, numInput);
+		produced += n;
+	}
+	return true;
+}
+
+bool HistoryResampler::lowPass(float* samples, int numSamples)
+{
+	//centred convolution, so the filter adds no delay; outside the history counts as silence
+	int numTaps = static_cast<int>(lowPassKernel.size());
+	int centre = numTaps / 2;
+	filtered.assign(static_cast<size_t>(numSamples), 0.0f);
+	for (int done = 0; done < numSamples; done += chunkSamples)
+	{
+		if (threadShouldExit())
+			return false;
+		int end = juce::jmin(numSamples, done + chunkSamples);
+		for (int tap = 0; tap < numTaps; tap++)
+		{
+			int offset = centre - tap;
+			int first = juce::jmax(done, -offset);
+			int last = juce::jmin(end, numSamples - offset);
+			if (last > first)
+				juce::FloatVectorOperations::addWithMultiply(filtered.data() + first, samples + first + offset, lowPassKernel[static_cast<size_t>(tap)], last - first);
+		}
+	}
+	juce::FloatVectorOperations::copy(samples, filtered.data(), numSamples);
+	return true;
+}
+
+std::vector<float> HistoryResampler::designLowPass(double cutoff)
+{
+	auto besselI0 = [](double x)
+		{
+			double sum = 1.0, term = 1.0;
+			for (int k = 1; k < 50 && term > 1.0e-12 * sum; k++)
+			{
+				term *= (x / (2.0 * k)) * (x / (2.0 * k));
+				sum += term;
+			}
+			return sum;
+		};
+
+	//Kaiser's estimate of the transition width for this length and stop band, the -6 dB point
+	//sits half of it below the new Nyquist frequency so the stop band starts right at it
+	int numTaps = 2 * lowPassHalfTaps + 1;
+	double transition = (stopBandDb - 7.95) / (14.36 * (numTaps - 1));
+	double fc = juce::jmax(0.01, cutoff - 0.5 * transition);
+
+	std::vector<float> kernel(static_cast<size_t>(numTaps));
+	double norm = besselI0(kaiserBeta);
+	double sum = 0.0;
+	for (int i = 0; i < numTaps; i++)
+	{
+		double n = i - lowPassHalfTaps;
+		double sinc = n == 0.0 ? 2.0 * fc : std::sin(2.0 * juce::MathConstants<double>::pi * fc * n) / (juce::MathConstants<double>::pi * n);
+		double ratio = n / lowPassHalfTaps;
+		double window = besselI0(kaiserBeta * std::sqrt(juce::jmax(0.0, 1.0 - ratio * ratio))) / norm;
+		kernel[static_cast<size_t>(i)] = static_cast<float>(sinc * window);
+		sum += sinc * window;
+	}
+	//unity gain at DC
+	for (auto& tap : kernel)
+		tap = static_cast<float>(tap / sum);
+	return kernel;
+}
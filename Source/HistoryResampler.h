@@ -0,0 +1,63 @@
+/*
+  ==============================================================================
+
+	HistoryResampler.h
+	Created: 19 Oct 2026 3:57:19pm
+	Author:  Tokamak
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+class BufferManager;
+
+//==============================================================================
+/**
+	Converts the history recorded before a sample rate change to the new rate.
+	BufferManager hands over a copy of the old ring and keeps recording at the new
+	rate straight away, with room left in front of the write head; once the
+	conversion is finished it is spliced into that room. When the rate goes down
+	the history is first band-limited by a linear phase, Kaiser windowed sinc FIR
+	(over 80 dB stop band) whose cutoff follows the rate ratio; from 48 to 44.1 kHz
+	it is flat to 21 kHz. The conversion itself uses a windowed sinc interpolator.
+*/
+class HistoryResampler : private juce::Thread
+{
+public:
+	HistoryResampler(BufferManager& bufferManager);
+	~HistoryResampler() override;
+
+	//history holds the old audio oldest sample first, the result is numTargetSamples long and
+	//ends where recording at the new rate began. A conversion still running is abandoned.
+	//With loadHistory, history is empty and is filled by it on the conversion thread, from
+	//the spill file of a hibernated instance
+	void start(juce::AudioBuffer<float>&& history, double sourceRate, double targetRate, int numTargetSamples, int ringGeneration,
+		std::function<bool(juce::AudioBuffer<float>&)> loadHistory = nullptr);
+	bool isConverting() const { return isThreadRunning(); }
+
+	static constexpr int chunkSamples = 16384;
+	static constexpr int lowPassHalfTaps = 128;
+	static constexpr double kaiserBeta = 8.6;
+	static constexpr double stopBandDb = 86.0;
+
+private:
+	void run() override;
+	bool convertChannel(float* input, int numInput, float* output, int numOutput);
+	bool lowPass(float* samples, int numSamples);
+	//cutoff in cycles per input sample
+	static std::vector<float> designLowPass(double cutoff);
+
+	BufferManager& bufferManager;
+	std::function<bool(juce::AudioBuffer<float>&)> historyLoader;
+	juce::AudioBuffer<float> source;
+	juce::AudioBuffer<float> converted;
+	double speedRatio = 1.0;
+	double targetSampleRate = 44100.0;
+	std::vector<float> lowPassKernel;
+	std::vector<float> filtered;
+	int numTarget = 0;
+	int numDiscarded = 0;
+	int generation = -1;
+};
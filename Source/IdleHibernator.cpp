@@ -0,0 +1,97 @@
+/*
+  ==============================================================================
+
+	IdleHibernator.cpp
+	Created: 19 Oct 2026 4:17:38pm
+	Author:  Tokamak
+
+  ==============================================================================
+*/
+
+#include "IdleHibernator.h"
+#include "BufferManager.h"
+#include "Tracer.h"
+
+IdleHibernator::IdleHibernator(BufferManager& manager, juce::PropertiesFile& settingsToUse)
+	: juce::Thread("ReSampler Idle Hibernator"), bufferManager(manager), settings(settingsToUse),
+	lastActiveMillis(juce::Time::getMillisecondCounterHiRes())
+{
+	spillFile = juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory).getChildFile("ReSampler").getChildFile("Hibernate")
+		.getChildFile("TKRS_" + juce::Uuid().toString() + ".spill");
+	startThread(juce::Thread::Priority::background);
+}
+
+IdleHibernator::~IdleHibernator()
+{
+	stopThread(10000);
+}
+
+void IdleHibernator::blockProcessed(const juce::AudioBuffer<float>& buffer, int numChannels)
+{
+	float peak = 0.0f;
+	for (int channel = 0; channel < juce::jmin(numChannels, buffer.getNumChannels()); channel++)
+		peak = juce::jmax(peak, buffer.getMagnitude(channel, 0, buffer.getNumSamples()));
+	if (peak > silenceThreshold)
+		lastActiveMillis.store(juce::Time::getMillisecondCounterHiRes(), std::memory_order_relaxed);
+}
+
+void IdleHibernator::setSuspended(bool isSuspended)
+{
+	//the idle time counts from here, without waking a hibernated instance
+	suspendedChangeMillis.store(juce::Time::getMillisecondCounterHiRes());
+	suspended.store(isSuspended);
+}
+
+void IdleHibernator::setBypassed(bool isBypassed)
+{
+	//called every block, only a change restarts the idle time
+	if (bypassed.load(std::memory_order_relaxed) == isBypassed)
+		return;
+	bypassChangeMillis.store(juce::Time::getMillisecondCounterHiRes(), std::memory_order_relaxed);
+	bypassed.store(isBypassed, std::memory_order_relaxed);
+}
+
+void IdleHibernator::holdAwake(bool shouldHold)
+{
+	numHolds.fetch_add(shouldHold ? 1 : -1);
+	notify();
+}
+
+void IdleHibernator::run()
+{
+	//polled, the audio thread must not signal an event; faster while hibernated so waking up is quick
+	while (!threadShouldExit())
+	{
+		wait(bufferManager.isHibernated() ? 50 : 1000);
+		if (threadShouldExit())
+			break;
+
+		//silence keeps going into the wake segment, real audio, an editor or a reader wanting older audio brings the history back
+		if (bufferManager.isHibernated())
+		{
+			if (lastActiveMillis.load(std::memory_order_relaxed) > hibernatedMillis || numHolds.load() > 0 || bufferManager.isRestoreRequested())
+				bufferManager.restoreHistory();
+			continue;
+		}
+
+		int timeoutSeconds = settings.getIntValue("hibernateAfterSeconds", defaultTimeoutSeconds);
+		if (timeoutSeconds <= 0 || numHolds.load() > 0 || bufferManager.getTotalSamplesWritten() == 0)
+			continue;
+		if (suspended.load() || bypassed.load(std::memory_order_relaxed))
+			timeoutSeconds = juce::jmin(timeoutSeconds, suspendedTimeoutSeconds);
+		double now = juce::Time::getMillisecondCounterHiRes();
+		double idleSince = juce::jmax(lastActiveMillis.load(std::memory_order_relaxed), suspendedChangeMillis.load(),
+			bypassChangeMillis.load(std::memory_order_relaxed), retryMillis);
+		if (now - idleSince < timeoutSeconds * 1000.0)
+			continue;
+
+		TRACE_ZONE("IdleHibernator::hibernate");
+		spillFile.getParentDirectory().createDirectory();
+		hibernatedMillis = now;
+		if (bufferManager.hibernate(spillFile))
+			numHibernations++;
+		else
+			//busy (snapshots, a conversion, a full disk), try again after another timeout
+			retryMillis = now;
+	}
+}
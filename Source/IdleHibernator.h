@@ -0,0 +1,67 @@
+/*
+  ==============================================================================
+
+	IdleHibernator.h
+	Created: 19 Oct 2026 4:17:38pm
+	Author:  Tokamak
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+class BufferManager;
+
+//==============================================================================
+/**
+	Frees the ring of instances nobody is listening to. Once an instance has
+	had no audio above the silence threshold for the configured time, or has
+	been suspended or bypassed by the host for a few seconds, the history is
+	spilled to a file and the ring released. The next audio block lands in a
+	small wake segment the BufferManager keeps allocated, and this thread then
+	reads the history back in the background. So does an editor opening or a
+	reader asking for audio older than the wake segment; an open editor holds
+	the instance awake.
+
+	Settings: "hibernateAfterSeconds" (0 turns it off, default 300).
+*/
+class IdleHibernator : public juce::Thread
+{
+public:
+	IdleHibernator(BufferManager& manager, juce::PropertiesFile& settingsToUse);
+	~IdleHibernator() override;
+
+	//audio thread, a block above the threshold counts as activity
+	void blockProcessed(const juce::AudioBuffer<float>& buffer, int numChannels);
+	//releaseResources / prepareToPlay
+	void setSuspended(bool isSuspended);
+	//audio thread, processBlockBypassed / processBlock
+	void setBypassed(bool isBypassed);
+	//editors hold the instance awake while open
+	void holdAwake(bool shouldHold);
+
+	juce::File getSpillFile() const { return spillFile; }
+	int getNumHibernations() const { return numHibernations.load(); }
+
+	void run() override;
+
+	static constexpr float silenceThreshold = 1.0e-5f;
+	static constexpr int defaultTimeoutSeconds = 300;
+	static constexpr int suspendedTimeoutSeconds = 10;
+
+private:
+	BufferManager& bufferManager;
+	juce::PropertiesFile& settings;
+	juce::File spillFile;
+	std::atomic<double> lastActiveMillis;
+	std::atomic<double> suspendedChangeMillis{ 0.0 };
+	std::atomic<bool> suspended{ false };
+	std::atomic<double> bypassChangeMillis{ 0.0 };
+	std::atomic<bool> bypassed{ false };
+	std::atomic<int> numHolds{ 0 };
+	std::atomic<int> numHibernations{ 0 };
+	//only touched by the thread
+	double hibernatedMillis = 0.0;
+	double retryMillis = 0.0;
+};
@@ -0,0 +1,56 @@
+/*
+  ==============================================================================
+
+	InstanceRegistry.cpp
+	Created: 19 Oct 2026 3:46:55pm
+	Author:  Tokamak
+
+  ==============================================================================
+*/
+
+#include "InstanceRegistry.h"
+
+InstanceRegistry& InstanceRegistry::getInstance()
+{
+	static InstanceRegistry registry;
+	return registry;
+}
+
+int InstanceRegistry::add(BufferManager& bufferManager, WaveformPyramid& waveformPyramid)
+{
+	juce::ScopedLock scopedLock(lock);
+	Instance instance;
+	instance.id = nextId++;
+	instance.name = "ReSampler " + juce::String(instance.id);
+	instance.bufferManager = &bufferManager;
+	instance.waveformPyramid = &waveformPyramid;
+	instances.add(instance);
+	return instance.id;
+}
+
+void InstanceRegistry::remove(int id)
+{
+	juce::ScopedLock scopedLock(lock);
+	instances.removeIf([id](const Instance& instance) { return instance.id == id; });
+}
+
+juce::int64 InstanceRegistry::advanceClock(juce::int64 offset, bool continuous, juce::int64 blockStart, int numSamples)
+{
+	//the first instance of a host callback moves the clock, the others find it already there
+	if (!continuous)
+		offset = sampleClock.load(std::memory_order_relaxed) - blockStart;
+	juce::int64 end = offset + blockStart + numSamples;
+	juce::int64 current = sampleClock.load(std::memory_order_relaxed);
+	while (current < end && !sampleClock.compare_exchange_weak(current, end, std::memory_order_relaxed))
+	{
+	}
+	return offset;
+}
+
+void InstanceRegistry::setName(int id, const juce::String& name)
+{
+	juce::ScopedLock scopedLock(lock);
+	for (auto& instance : instances)
+		if (instance.id == id)
+			instance.name = name.isNotEmpty() ? name : "ReSampler " + juce::String(id);
+}
@@ -0,0 +1,61 @@
+/*
+  ==============================================================================
+
+	InstanceRegistry.h
+	Created: 19 Oct 2026 3:46:55pm
+	Author:  Tokamak
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "BufferManager.h"
+#include "WaveformPyramid.h"
+
+//==============================================================================
+/**
+	Process-wide list of the live ReSampler instances, so one editor can browse
+	the history of every track. Entries only point at the instances' own ring
+	and waveform summary, nothing is copied. An instance removes itself before
+	its members are destroyed, and removal waits for readers holding the lock.
+
+	The registry also keeps the process sample clock the tracks are aligned on.
+	Every instance advances it with each block it records and keeps a fixed
+	offset from its own sample counter to the clock while its blocks follow each
+	other; after a gap (not processed, not recording, ring reallocated) the
+	offset is taken from the clock again. Instances processed in the same host
+	callback therefore line up to the sample, one that rejoins may be off by a
+	block but does not drift or jitter.
+*/
+class InstanceRegistry
+{
+public:
+	struct Instance
+	{
+		int id = 0;
+		juce::String name;
+		BufferManager* bufferManager = nullptr;
+		WaveformPyramid* waveformPyramid = nullptr;
+	};
+
+	static InstanceRegistry& getInstance();
+
+	int add(BufferManager& bufferManager, WaveformPyramid& waveformPyramid);
+	void remove(int id);
+	void setName(int id, const juce::String& name);
+
+	//audio thread, after the block was written; returns the instance's clock offset
+	juce::int64 advanceClock(juce::int64 offset, bool continuous, juce::int64 blockStart, int numSamples);
+	juce::int64 getClock() const { return sampleClock.load(std::memory_order_relaxed); }
+
+	//hold the lock while using the pointers in getInstances()
+	juce::CriticalSection& getLock() { return lock; }
+	const juce::Array<Instance>& getInstances() const { return instances; }
+
+private:
+	juce::CriticalSection lock;
+	juce::Array<Instance> instances;
+	int nextId = 1;
+	std::atomic<juce::int64> sampleClock{ 0 };
+};
@@ -0,0 +1,148 @@
+/*
+  ==============================================================================
+
+	OnsetDetector.cpp
+	Created: 19 Oct 2026 3:24:31pm
+	Author:  Tokamak
+
+  ==============================================================================
+*/
+
+#include "OnsetDetector.h"
+
+void OnsetDetector::prepare(int ringSamples, int numChannels, int sampleRate, int hopSize)
+{
+	{
+		juce::ScopedLock lock(onsetLock);
+		onsets.clear();
+	}
+
+	ringLength = ringSamples;
+	rate = sampleRate;
+	previousSpectrum.assign(HistoryAnalyser::numBins, 0.0f);
+	spectrum.assign(HistoryAnalyser::numBins, 0.0f);
+	std::fill(std::begin(fluxValues), std::end(fluxValues), 0.0f);
+	fluxIndex = 0;
+	lastFlux[0] = lastFlux[1] = 0.0f;
+	lastFrameCentre = 0;
+	lastOnset = -1;
+	recent.assign(recentSize, 0.0f);
+	recentEnd = 0;
+}
+
+void OnsetDetector::processSamples(juce::int64 startSample, const juce::AudioBuffer<float>& buffer, int startInBuffer, int numSamples)
+{
+	float scale = 1.0f / juce::jmax(1, buffer.getNumChannels());
+	for (int i = 0; i < numSamples; i++)
+	{
+		float sample = 0.0f;
+		for (int channel = 0; channel < buffer.getNumChannels(); channel++)
+			sample += buffer.getReadPointer(channel)[startInBuffer + i];
+		recent[static_cast<size_t>((startSample + i) % recentSize)] = sample * scale;
+	}
+	recentEnd = startSample + numSamples;
+}
+
+void OnsetDetector::processFrame(const AnalysisFrame& frame)
+{
+	//log-compressed spectrum, normalised for a hann window
+	float normalise = 4.0f / frame.fftSize;
+	float flux = 0.0f;
+	for (int bin = 1; bin < frame.numBins; bin++)
+	{
+		spectrum[bin] = std::log1p(100.0f * frame.magnitudes[bin] * normalise);
+		flux += juce::jmax(0.0f, spectrum[bin] - previousSpectrum[bin]);
+	}
+	flux /= frame.numBins;
+	std::swap(spectrum, previousSpectrum);
+
+	float mean = 0.0f;
+	for (float value : fluxValues)
+		mean += value;
+	mean /= fluxHistory;
+	fluxValues[fluxIndex] = flux;
+	fluxIndex = (fluxIndex + 1) % fluxHistory;
+
+	//the previous frame is an onset if it is a local maximum above the adaptive threshold
+	float candidate = lastFlux[1];
+	bool isPeak = candidate > lastFlux[0] && candidate >= flux && candidate > juce::jmax(minimumFlux, mean * thresholdMultiplier);
+	juce::int64 candidateCentre = lastFrameCentre;
+	lastFlux[0] = lastFlux[1];
+	lastFlux[1] = flux;
+	lastFrameCentre = frame.startSample + frame.fftSize / 2;
+
+	if (!isPeak || candidateCentre == 0)
+		return;
+
+	juce::int64 onset = refineOnset(candidateCentre, frame.hopSize);
+	auto minimumGap = static_cast<juce::int64>(minimumGapSeconds * rate);
+	if (lastOnset >= 0 && onset - lastOnset < minimumGap)
+		return;
+	lastOnset = onset;
+
+	juce::ScopedLock lock(onsetLock);
+	onsets.push_back(onset);
+
+	//keep two rings worth, so a frozen snapshot can still snap to onsets the live ring already lost
+	while (!onsets.empty() && onsets.front() < onset - 2 * static_cast<juce::int64>(ringLength))
+		onsets.pop_front();
+}
+
+juce::int64 OnsetDetector::refineOnset(juce::int64 frameCentre, int hopSize) const
+{
+	juce::int64 from = juce::jmax(recentEnd - recentSize, frameCentre - hopSize);
+	juce::int64 to = juce::jmin(recentEnd, frameCentre + hopSize);
+	if (to <= from)
+		return frameCentre;
+
+	juce::int64 peakPosition = from;
+	float peak = 0.0f;
+	for (juce::int64 position = from; position < to; position++)
+	{
+		float magnitude = std::abs(getRecentSample(position));
+		if (magnitude > peak)
+		{
+			peak = magnitude;
+			peakPosition = position;
+		}
+	}
+
+	//walk back to where the attack rises out of the noise, then to the zero crossing before it
+	juce::int64 attack = peakPosition;
+	while (attack > from && std::abs(getRecentSample(attack - 1)) > peak * 0.1f)
+		attack--;
+	juce::int64 limit = juce::jmax(from, attack - 64);
+	while (attack > limit && getRecentSample(attack - 1) * getRecentSample(attack) > 0.0f)
+		attack--;
+
+	return attack;
+}
+
+juce::int64 OnsetDetector::findNearestOnset(juce::int64 position, juce::int64 maxDistance) const
+{
+	juce::ScopedLock lock(onsetLock);
+	auto next = std::lower_bound(onsets.begin(), onsets.end(), position);
+
+	juce::int64 nearest = -1;
+	if (next != onsets.end())
+		nearest = *next;
+	if (next != onsets.begin() && (nearest < 0 || position - *(next - 1) < nearest - position))
+		nearest = *(next - 1);
+
+	if (nearest < 0 || std::abs(nearest - position) > maxDistance)
+		return -1;
+	return nearest;
+}
+
+void OnsetDetector::getOnsets(juce::int64 start, juce::int64 end, juce::Array<juce::int64>& result) const
+{
+	juce::ScopedLock lock(onsetLock);
+	for (auto it = std::lower_bound(onsets.begin(), onsets.end(), start); it != onsets.end() && *it < end; ++it)
+		result.add(*it);
+}
+
+int OnsetDetector::getNumOnsets() const
+{
+	juce::ScopedLock lock(onsetLock);
+	return static_cast<int>(onsets.size());
+}
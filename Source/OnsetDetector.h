@@ -0,0 +1,62 @@
+/*
+  ==============================================================================
+
+	OnsetDetector.h
+	Created: 19 Oct 2026 3:24:31pm
+	Author:  Tokamak
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "HistoryAnalyser.h"
+#include <deque>
+
+//==============================================================================
+/**
+	Spectral-flux onset detector. Peaks of the flux above an adaptive threshold
+	are refined to the start of the attack in the time domain and appended to a
+	sorted index of absolute sample positions, which only ever grows at the end
+	and is trimmed at the front once the ring has overwritten the audio twice over.
+*/
+class OnsetDetector : public AnalysisStage
+{
+public:
+	void prepare(int ringSamples, int numChannels, int sampleRate, int hopSize) override;
+	void processFrame(const AnalysisFrame& frame) override;
+	void processSamples(juce::int64 startSample, const juce::AudioBuffer<float>& buffer, int startInBuffer, int numSamples) override;
+
+	//binary search, returns -1 if there is no onset within maxDistance of position
+	juce::int64 findNearestOnset(juce::int64 position, juce::int64 maxDistance) const;
+	void getOnsets(juce::int64 start, juce::int64 end, juce::Array<juce::int64>& result) const;
+	int getNumOnsets() const;
+
+	static constexpr int fluxHistory = 16;
+	static constexpr float thresholdMultiplier = 1.5f;
+	static constexpr float minimumFlux = 0.05f;
+	static constexpr double minimumGapSeconds = 0.05;
+
+private:
+	juce::int64 refineOnset(juce::int64 frameCentre, int hopSize) const;
+	float getRecentSample(juce::int64 position) const { return recent[static_cast<size_t>(position % recentSize)]; }
+
+	static constexpr int recentSize = 8192;
+
+	mutable juce::CriticalSection onsetLock;
+	std::deque<juce::int64> onsets;
+
+	int ringLength = 0;
+	int rate = 44100;
+	std::vector<float> previousSpectrum;
+	std::vector<float> spectrum;
+	float fluxValues[fluxHistory] = {};
+	int fluxIndex = 0;
+	float lastFlux[2] = {};
+	juce::int64 lastFrameCentre = 0;
+	juce::int64 lastOnset = -1;
+
+	//unwindowed mono history for the time-domain refinement
+	std::vector<float> recent;
+	juce::int64 recentEnd = 0;
+};
@@ -0,0 +1,301 @@
+/*
+  ==============================================================================
+
+	ParallelFlacEncoder.cpp
+	Created: 19 Oct 2026 4:01:54pm
+	Author:  Tokamak
+
+  ==============================================================================
+*/
+
+#include "ParallelFlacEncoder.h"
+#include "Tracer.h"
+#include <limits>
+
+namespace
+{
+	//CRC-8 (x^8 + x^2 + x + 1) over the frame header and CRC-16 (x^16 + x^15 + x^2 + 1) over the whole frame
+	struct CrcTables
+	{
+		juce::uint8 crc8[256];
+		juce::uint16 crc16[256];
+
+		CrcTables()
+		{
+			for (int i = 0; i < 256; i++)
+			{
+				juce::uint8 c8 = static_cast<juce::uint8>(i);
+				juce::uint16 c16 = static_cast<juce::uint16>(i << 8);
+				for (int bit = 0; bit < 8; bit++)
+				{
+					c8 = static_cast<juce::uint8>((c8 & 0x80) ? (c8 << 1) ^ 0x07 : c8 << 1);
+					c16 = static_cast<juce::uint16>((c16 & 0x8000) ? (c16 << 1) ^ 0x8005 : c16 << 1);
+				}
+				crc8[i] = c8;
+				crc16[i] = c16;
+			}
+		}
+	};
+
+	const CrcTables& getCrcTables()
+	{
+		static const CrcTables tables;
+		return tables;
+	}
+
+	juce::uint8 updateCrc8(juce::uint8 crc, const juce::uint8* data, size_t size)
+	{
+		auto& tables = getCrcTables();
+		for (size_t i = 0; i < size; i++)
+			crc = tables.crc8[crc ^ data[i]];
+		return crc;
+	}
+
+	juce::uint16 updateCrc16(juce::uint16 crc, const juce::uint8* data, size_t size)
+	{
+		auto& tables = getCrcTables();
+		for (size_t i = 0; i < size; i++)
+			crc = static_cast<juce::uint16>((crc << 8) ^ tables.crc16[(crc >> 8) ^ data[i]]);
+		return crc;
+	}
+
+	//frame numbers are coded like UTF-8, extended to 36 bits
+	int getCodedNumberSize(juce::uint8 first)
+	{
+		if ((first & 0x80) == 0x00) return 1;
+		if ((first & 0xE0) == 0xC0) return 2;
+		if ((first & 0xF0) == 0xE0) return 3;
+		if ((first & 0xF8) == 0xF0) return 4;
+		if ((first & 0xFC) == 0xF8) return 5;
+		if ((first & 0xFE) == 0xFC) return 6;
+		if (first == 0xFE) return 7;
+		return 0;
+	}
+
+	int writeCodedNumber(juce::uint64 value, juce::uint8* out)
+	{
+		if (value < 0x80)
+		{
+			out[0] = static_cast<juce::uint8>(value);
+			return 1;
+		}
+
+		int size = value < 0x800 ? 2 : value < 0x10000 ? 3 : value < 0x200000 ? 4 : value < 0x4000000 ? 5 : value < 0x80000000ull ? 6 : 7;
+		for (int i = size - 1; i > 0; i--)
+		{
+			out[i] = static_cast<juce::uint8>(0x80 | (value & 0x3F));
+			value >>= 6;
+		}
+		out[0] = size == 7 ? 0xFE : static_cast<juce::uint8>((0xFF00 >> size) | value);
+		return size;
+	}
+}
+
+bool ParallelFlacEncoder::writeFile(const juce::AudioBuffer<float>& audio, int startSample, int numSamples, double sampleRate, int bitsPerSample, const juce::File& file)
+{
+	TRACE_ZONE("ParallelFlacEncoder::writeFile");
+	int numParts = (numSamples + partSamples - 1) / partSamples;
+	if (numParts < 2 || juce::SystemStats::getNumCpus() < 2)
+		return writeSerial(audio, startSample, numSamples, sampleRate, bitsPerSample, file);
+
+	std::vector<EncodedPart> parts(static_cast<size_t>(numParts));
+	{
+		juce::ThreadPool pool(juce::ThreadPoolOptions().withThreadName("ReSampler FLAC").withNumberOfThreads(juce::jmin(numParts, juce::SystemStats::getNumCpus())));
+		std::atomic<int> remaining{ numParts };
+		juce::WaitableEvent finished;
+		for (int i = 0; i < numParts; i++)
+		{
+			pool.addJob([&, i]
+				{
+					int partStart = i * partSamples;
+					encodePart(audio, startSample, partStart, juce::jmin(partSamples, numSamples - partStart), sampleRate, bitsPerSample, parts[static_cast<size_t>(i)]);
+					if (--remaining == 0)
+						finished.signal();
+				});
+		}
+		finished.wait();
+	}
+
+	//every part has to use the same block size for the frame numbers to add up
+	int minFrameBytes = std::numeric_limits<int>::max();
+	int maxFrameBytes = 0;
+	for (auto& part : parts)
+	{
+		if (!part.ok || part.blockSize != parts.front().blockSize || partSamples % part.blockSize != 0)
+			return writeSerial(audio, startSample, numSamples, sampleRate, bitsPerSample, file);
+		minFrameBytes = juce::jmin(minFrameBytes, part.minFrameBytes);
+		maxFrameBytes = juce::jmax(maxFrameBytes, part.maxFrameBytes);
+	}
+
+	std::unique_ptr<juce::FileOutputStream> stream(file.createOutputStream());
+	if (stream == nullptr)
+		return false;
+	stream->setPosition(0);
+	stream->truncate();
+
+	//"fLaC", then STREAMINFO as the only (last) metadata block
+	juce::uint8 header[4 + 4 + 34] = { 'f', 'L', 'a', 'C', 0x80, 0, 0, 34 };
+	juce::uint8* info = header + 8;
+	auto blockSize = static_cast<juce::uint16>(parts.front().blockSize);
+	info[0] = static_cast<juce::uint8>(blockSize >> 8);
+	info[1] = static_cast<juce::uint8>(blockSize);
+	info[2] = info[0];
+	info[3] = info[1];
+	for (int i = 0; i < 3; i++)
+	{
+		info[4 + i] = static_cast<juce::uint8>(minFrameBytes >> (16 - 8 * i));
+		info[7 + i] = static_cast<juce::uint8>(maxFrameBytes >> (16 - 8 * i));
+	}
+	juce::uint64 packed = (static_cast<juce::uint64>(juce::roundToInt(sampleRate)) << 44)
+		| (static_cast<juce::uint64>(audio.getNumChannels() - 1) << 41)
+		| (static_cast<juce::uint64>(bitsPerSample - 1) << 36)
+		| static_cast<juce::uint64>(numSamples);
+	for (int i = 0; i < 8; i++)
+		info[10 + i] = static_cast<juce::uint8>(packed >> (56 - 8 * i));
+	//bytes 18..33: MD5 left zero, meaning not computed
+
+	bool ok = stream->write(header, sizeof(header));
+	for (auto& part : parts)
+		ok = ok && stream->write(part.frames.getData(), part.frames.getSize());
+	stream->flush();
+	return ok;
+}
+
+void ParallelFlacEncoder::encodePart(const juce::AudioBuffer<float>& audio, int startSample, int partStart, int numSamples, double sampleRate, int bitsPerSample, EncodedPart& part)
+{
+	TRACE_ZONE("encodeFlacPart");
+	juce::MemoryBlock encoded;
+	{
+		juce::FlacAudioFormat flacFormat;
+		auto* stream = new juce::MemoryOutputStream(encoded, false);
+		std::unique_ptr<juce::AudioFormatWriter> writer(flacFormat.createWriterFor(stream, sampleRate,
+			static_cast<unsigned int>(audio.getNumChannels()), bitsPerSample, {}, quality));
+		if (writer == nullptr)
+		{
+			delete stream;
+			return;
+		}
+		writer->writeFromAudioSampleBuffer(audio, startSample + partStart, numSamples);
+	}
+
+	auto* data = static_cast<const juce::uint8*>(encoded.getData());
+	size_t size = encoded.getSize();
+	if (size < 8 || memcmp(data, "fLaC", 4) != 0)
+		return;
+
+	//skip the metadata, picking the block size out of STREAMINFO
+	size_t position = 4;
+	for (bool last = false; !last;)
+	{
+		if (position + 4 > size)
+			return;
+		last = (data[position] & 0x80) != 0;
+		int type = data[position] & 0x7F;
+		size_t length = (static_cast<size_t>(data[position + 1]) << 16) | (static_cast<size_t>(data[position + 2]) << 8) | data[position + 3];
+		if (type == 0 && length >= 4 && position + 8 <= size)
+			part.blockSize = (data[position + 6] << 8) | data[position + 7];
+		position += 4 + length;
+	}
+
+	if (part.blockSize <= 0 || partStart % part.blockSize != 0 || position > size)
+		return;
+	part.ok = renumberFrames(data + position, size - position, partStart / part.blockSize, part);
+}
+
+int ParallelFlacEncoder::getFrameHeaderSize(const juce::uint8* data, size_t size)
+{
+	//sync code with the fixed block size strategy, returns the header size including its CRC-8 or 0
+	if (size < 6 || data[0] != 0xFF || data[1] != 0xF8)
+		return 0;
+
+	int numberSize = getCodedNumberSize(data[4]);
+	if (numberSize == 0)
+		return 0;
+	int blockSizeCode = data[2] >> 4;
+	int sampleRateCode = data[2] & 0x0F;
+	int headerSize = 4 + numberSize + (blockSizeCode == 6 ? 1 : blockSizeCode == 7 ? 2 : 0)
+		+ (sampleRateCode == 12 ? 1 : (sampleRateCode == 13 || sampleRateCode == 14) ? 2 : 0);
+	if (static_cast<size_t>(headerSize) + 1 > size || updateCrc8(0, data, static_cast<size_t>(headerSize)) != data[headerSize])
+		return 0;
+	return headerSize + 1;
+}
+
+bool ParallelFlacEncoder::renumberFrames(const juce::uint8* data, size_t size, juce::int64 firstFrame, EncodedPart& part)
+{
+	part.frames.ensureSize(size + size / 64);
+	part.minFrameBytes = std::numeric_limits<int>::max();
+	part.maxFrameBytes = 0;
+
+	juce::uint8 header[16];
+	size_t written = 0;
+	juce::int64 frameNumber = firstFrame;
+	for (size_t position = 0; position < size; frameNumber++)
+	{
+		int oldHeaderSize = getFrameHeaderSize(data + position, size - position);
+		if (oldHeaderSize == 0)
+			return false;
+
+		//frame length is not stored: the frame ends where its CRC-16 comes out zero and the next header begins
+		size_t end = 0;
+		juce::uint16 crc = updateCrc16(0, data + position, static_cast<size_t>(oldHeaderSize));
+		for (size_t i = position + static_cast<size_t>(oldHeaderSize); i < size; i++)
+		{
+			crc = updateCrc16(crc, data + i, 1);
+			if (crc == 0 && i + 1 >= position + static_cast<size_t>(oldHeaderSize) + 2
+				&& (i + 1 == size || getFrameHeaderSize(data + i + 1, size - i - 1) > 0))
+			{
+				end = i + 1;
+				break;
+			}
+		}
+		if (end == 0)
+			return false;
+
+		//same header with the frame number of the whole stream
+		int numberSize = getCodedNumberSize(data[position + 4]);
+		int extraSize = oldHeaderSize - 1 - 4 - numberSize;
+		memcpy(header, data + position, 4);
+		int headerSize = 4 + writeCodedNumber(static_cast<juce::uint64>(frameNumber), header + 4);
+		memcpy(header + headerSize, data + position + 4 + numberSize, static_cast<size_t>(extraSize));
+		headerSize += extraSize;
+		header[headerSize] = updateCrc8(0, header, static_cast<size_t>(headerSize));
+		headerSize++;
+
+		const juce::uint8* body = data + position + oldHeaderSize;
+		size_t bodySize = end - position - static_cast<size_t>(oldHeaderSize) - 2;
+		juce::uint16 frameCrc = updateCrc16(updateCrc16(0, header, static_cast<size_t>(headerSize)), body, bodySize);
+		juce::uint8 footer[2] = { static_cast<juce::uint8>(frameCrc >> 8), static_cast<juce::uint8>(frameCrc) };
+
+		size_t frameBytes = static_cast<size_t>(headerSize) + bodySize + 2;
+		part.frames.ensureSize(written + frameBytes);
+		auto* out = static_cast<juce::uint8*>(part.frames.getData()) + written;
+		memcpy(out, header, static_cast<size_t>(headerSize));
+		memcpy(out + headerSize, body, bodySize);
+		memcpy(out + headerSize + bodySize, footer, 2);
+		written += frameBytes;
+
+		part.minFrameBytes = juce::jmin(part.minFrameBytes, static_cast<int>(frameBytes));
+		part.maxFrameBytes = juce::jmax(part.maxFrameBytes, static_cast<int>(frameBytes));
+		position = end;
+	}
+
+	part.frames.setSize(written);
+	return written > 0;
+}
+
+bool ParallelFlacEncoder::writeSerial(const juce::AudioBuffer<float>& audio, int startSample, int numSamples, double sampleRate, int bitsPerSample, const juce::File& file)
+{
+	std::unique_ptr<juce::FileOutputStream> stream(file.createOutputStream());
+	if (stream == nullptr)
+		return false;
+	stream->setPosition(0);
+	stream->truncate();
+
+	juce::FlacAudioFormat flacFormat;
+	std::unique_ptr<juce::AudioFormatWriter> writer(flacFormat.createWriterFor(stream.get(), sampleRate,
+		static_cast<unsigned int>(audio.getNumChannels()), bitsPerSample, {}, quality));
+	if (writer == nullptr)
+		return false;
+	stream.release();
+	return writer->writeFromAudioSampleBuffer(audio, startSample, numSamples);
+}
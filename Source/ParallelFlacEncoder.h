@@ -0,0 +1,51 @@
+/*
+  ==============================================================================
+
+	ParallelFlacEncoder.h
+	Created: 19 Oct 2026 4:01:54pm
+	Author:  Tokamak
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+	Encodes a buffer to FLAC on all cores. FLAC frames do not depend on each
+	other, so the audio is cut into parts of whole blocks and every part is
+	encoded by its own libFLAC encoder through FlacAudioFormat. The frames of
+	each part are then renumbered to their place in the whole stream (which
+	changes the frame header, so both CRCs are recomputed) and written in order
+	behind one STREAMINFO block.
+
+	The MD5 signature of the unencoded audio is left unset, which the format
+	allows. Anything unexpected in the encoded parts falls back to a single
+	encoder.
+*/
+class ParallelFlacEncoder
+{
+public:
+	static bool writeFile(const juce::AudioBuffer<float>& audio, int startSample, int numSamples, double sampleRate, int bitsPerSample, const juce::File& file);
+
+	static constexpr int blocksPerPart = 64;
+	static constexpr int expectedBlockSize = 4096;
+	static constexpr int partSamples = blocksPerPart * expectedBlockSize;
+	static constexpr int quality = 5;
+
+private:
+	struct EncodedPart
+	{
+		juce::MemoryBlock frames;
+		int blockSize = 0;
+		int minFrameBytes = 0;
+		int maxFrameBytes = 0;
+		bool ok = false;
+	};
+
+	static void encodePart(const juce::AudioBuffer<float>& audio, int startSample, int partStart, int numSamples, double sampleRate, int bitsPerSample, EncodedPart& part);
+	static bool renumberFrames(const juce::uint8* data, size_t size, juce::int64 firstFrame, EncodedPart& part);
+	static int getFrameHeaderSize(const juce::uint8* data, size_t size);
+	static bool writeSerial(const juce::AudioBuffer<float>& audio, int startSample, int numSamples, double sampleRate, int bitsPerSample, const juce::File& file);
+};
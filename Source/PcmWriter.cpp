@@ -0,0 +1,316 @@
+/*
+  ==============================================================================
+
+	PcmWriter.cpp
+	Created: 19 Oct 2026 4:23:23pm
+	Author:  Tokamak
+
+  ==============================================================================
+*/
+
+#include "PcmWriter.h"
+#include "Tracer.h"
+#include <cstring>
+#if JUCE_INTEL
+ #include <emmintrin.h>
+#endif
+
+namespace
+{
+	//full scale 32-bit would overflow, the largest float below one maps to 2147483520
+	constexpr float belowOne = 0.99999994f;
+	//plain RIFF sizes are 32-bit
+	constexpr juce::int64 maxDataBytes = 0xffffffffLL - 256;
+
+	float getScale(PcmWriter::Encoding encoding)
+	{
+		switch (encoding)
+		{
+		case PcmWriter::Encoding::int16:	return 32767.0f;
+		case PcmWriter::Encoding::int24:	return 8388607.0f;
+		default:							return 2147483648.0f;
+		}
+	}
+
+	//works for float and int channels alike, stereo moves 32-bit lanes without looking at them
+	template <typename T>
+	void interleave(const T* const* channels, int numChannels, int numFrames, T* dest)
+	{
+		static_assert(sizeof(T) == 4, "32-bit samples only");
+		int i = 0;
+#if JUCE_INTEL
+		if (numChannels == 2)
+		{
+			for (; i + 4 <= numFrames; i += 4)
+			{
+				__m128i left = _mm_loadu_si128(reinterpret_cast<const __m128i*>(channels[0] + i));
+				__m128i right = _mm_loadu_si128(reinterpret_cast<const __m128i*>(channels[1] + i));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(dest + 2 * i), _mm_unpacklo_epi32(left, right));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(dest + 2 * i + 4), _mm_unpackhi_epi32(left, right));
+			}
+		}
+#endif
+		if (numChannels == 1)
+		{
+			std::memcpy(dest + i, channels[0] + i, static_cast<size_t>(numFrames - i) * sizeof(T));
+			return;
+		}
+		for (; i < numFrames; i++)
+			for (int channel = 0; channel < numChannels; channel++)
+				dest[i * numChannels + channel] = channels[channel][i];
+	}
+
+	//the values are already in 16-bit range, saturating packs cannot change them
+	void interleave16(const int* const* channels, int numChannels, int numFrames, juce::int16* dest)
+	{
+		int i = 0;
+#if JUCE_INTEL
+		if (numChannels == 2)
+		{
+			for (; i + 8 <= numFrames; i += 8)
+			{
+				__m128i left = _mm_packs_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(channels[0] + i)), _mm_loadu_si128(reinterpret_cast<const __m128i*>(channels[0] + i + 4)));
+				__m128i right = _mm_packs_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(channels[1] + i)), _mm_loadu_si128(reinterpret_cast<const __m128i*>(channels[1] + i + 4)));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(dest + 2 * i), _mm_unpacklo_epi16(left, right));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(dest + 2 * i + 8), _mm_unpackhi_epi16(left, right));
+			}
+		}
+		else if (numChannels == 1)
+		{
+			for (; i + 8 <= numFrames; i += 8)
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i), _mm_packs_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(channels[0] + i)),
+					_mm_loadu_si128(reinterpret_cast<const __m128i*>(channels[0] + i + 4))));
+		}
+#endif
+		for (; i < numFrames; i++)
+			for (int channel = 0; channel < numChannels; channel++)
+				dest[i * numChannels + channel] = static_cast<juce::int16>(channels[channel][i]);
+	}
+
+	//four samples become three little endian words
+	void pack24(const int* samples, int numSamples, char* dest)
+	{
+		int i = 0;
+		for (; i + 4 <= numSamples; i += 4)
+		{
+			auto a = static_cast<juce::uint32>(samples[i]);
+			auto b = static_cast<juce::uint32>(samples[i + 1]);
+			auto c = static_cast<juce::uint32>(samples[i + 2]);
+			auto d = static_cast<juce::uint32>(samples[i + 3]);
+			juce::uint32 words[3] = { juce::ByteOrder::swapIfBigEndian((a & 0xffffffu) | (b << 24)),
+				juce::ByteOrder::swapIfBigEndian(((b >> 8) & 0xffffu) | (c << 16)),
+				juce::ByteOrder::swapIfBigEndian(((c >> 16) & 0xffu) | (d << 8)) };
+			std::memcpy(dest + i * 3, words, sizeof(words));
+		}
+		for (; i < numSamples; i++)
+			juce::ByteOrder::littleEndian24BitToChars(samples[i], dest + i * 3);
+	}
+}
+
+PcmWriter::PcmWriter(juce::OutputStream* stream, double sampleRate, int numChannels, Encoding encodingToUse, bool dither)
+	: juce::AudioFormatWriter(stream, "WAV file", sampleRate, static_cast<unsigned int>(numChannels), static_cast<unsigned int>(getBytesPerSample(encodingToUse) * 8)),
+	encoding(encodingToUse), dithered(dither && encodingToUse != Encoding::float32), frameBytes(numChannels * getBytesPerSample(encodingToUse))
+{
+	//see the class comment, write() gets the float channels untouched
+	usesFloatingPointData = true;
+
+	blockStorage.malloc(blockBytes + blockAlignment);
+	auto address = reinterpret_cast<juce::pointer_sized_uint>(blockStorage.get());
+	block = blockStorage.get() + ((blockAlignment - (address & (blockAlignment - 1))) & (blockAlignment - 1));
+	channelScratch.malloc(static_cast<size_t>(numChannels) * convertFrames);
+	if (encoding == Encoding::int24)
+		interleavedScratch.malloc(static_cast<size_t>(numChannels) * convertFrames);
+	sourceChannels.malloc(static_cast<size_t>(numChannels));
+	quantisedChannels.malloc(static_cast<size_t>(numChannels));
+	silence.calloc(convertFrames);
+
+	writeHeader();
+}
+
+PcmWriter::~PcmWriter()
+{
+	if (output == nullptr)
+		return;
+	writeBlock();
+	//chunks are padded to an even size
+	if ((dataBytes & 1) != 0 && !padded)
+		padded = output->writeByte(0);
+	updateHeader();
+	output->flush();
+}
+
+void PcmWriter::writeHeader()
+{
+	//float needs the extension size and a fact chunk, everything else is plain PCM
+	bool isFloat = encoding == Encoding::float32;
+	fmtBytes = isFloat ? 18 : 16;
+	headerStart = output->getPosition();
+
+	output->write("RIFF", 4);
+	output->writeInt(0);
+	output->write("WAVE", 4);
+	output->write("fmt ", 4);
+	output->writeInt(fmtBytes);
+	output->writeShort(static_cast<short>(isFloat ? 3 : 1));
+	output->writeShort(static_cast<short>(numChannels));
+	output->writeInt(static_cast<int>(sampleRate));
+	output->writeInt(static_cast<int>(sampleRate) * frameBytes);
+	output->writeShort(static_cast<short>(frameBytes));
+	output->writeShort(static_cast<short>(bitsPerSample));
+	if (isFloat)
+	{
+		output->writeShort(0);
+		output->write("fact", 4);
+		output->writeInt(4);
+		output->writeInt(0);
+	}
+	output->write("data", 4);
+	ok = output->writeInt(0);
+}
+
+bool PcmWriter::updateHeader()
+{
+	if (!ok || dataBytes == dataBytesInHeader)
+		return ok;
+
+	//fields after "RIFF" <size> "WAVE" "fmt " <size> and the fmt chunk
+	juce::int64 afterFmt = headerStart + 20 + fmtBytes;
+	bool isFloat = encoding == Encoding::float32;
+	juce::int64 dataSizeField = afterFmt + (isFloat ? 12 : 0) + 4;
+	juce::int64 end = output->getPosition();
+
+	ok = output->setPosition(headerStart + 4) && output->writeInt(static_cast<int>(dataSizeField + 4 - headerStart - 8 + dataBytes + (padded ? 1 : 0)));
+	if (ok && isFloat)
+		ok = output->setPosition(afterFmt + 8) && output->writeInt(static_cast<int>(dataBytes / frameBytes));
+	ok = ok && output->setPosition(dataSizeField) && output->writeInt(static_cast<int>(dataBytes));
+	ok = output->setPosition(end) && ok;
+	if (ok)
+		dataBytesInHeader = dataBytes;
+	return ok;
+}
+
+bool PcmWriter::writeBlock()
+{
+	if (blockFill > 0)
+		ok = output->write(block, blockFill) && ok;
+	blockFill = 0;
+	return ok;
+}
+
+bool PcmWriter::flush()
+{
+	writeBlock();
+	updateHeader();
+	output->flush();
+	return ok;
+}
+
+bool PcmWriter::write(const int** samplesToWrite, int numSamples)
+{
+	TRACE_ZONE("PcmWriter::write");
+	if (!ok || numSamples <= 0)
+		return ok;
+	if (dataBytes + static_cast<juce::int64>(numSamples) * frameBytes > maxDataBytes)
+	{
+		jassertfalse;
+		return false;
+	}
+
+	auto channels = reinterpret_cast<const float* const*>(samplesToWrite);
+	for (int done = 0; done < numSamples;)
+	{
+		int room = static_cast<int>((blockBytes - blockFill) / static_cast<size_t>(frameBytes));
+		if (room == 0)
+		{
+			if (!writeBlock())
+				return false;
+			continue;
+		}
+		int numFrames = juce::jmin(numSamples - done, convertFrames, room);
+		convert(channels, done, numFrames, block + blockFill);
+		blockFill += static_cast<size_t>(numFrames) * frameBytes;
+		done += numFrames;
+	}
+	dataBytes += static_cast<juce::int64>(numSamples) * frameBytes;
+	return true;
+}
+
+void PcmWriter::convert(const float* const* channels, int startFrame, int numFrames, char* dest)
+{
+	int channelCount = static_cast<int>(numChannels);
+	for (int channel = 0; channel < channelCount; channel++)
+		sourceChannels[channel] = channels[channel] != nullptr ? channels[channel] + startFrame : silence.get();
+
+	if (encoding == Encoding::float32)
+	{
+		interleave(sourceChannels.get(), channelCount, numFrames, reinterpret_cast<float*>(dest));
+		return;
+	}
+
+	for (int channel = 0; channel < channelCount; channel++)
+	{
+		int* quantised = channelScratch.get() + channel * convertFrames;
+		quantise(sourceChannels[channel], numFrames, quantised);
+		quantisedChannels[channel] = quantised;
+	}
+
+	if (encoding == Encoding::int16)
+		interleave16(quantisedChannels.get(), channelCount, numFrames, reinterpret_cast<juce::int16*>(dest));
+	else if (encoding == Encoding::int32)
+		interleave(quantisedChannels.get(), channelCount, numFrames, reinterpret_cast<int*>(dest));
+	else
+	{
+		interleave(quantisedChannels.get(), channelCount, numFrames, interleavedScratch.get());
+		pack24(interleavedScratch.get(), numFrames * channelCount, dest);
+	}
+}
+
+void PcmWriter::quantise(const float* source, int numSamples, int* dest)
+{
+	//TPDF dither is the difference of two uniform values, one step of the target format wide each
+	float scale = getScale(encoding);
+	float top = encoding == Encoding::int32 ? belowOne : 1.0f;
+	float step = 1.0f / scale;
+	int i = 0;
+#if JUCE_INTEL
+	//four xorshift32 generators side by side, the top 23 bits make a float in [1, 2)
+	__m128i state = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ditherState));
+	const __m128i oneBits = _mm_set1_epi32(0x3f800000);
+	const __m128 one = _mm_set1_ps(1.0f);
+	auto uniform = [&]
+		{
+			state = _mm_xor_si128(state, _mm_slli_epi32(state, 13));
+			state = _mm_xor_si128(state, _mm_srli_epi32(state, 17));
+			state = _mm_xor_si128(state, _mm_slli_epi32(state, 5));
+			return _mm_sub_ps(_mm_castsi128_ps(_mm_or_si128(_mm_srli_epi32(state, 9), oneBits)), one);
+		};
+	const __m128 scaleVector = _mm_set1_ps(scale);
+	const __m128 stepVector = _mm_set1_ps(step);
+	const __m128 bottomVector = _mm_set1_ps(-1.0f);
+	const __m128 topVector = _mm_set1_ps(top);
+	for (; i + 4 <= numSamples; i += 4)
+	{
+		__m128 value = _mm_loadu_ps(source + i);
+		if (dithered)
+			value = _mm_add_ps(value, _mm_mul_ps(_mm_sub_ps(uniform(), uniform()), stepVector));
+		value = _mm_min_ps(_mm_max_ps(value, bottomVector), topVector);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i), _mm_cvtps_epi32(_mm_mul_ps(value, scaleVector)));
+	}
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(ditherState), state);
+#endif
+	auto& scalarState = ditherState[0];
+	auto scalarUniform = [&scalarState]
+		{
+			scalarState ^= scalarState << 13;
+			scalarState ^= scalarState >> 17;
+			scalarState ^= scalarState << 5;
+			return static_cast<float>(scalarState >> 8) * (1.0f / 16777216.0f);
+		};
+	for (; i < numSamples; i++)
+	{
+		float value = source[i];
+		if (dithered)
+			value += (scalarUniform() - scalarUniform()) * step;
+		dest[i] = juce::roundToInt(juce::jlimit(-1.0f, top, value) * scale);
+	}
+}
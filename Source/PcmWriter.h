@@ -0,0 +1,78 @@
+/*
+  ==============================================================================
+
+	PcmWriter.h
+	Created: 19 Oct 2026 4:23:23pm
+	Author:  Tokamak
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+	A WAV writer for long exports. Blocks of frames are converted to 16, 24 or
+	32-bit integers (or kept as float) and interleaved with SSE2, optionally with
+	TPDF dither, straight into a large page-aligned block that goes to the stream
+	in one write once it is full; the header sizes are filled in on flush and in
+	the destructor.
+
+	write() is always handed float channels: the writer sets usesFloatingPointData,
+	so writeFromAudioSampleBuffer and writeFromFloatArrays pass the float data
+	through instead of converting it to int sample by sample first.
+*/
+class PcmWriter : public juce::AudioFormatWriter
+{
+public:
+	enum class Encoding
+	{
+		int16,
+		int24,
+		int32,
+		float32
+	};
+
+	//takes ownership of the stream like the writers of juce::AudioFormat
+	PcmWriter(juce::OutputStream* stream, double sampleRate, int numChannels, Encoding encoding, bool dither);
+	~PcmWriter() override;
+
+	bool write(const int** samplesToWrite, int numSamples) override;
+	bool flush() override;
+
+	static int getBytesPerSample(Encoding encoding) { return encoding == Encoding::int16 ? 2 : (encoding == Encoding::int24 ? 3 : 4); }
+
+	static constexpr size_t blockBytes = 1 << 20;
+	static constexpr size_t blockAlignment = 4096;
+	static constexpr int convertFrames = 2048;
+
+private:
+	void writeHeader();
+	bool writeBlock();
+	bool updateHeader();
+	void convert(const float* const* channels, int startFrame, int numFrames, char* dest);
+	void quantise(const float* source, int numSamples, int* dest);
+
+	Encoding encoding;
+	bool dithered;
+	int frameBytes;
+	bool ok = true;
+
+	//header fields are patched in place, relative to where the stream was when the writer was made
+	juce::int64 headerStart = 0;
+	int fmtBytes = 16;
+	juce::int64 dataBytes = 0;
+	juce::int64 dataBytesInHeader = -1;
+	bool padded = false;
+
+	juce::HeapBlock<char> blockStorage;
+	char* block = nullptr;
+	size_t blockFill = 0;
+	juce::HeapBlock<int> channelScratch;
+	juce::HeapBlock<int> interleavedScratch;
+	juce::HeapBlock<const float*> sourceChannels;
+	juce::HeapBlock<const int*> quantisedChannels;
+	juce::HeapBlock<float> silence;
+	juce::uint32 ditherState[4] = { 0x9e3779b9u, 0x7f4a7c15u, 0x85ebca6bu, 0xc2b2ae35u };
+};
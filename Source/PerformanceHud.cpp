@@ -0,0 +1,106 @@
+/*
+  ==============================================================================
+
+	PerformanceHud.cpp
+	Created: 19 Oct 2026 3:31:15pm
+	Author:  Tokamak
+
+  ==============================================================================
+*/
+
+#include "PerformanceHud.h"
+
+PerformanceHud::PerformanceHud()
+{
+	ticksToMillis = 1000.0 / static_cast<double>(juce::Time::getHighResolutionTicksPerSecond());
+}
+
+void PerformanceHud::Rolling::add(float value)
+{
+	values[index] = value;
+	index = (index + 1) % size;
+	count = juce::jmin(count + 1, size);
+}
+
+float PerformanceHud::Rolling::getMean() const
+{
+	float sum = 0.0f;
+	for (int i = 0; i < count; i++)
+		sum += values[i];
+	return count > 0 ? sum / count : 0.0f;
+}
+
+float PerformanceHud::Rolling::getMax() const
+{
+	float maximum = 0.0f;
+	for (int i = 0; i < count; i++)
+		maximum = juce::jmax(maximum, values[i]);
+	return maximum;
+}
+
+void PerformanceHud::frameStarted()
+{
+	frameStart = juce::Time::getHighResolutionTicks();
+	if (lastFrameStart != 0)
+		frameInterval.add(static_cast<float>((frameStart - lastFrameStart) * ticksToMillis));
+	lastFrameStart = frameStart;
+
+	//repaints per second, counted over one second windows
+	juce::uint32 now = juce::Time::getMillisecondCounter();
+	framesInWindow++;
+	if (now - windowStart >= 1000)
+	{
+		repaintRate = framesInWindow * 1000.0f / (now - windowStart);
+		framesInWindow = 0;
+		windowStart = now;
+	}
+}
+
+void PerformanceHud::frameFinished()
+{
+	paintTime.add(static_cast<float>((juce::Time::getHighResolutionTicks() - frameStart) * ticksToMillis));
+}
+
+const char* PerformanceHud::getPhaseName(Phase phase)
+{
+	switch (phase)
+	{
+	case ThemeSetup:
+		return "theme";
+	case WaveformDraw:
+		return "waveform";
+	case Overlays:
+		return "overlays";
+	case TileUpdate:
+		return "tile update";
+	default:
+		return "";
+	}
+}
+
+juce::String PerformanceHud::formatBytes(size_t bytes)
+{
+	if (bytes >= 1024 * 1024)
+		return juce::String(bytes / (1024.0 * 1024.0), 1) + " MB";
+	return juce::String(bytes / 1024.0, 1) + " KB";
+}
+
+void PerformanceHud::draw(juce::Graphics& g, juce::Rectangle<int> area, juce::Colour colour, const juce::StringArray& extraLines) const
+{
+	juce::StringArray lines;
+	lines.add("frame " + juce::String(frameInterval.getMean(), 1) + " ms (max " + juce::String(frameInterval.getMax(), 1) + "), "
+		+ juce::String(repaintRate, 1) + " fps");
+	lines.add("paint " + juce::String(paintTime.getMean(), 2) + " ms (max " + juce::String(paintTime.getMax(), 2) + ")");
+	for (int phase = 0; phase < numPhases; phase++)
+		lines.add("  " + juce::String(getPhaseName(static_cast<Phase>(phase))) + " " + juce::String(phases[phase].getMean(), 2) + " ms");
+	lines.addArray(extraLines);
+
+	const int lineHeight = 12;
+	auto box = area.withSize(220, lineHeight * lines.size() + 6);
+	g.setColour(juce::Colours::black.withAlpha(0.6f));
+	g.fillRect(box);
+	g.setColour(colour);
+	g.setFont(11.0f);
+	for (int i = 0; i < lines.size(); i++)
+		g.drawText(lines[i], box.getX() + 4, box.getY() + 3 + i * lineHeight, box.getWidth() - 8, lineHeight, juce::Justification::centredLeft);
+}
@@ -0,0 +1,66 @@
+/*
+  ==============================================================================
+
+	PerformanceHud.h
+	Created: 19 Oct 2026 3:31:15pm
+	Author:  Tokamak
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+	Rolling frame statistics for the editor overlay. Phases are timed with the
+	high resolution clock only while the HUD is visible, drawing it is a handful
+	of text lines.
+*/
+class PerformanceHud
+{
+public:
+	enum Phase
+	{
+		ThemeSetup,
+		WaveformDraw,
+		Overlays,
+		TileUpdate,
+		numPhases
+	};
+
+	PerformanceHud();
+
+	void frameStarted();
+	void frameFinished();
+	void addPhase(Phase phase, juce::int64 ticks) { phases[phase].add(static_cast<float>(ticks * ticksToMillis)); }
+	void draw(juce::Graphics& g, juce::Rectangle<int> area, juce::Colour colour, const juce::StringArray& extraLines) const;
+
+	static juce::String formatBytes(size_t bytes);
+
+private:
+	struct Rolling
+	{
+		static constexpr int size = 64;
+		float values[size] = {};
+		int index = 0;
+		int count = 0;
+
+		void add(float value);
+		float getMean() const;
+		float getMax() const;
+	};
+
+	static const char* getPhaseName(Phase phase);
+
+	double ticksToMillis = 0.0;
+	juce::int64 frameStart = 0;
+	juce::int64 lastFrameStart = 0;
+	Rolling frameInterval;
+	Rolling paintTime;
+	Rolling phases[numPhases];
+
+	int framesInWindow = 0;
+	juce::uint32 windowStart = 0;
+	float repaintRate = 0.0f;
+};
@@ -0,0 +1,186 @@
+/*
+  ==============================================================================
+
+	PlayheadIndex.cpp
+	Created: 19 Oct 2026 3:54:25pm
+	Author:  Tokamak
+
+  ==============================================================================
+*/
+
+#include "PlayheadIndex.h"
+#include <algorithm>
+#include <cmath>
+
+PlayheadIndex::PlayheadIndex()
+{
+	entries.reserve(maxEntries);
+}
+
+void PlayheadIndex::record(int ringGeneration, juce::int64 blockStart, const juce::AudioPlayHead::PositionInfo& info, double sampleRate)
+{
+	auto ppq = info.getPpqPosition();
+	if (!ppq.hasValue() || sampleRate <= 0.0)
+		return;
+
+	Entry entry;
+	entry.sample = blockStart;
+	entry.ppq = *ppq;
+	entry.bpm = juce::jlimit(1.0, 999.0, info.getBpm().orFallback(120.0));
+	entry.ppqPerSample = entry.bpm / (60.0 * sampleRate);
+	auto signature = info.getTimeSignature().orFallback(juce::AudioPlayHead::TimeSignature());
+	entry.numerator = juce::jmax(1, signature.numerator);
+	entry.denominator = juce::jmax(1, signature.denominator);
+	entry.barLengthPpq = entry.numerator * 4.0 / entry.denominator;
+	//hosts without a bar start count bars from the song start
+	entry.barStartPpq = info.getPpqPositionOfLastBarStart().orFallback(std::floor(entry.ppq / entry.barLengthPpq) * entry.barLengthPpq);
+	entry.isPlaying = info.getIsPlaying();
+
+	juce::SpinLock::ScopedTryLockType lock(indexLock);
+	if (!lock.isLocked())
+	{
+		//the entry that breaks continuity must not be lost, later blocks are extrapolated from it
+		if (!hasPending && !(hasLast && generation == ringGeneration && continues(last, entry)))
+		{
+			pending = entry;
+			hasPending = true;
+		}
+		return;
+	}
+
+	if (generation != ringGeneration)
+	{
+		//the ring was reallocated and the sample counter restarted
+		entries.clear();
+		generation = ringGeneration;
+		hasPending = false;
+		hasLast = false;
+	}
+	if (hasPending)
+	{
+		append(pending);
+		hasPending = false;
+	}
+	if (!entries.empty() && continues(entries.back(), entry))
+		return;
+	append(entry);
+}
+
+void PlayheadIndex::clear()
+{
+	juce::SpinLock::ScopedLockType lock(indexLock);
+	entries.clear();
+}
+
+bool PlayheadIndex::continues(const Entry& previous, const Entry& next) const
+{
+	if (previous.isPlaying != next.isPlaying || previous.numerator != next.numerator || previous.denominator != next.denominator
+		|| std::abs(previous.bpm - next.bpm) > 1.0e-6 * previous.bpm)
+		return false;
+
+	double elapsed = static_cast<double>(next.sample - previous.sample);
+	double expected = previous.isPlaying ? previous.ppq + elapsed * previous.ppqPerSample : previous.ppq;
+	if (std::abs(expected - next.ppq) > ppqTolerance)
+		return false;
+
+	//bar lines must stay where the previous entry put them
+	double phase = std::fmod(next.barStartPpq - previous.barStartPpq, previous.barLengthPpq);
+	if (phase < 0.0)
+		phase += previous.barLengthPpq;
+	return juce::jmin(phase, previous.barLengthPpq - phase) <= ppqTolerance;
+}
+
+void PlayheadIndex::append(const Entry& entry)
+{
+	//never reallocate on the audio thread, drop the oldest quarter instead
+	if (entries.size() >= static_cast<size_t>(maxEntries))
+		entries.erase(entries.begin(), entries.begin() + maxEntries / 4);
+	entries.push_back(entry);
+	last = entry;
+	hasLast = true;
+}
+
+std::vector<PlayheadIndex::Entry>::const_iterator PlayheadIndex::findEntry(juce::int64 position) const
+{
+	auto it = std::upper_bound(entries.begin(), entries.end(), position,
+		[](juce::int64 value, const Entry& entry) { return value < entry.sample; });
+	return it == entries.begin() ? entries.end() : std::prev(it);
+}
+
+bool PlayheadIndex::hasData() const
+{
+	juce::SpinLock::ScopedLockType lock(indexLock);
+	return !entries.empty();
+}
+
+bool PlayheadIndex::getEntryAt(juce::int64 position, Entry& result) const
+{
+	juce::SpinLock::ScopedLockType lock(indexLock);
+	auto it = findEntry(position);
+	if (it == entries.end())
+		return false;
+	result = *it;
+	return true;
+}
+
+bool PlayheadIndex::getPpqAt(juce::int64 position, double& ppq) const
+{
+	Entry entry;
+	if (!getEntryAt(position, entry) || !entry.isPlaying)
+		return false;
+	ppq = entry.ppq + static_cast<double>(position - entry.sample) * entry.ppqPerSample;
+	return true;
+}
+
+void PlayheadIndex::getBarLines(juce::int64 start, juce::int64 end, juce::Array<juce::int64>& result) const
+{
+	juce::SpinLock::ScopedLockType lock(indexLock);
+	auto it = findEntry(start);
+	if (it == entries.end())
+		it = entries.begin();
+
+	for (; it != entries.end() && it->sample < end; ++it)
+	{
+		if (!it->isPlaying)
+			continue;
+
+		//each entry is valid up to the next one, the newest one up to the end of the range
+		juce::int64 segmentStart = juce::jmax(start, it->sample);
+		juce::int64 segmentEnd = std::next(it) != entries.end() ? juce::jmin(end, std::next(it)->sample) : end;
+		double ppqStart = it->ppq + static_cast<double>(segmentStart - it->sample) * it->ppqPerSample;
+		double ppqEnd = it->ppq + static_cast<double>(segmentEnd - it->sample) * it->ppqPerSample;
+
+		double bar = std::ceil((ppqStart - it->barStartPpq) / it->barLengthPpq - 1.0e-9);
+		for (double line = it->barStartPpq + bar * it->barLengthPpq; line < ppqEnd; line += it->barLengthPpq)
+		{
+			auto position = it->sample + static_cast<juce::int64>(std::llround((line - it->ppq) / it->ppqPerSample));
+			if (position >= segmentStart && position < segmentEnd && (result.isEmpty() || position > result.getLast()))
+				result.add(position);
+		}
+	}
+}
+
+juce::int64 PlayheadIndex::getNearestBarLine(juce::int64 position, juce::int64 maxDistance) const
+{
+	juce::Array<juce::int64> lines;
+	getBarLines(position - maxDistance, position + maxDistance + 1, lines);
+
+	juce::int64 nearest = -1;
+	for (auto line : lines)
+		if (nearest < 0 || std::abs(line - position) < std::abs(nearest - position))
+			nearest = line;
+	return nearest;
+}
+
+bool PlayheadIndex::getLastBars(int numBars, juce::int64 oldest, juce::int64 end, juce::int64& rangeStart, juce::int64& rangeEnd) const
+{
+	//the bar that is still running is not complete, end at the last bar line
+	juce::Array<juce::int64> lines;
+	getBarLines(oldest, end + 1, lines);
+	if (numBars <= 0 || lines.size() < numBars + 1)
+		return false;
+
+	rangeStart = lines[lines.size() - numBars - 1];
+	rangeEnd = lines.getLast();
+	return true;
+}
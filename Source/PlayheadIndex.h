@@ -0,0 +1,78 @@
+/*
+  ==============================================================================
+
+	PlayheadIndex.h
+	Created: 19 Oct 2026 3:54:25pm
+	Author:  Tokamak
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <vector>
+
+//==============================================================================
+/**
+	Musical time of the history, taken from the host playhead. processBlock hands
+	over the position of every block, but an entry is only stored when the block
+	does not continue the previous one: the transport starts or stops, the tempo
+	or time signature changes, or the host jumps (loops, relocation). Everything
+	in between is extrapolated, so a steady song needs a handful of entries.
+
+	Entries are keyed by the absolute sample counter of BufferManager and kept in
+	preallocated storage; the audio thread never allocates or blocks. Lookups are
+	binary searches, so bar lines can be found for any range of the ring even
+	when the tempo changed inside it.
+*/
+class PlayheadIndex
+{
+public:
+	struct Entry
+	{
+		juce::int64 sample = 0;		//absolute position of the first sample of the block
+		double ppq = 0.0;
+		double ppqPerSample = 0.0;
+		double barStartPpq = 0.0;
+		double barLengthPpq = 4.0;
+		double bpm = 120.0;
+		int numerator = 4;
+		int denominator = 4;
+		bool isPlaying = false;
+	};
+
+	PlayheadIndex();
+
+	//audio thread, once per block before the block is written to the ring
+	void record(int ringGeneration, juce::int64 blockStart, const juce::AudioPlayHead::PositionInfo& info, double sampleRate);
+	void clear();
+
+	bool hasData() const;
+	//the entry in effect at position, false if nothing is known about it
+	bool getEntryAt(juce::int64 position, Entry& result) const;
+	//quarter notes at position, only while the transport was playing
+	bool getPpqAt(juce::int64 position, double& ppq) const;
+	//absolute positions of every bar line in [start, end), in order
+	void getBarLines(juce::int64 start, juce::int64 end, juce::Array<juce::int64>& result) const;
+	//-1 if there is no bar line within maxDistance
+	juce::int64 getNearestBarLine(juce::int64 position, juce::int64 maxDistance) const;
+	//the last numBars complete bars that end at or before end and start at or after oldest
+	bool getLastBars(int numBars, juce::int64 oldest, juce::int64 end, juce::int64& rangeStart, juce::int64& rangeEnd) const;
+
+	static constexpr int maxEntries = 16384;
+	static constexpr double ppqTolerance = 0.002;
+
+private:
+	bool continues(const Entry& previous, const Entry& next) const;
+	void append(const Entry& entry);
+	std::vector<Entry>::const_iterator findEntry(juce::int64 position) const;
+
+	mutable juce::SpinLock indexLock;
+	std::vector<Entry> entries;
+	int generation = -1;
+	//kept when the editor held the lock, stored with the next block
+	Entry pending;
+	bool hasPending = false;
+	Entry last;
+	bool hasLast = false;
+};
@@ -5,16 +5,15 @@
 
   ==============================================================================
 */
-#include <chrono>
-#include <iomanip>
-#include <sstream>
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
 
 
 ReSamplerAudioProcessorEditor::ReSamplerAudioProcessorEditor(ReSamplerAudioProcessor& p)
-	: AudioProcessorEditor(&p), audioProcessor(p)
+	: AudioProcessorEditor(&p), audioProcessor(p), tileCache(*p.tileCache), exportCache(*p.bufferManager)
 {
+	//a hibernated history is restored in the background, until then the editor sees the wake segment
+	audioProcessor.idleHibernator->holdAwake(true);
 	startTimerHz(40);
 
 	setConstrainer(&constrainer);
@@ -24,61 +23,81 @@ ReSamplerAudioProcessorEditor::ReSamplerAudioProcessorEditor(ReSamplerAudioProce
 
 	manageProperties();
 	loadState();
+	buildSpectrogramPalette();
 
 	setWantsKeyboardFocus(true);
 
+	addChildComponent(trackBrowser);
+	trackBrowser.setVisible(properties.viewMode == ViewMode::TracksView);
+
 	menuButton.onClick = [this] { menuButtonClicked(); };
 	addAndMakeVisible(menuButton);
 
-	formatManager.registerBasicFormats();
+	//tiles left by the last editor are still valid up to where it stopped following the summary
+	tileCache.setRawReader([this](int ringStart, int numSamples, juce::AudioBuffer<float>& dest) { readRingRange(ringStart, numSamples, dest); });
+	updateWaveformTiles();
 
+	//the OpenGL context is attached after the first frame, see timerCallback
 	openGLContext.setRenderer(this);
-	openGLContext.attachTo(*this);
-	openGLContext.setContinuousRepainting(true);
 }
 
 ReSamplerAudioProcessorEditor::~ReSamplerAudioProcessorEditor()
 {
 	openGLContext.detach();
+	//the processor keeps what is on screen for the next editor, unless it shows a snapshot
+	tileCache.setRawReader(nullptr);
+	if (frozenSnapshot != nullptr)
+		tileCache.clear();
+	tileCache.shrinkTo(0);
 	audioProcessor.bufferManager->bufferState.isPlaying = false;
 	audioProcessor.bufferManager->bufferState.readPosition = 0;
+	audioProcessor.bufferManager->setPlaybackSnapshot(nullptr);
 	saveState();
+	audioProcessor.idleHibernator->holdAwake(false);
+}
+
+void ReSamplerAudioProcessorEditor::newOpenGLContextCreated()
+{
+	TRACE_ZONE("newOpenGLContextCreated");
+}
+
+void ReSamplerAudioProcessorEditor::renderOpenGL()
+{
+	//GL thread, once per frame before the editor is painted into the context
+	TRACE_ZONE("renderOpenGL");
 }
 
 //==============================================================================
 
 void ReSamplerAudioProcessorEditor::paint(juce::Graphics& g)
 {
-	int recLineX = getWidth() * (static_cast<float>(audioProcessor.bufferManager->bufferState.writePosition) / audioProcessor.bufferManager->getBufferPointer()->getNumSamples());
-	int playLineX = getWidth() * (static_cast<float>(audioProcessor.bufferManager->bufferState.readPosition) / audioProcessor.bufferManager->getBufferPointer()->getNumSamples());
-	recLineX = (recLineX + editorState.waveformOffsetAbs) % getWidth();
-	playLineX = (playLineX + editorState.waveformOffsetAbs) % getWidth();
+	TRACE_ZONE("paint");
+	if (properties.showHud)
+		hud.frameStarted();
+	juce::int64 phaseStart = properties.showHud ? juce::Time::getHighResolutionTicks() : 0;
+	auto endPhase = [this, &phaseStart](PerformanceHud::Phase phase)
+		{
+			if (!properties.showHud)
+				return;
+			juce::int64 now = juce::Time::getHighResolutionTicks();
+			hud.addPhase(phase, now - phaseStart);
+			phaseStart = now;
+		};
 
-	juce::Rectangle<int> firstPart(editorState.waveformOffsetAbs, 0, getWidth() - editorState.waveformOffsetAbs, getHeight());
-	juce::Rectangle<int> secondPart(0, 0, editorState.waveformOffsetAbs, getHeight());
-	double crossoverTime = static_cast<double>(getWidth() - editorState.waveformOffsetAbs) * audioProcessor.bufferManager->getBufferLength() / getWidth();
+	int writePosition = frozenSnapshot != nullptr ? frozenSnapshot->getWritePosition() : audioProcessor.bufferManager->bufferState.writePosition;
+	int recLineX = static_cast<int>(ringPositionToX(writePosition));
+	int playLineX = static_cast<int>(ringPositionToX(audioProcessor.bufferManager->bufferState.readPosition));
 
 	if (audioProcessor.bufferManager->bufferState.isPlaying && editorState.playSelected)
 	{
-		if (editorState.startPosAbs + editorState.widthAbs <= getWidth())
+		int ringSamples = getRingSamples();
+		int played = (audioProcessor.bufferManager->bufferState.readPosition - editorState.selectionStart + ringSamples) % ringSamples;
+		if (played >= editorState.selectionLength)
 		{
-			if (playLineX > editorState.startPosAbs + editorState.widthAbs + 1 || playLineX < editorState.startPosAbs - 1)
-			{
-				audioProcessor.bufferManager->bufferState.isPlaying = false;
-				audioProcessor.bufferManager->bufferState.readPosition = 0;
-				editorState.playSelected = false;
-			}
+			audioProcessor.bufferManager->bufferState.isPlaying = false;
+			audioProcessor.bufferManager->bufferState.readPosition = 0;
+			editorState.playSelected = false;
 		}
-		else
-		{
-			if (playLineX > (editorState.startPosAbs + editorState.widthAbs) % getWidth() + 1 && playLineX < editorState.startPosAbs - 1)
-			{
-				audioProcessor.bufferManager->bufferState.isPlaying = false;
-				audioProcessor.bufferManager->bufferState.readPosition = 0;
-				editorState.playSelected = false;
-			}
-		}
-
 	}
 
 	switch (properties.theme)
@@ -103,14 +122,48 @@ void ReSamplerAudioProcessorEditor::paint(juce::Graphics& g)
 		break;
 	}
 
+	endPhase(PerformanceHud::ThemeSetup);
+
 	menuButton.setColour(juce::TextButton::buttonColourId, colourScheme.backGround);
 	menuButton.setColour(juce::TextButton::textColourOffId, colourScheme.buttonText);
 
 	g.fillAll(colourScheme.backGround);
 
-	g.setGradientFill(colourScheme.waveBlock);
-	waveform.drawChannels(g, firstPart, 0, crossoverTime, 1.0f);
-	waveform.drawChannels(g, secondPart, crossoverTime, audioProcessor.bufferManager->getBufferLength(), 1.0f);
+	//the track browser covers the editor, it reads the other instances itself
+	if (properties.viewMode == ViewMode::TracksView)
+	{
+		trackBrowser.setColours(colourScheme.backGround, colourScheme.recLine, colourScheme.selcectedArea, colourScheme.buttonText);
+		trackBrowser.setVisibleSeconds(audioProcessor.bufferManager->getBufferLength());
+		recordFirstFrame();
+		return;
+	}
+
+	if (properties.viewMode == ViewMode::SpectrogramView)
+		drawSpectrogram(g);
+	else
+	{
+		g.setGradientFill(colourScheme.waveBlock);
+		if (frozenSnapshot != nullptr)
+			tileCache.draw(g, getWidth(), getHeight(), editorState.viewStart, getSamplesPerPixel(), &frozenSummary, true);
+		else
+		{
+			//draw whatever is cached if the analysis thread is reallocating right now
+			juce::ScopedTryLock lock(audioProcessor.waveformPyramid->getStorageLock());
+			tileCache.draw(g, getWidth(), getHeight(), editorState.viewStart, getSamplesPerPixel(),
+				&audioProcessor.waveformPyramid->getSummary(), lock.isLocked() && tileCache.getSummaryLayout() == audioProcessor.waveformPyramid->getLayoutVersion());
+		}
+	}
+
+	endPhase(PerformanceHud::WaveformDraw);
+
+	if (properties.snapToTransients)
+		drawTransients(g);
+	//宿主提供的小节线优先，没有时才显示估计的节拍
+	if (audioProcessor.playheadIndex->hasData())
+		drawBarGrid(g);
+	else if (properties.snapToBars)
+		drawBeatGrid(g);
+	drawMarkers(g);
 
 	g.setGradientFill(colourScheme.recBlock);
 	g.fillRect(recLineX - 50, 0, 49, getHeight());
@@ -128,7 +181,7 @@ void ReSamplerAudioProcessorEditor::paint(juce::Graphics& g)
 		g.fillRect(editorState.mouseX - 1, 0, 1, getHeight());
 	}
 
-	if (!audioProcessor.bufferManager->bufferState.isRecording)
+	if (frozenSnapshot != nullptr || !audioProcessor.bufferManager->bufferState.isRecording)
 	{
 		g.fillAll(colourScheme.pauseArea);
 	}
@@ -136,19 +189,24 @@ void ReSamplerAudioProcessorEditor::paint(juce::Graphics& g)
 	if (editorState.enableSelectArea)
 	{
 		g.setColour(colourScheme.selcectedArea);
-		if (editorState.startPosAbs + editorState.widthAbs < getWidth())
-			g.fillRect(editorState.startPosAbs, 0, editorState.widthAbs, getHeight());
-		else
-		{
-			g.fillRect(0, 0, editorState.startPosAbs + editorState.widthAbs - getWidth(), getHeight());
-			g.fillRect(editorState.startPosAbs, 0, getWidth() - editorState.startPosAbs, getHeight());
-		}
+		float selectionX = ringPositionToX(editorState.selectionStart);
+		float selectionWidth = juce::jmax(1.0f, static_cast<float>(editorState.selectionLength / getSamplesPerPixel()));
+		float ringWidth = static_cast<float>(getRingSamples() / getSamplesPerPixel());
+		g.fillRect(selectionX, 0.0f, selectionWidth, static_cast<float>(getHeight()));
+		g.fillRect(selectionX - ringWidth, 0.0f, selectionWidth, static_cast<float>(getHeight()));
+		drawSimilar(g);
 	}
 
 	if (properties.theme == Theme::Rainbow)
 	{
 
-		if (audioProcessor.bufferManager->bufferState.isRecording)
+		if (frozenSnapshot != nullptr)
+		{
+			g.setFont(20.0f);
+			g.setColour(juce::Colours::white);
+			g.drawText("Snapshot (Still Recording)", getBounds(), juce::Justification::centred);
+		}
+		else if (audioProcessor.bufferManager->bufferState.isRecording)
 		{
 			g.setFont(20.0f);
 			g.setColour(juce::Colours::white);
@@ -161,14 +219,34 @@ void ReSamplerAudioProcessorEditor::paint(juce::Graphics& g)
 			g.drawText("Recording Paused", getBounds(), juce::Justification::centred);
 		}
 	}
+
+	if (audioProcessor.batchExporter->isRunning())
+		drawExportProgress(g);
+
+	if (properties.showHud)
+	{
+		endPhase(PerformanceHud::Overlays);
+		drawHud(g);
+		hud.frameFinished();
+	}
+	recordFirstFrame();
+}
+
+void ReSamplerAudioProcessorEditor::recordFirstFrame()
+{
+	if (firstFrameMillis >= 0.0)
+		return;
+	juce::int64 now = juce::Time::getHighResolutionTicks();
+	firstFrameMillis = juce::Time::highResolutionTicksToSeconds(now - openedTicks) * 1000.0;
+	audioProcessor.editorResources->addTimeToFirstFrame(firstFrameMillis);
+	Tracer::getInstance().addEvent("editorFirstFrame", openedTicks, now);
 }
 
 void ReSamplerAudioProcessorEditor::resized()
 {
 	menuButton.setBounds(getWidth() - 50, 10, 40, 20);
-	editorState.startPosAbs = editorState.startPos * getWidth();
-	editorState.widthAbs = editorState.width * getWidth();
-	editorState.waveformOffsetAbs = editorState.waveformOffset * getWidth();
+	trackBrowser.setBounds(getLocalBounds());
+	editorState.samplesPerPixel = editorState.samplesPerPixel > 0.0 ? juce::jmin(editorState.samplesPerPixel, static_cast<double>(getRingSamples()) / getWidth()) : 0.0;
 }
 
 void ReSamplerAudioProcessorEditor::paintRainbow(juce::Graphics& g, int recLineX, int playLineX)
@@ -243,7 +321,7 @@ void ReSamplerAudioProcessorEditor::paintLight(juce::Graphics& g, int recLineX,
 
 void ReSamplerAudioProcessorEditor::paintMatrix(juce::Graphics& g, int recLineX, int playLineX)
 {
-	float borderAlpha = 1.0f - static_cast<float>(recLineX) / getWidth();
+	float borderAlpha = juce::jlimit(0.0f, 1.0f, 1.0f - static_cast<float>(recLineX) / getWidth());
 	float borderBrightness = 0.8 * borderAlpha;
 
 	colourScheme.backGround = juce::Colours::black.withBrightness(0.1f);
@@ -267,14 +345,109 @@ void ReSamplerAudioProcessorEditor::paintMatrix(juce::Graphics& g, int recLineX,
 	colourScheme.selcectedArea = juce::Colours::green.withAlpha(0.3f);
 }
 
+void ReSamplerAudioProcessorEditor::drawSpectrogram(juce::Graphics& g)
+{
+	auto& spectrogram = *audioProcessor.spectrogram;
+	int ringSamples = getRingSamples();
+	if (spectrogramLayout != spectrogram.getLayoutVersion() || spectrogram.getRingSamples() != ringSamples)
+		return;
+
+	g.setImageResamplingQuality(juce::Graphics::lowResamplingQuality);
+	double samplesPerPixel = getSamplesPerPixel();
+	float ringWidth = static_cast<float>(ringSamples / samplesPerPixel);
+	int tileSamples = Spectrogram::tileColumns * spectrogram.getHopSize();
+
+	for (int tile = 0; tile < static_cast<int>(spectrogramImages.size()); tile++)
+	{
+		if (!spectrogramImages[tile].isValid())
+			continue;
+
+		float x = ringPositionToX(tile * tileSamples);
+		float w = static_cast<float>(spectrogram.getNumColumnsInTile(tile) * spectrogram.getHopSize() / samplesPerPixel);
+		if (x < getWidth())
+			g.drawImage(spectrogramImages[tile], juce::Rectangle<float>(x, 0.0f, w, static_cast<float>(getHeight())));
+		if (x + w > ringWidth)
+			g.drawImage(spectrogramImages[tile], juce::Rectangle<float>(x - ringWidth, 0.0f, w, static_cast<float>(getHeight())));
+	}
+}
+
+void ReSamplerAudioProcessorEditor::updateSpectrogramImages()
+{
+	TRACE_ZONE("updateSpectrogramImages");
+	auto& spectrogram = *audioProcessor.spectrogram;
+
+	//never wait for the analysis thread, just try again on the next timer tick
+	juce::ScopedTryLock lock(spectrogram.getStorageLock());
+	if (!lock.isLocked())
+		return;
+
+	if (spectrogramLayout != spectrogram.getLayoutVersion())
+	{
+		spectrogramLayout = spectrogram.getLayoutVersion();
+		spectrogramImages.assign(spectrogram.getNumTiles(), juce::Image());
+		spectrogramImageVersions.assign(spectrogram.getNumTiles(), 0);
+	}
+
+	for (int tile = 0; tile < spectrogram.getNumTiles(); tile++)
+	{
+		juce::uint32 version = spectrogram.getTileVersion(tile);
+		if (version == spectrogramImageVersions[tile] && spectrogramImages[tile].isValid())
+			continue;
+
+		int numColumns = spectrogram.getNumColumnsInTile(tile);
+		if (!spectrogramImages[tile].isValid())
+			spectrogramImages[tile] = juce::Image(juce::Image::RGB, numColumns, Spectrogram::numBands, false);
+
+		const juce::uint8* data = spectrogram.getTileData(tile);
+		juce::Image::BitmapData bitmap(spectrogramImages[tile], juce::Image::BitmapData::writeOnly);
+		for (int column = 0; column < numColumns; column++)
+		{
+			for (int band = 0; band < Spectrogram::numBands; band++)
+				bitmap.setPixelColour(column, Spectrogram::numBands - 1 - band, spectrogramPalette[data[column * Spectrogram::numBands + band]]);
+		}
+		spectrogramImageVersions[tile] = version;
+	}
+}
+
+void ReSamplerAudioProcessorEditor::buildSpectrogramPalette()
+{
+	juce::ColourGradient gradient;
+	switch (properties.theme)
+	{
+	case Theme::Rainbow:
+		gradient = juce::ColourGradient(juce::Colours::black, 0, 0, juce::Colours::white, 1, 0, false);
+		gradient.addColour(0.3, juce::Colours::purple);
+		gradient.addColour(0.55, juce::Colours::red);
+		gradient.addColour(0.8, juce::Colours::yellow);
+		break;
+
+	case Theme::Dark:
+		gradient = juce::ColourGradient(juce::Colours::black.withBrightness(0.2f), 0, 0, juce::Colours::white, 1, 0, false);
+		break;
+
+	case Theme::Light:
+		gradient = juce::ColourGradient(juce::Colours::black.withBrightness(0.7f), 0, 0, juce::Colours::black, 1, 0, false);
+		break;
+
+	case Theme::Matrix:
+		gradient = juce::ColourGradient(juce::Colours::black.withBrightness(0.1f), 0, 0, juce::Colours::darkgreen.withBrightness(1.0f), 1, 0, false);
+		break;
+
+	default:
+		break;
+	}
+
+	for (int i = 0; i < 256; i++)
+		spectrogramPalette[i] = gradient.getColourAtPosition(i / 255.0);
+
+	//palette changed, every tile has to be rendered again
+	spectrogramLayout = -1;
+}
+
 void ReSamplerAudioProcessorEditor::manageProperties()
 {
-	juce::PropertiesFile::Options options;
-	options.applicationName = "TKRS";
-	options.filenameSuffix = ".settings";
-	options.folderName = (juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory).getFullPathName() + "\\ReSampler").toStdString();
-	options.storageFormat = juce::PropertiesFile::storeAsXML;
-	propertiesFile = std::make_unique<juce::PropertiesFile>(options);
+	//配置文件在进程内只解析一次，所有编辑器共用
+	propertiesFile = &audioProcessor.editorResources->getSettings();
 }
 
 void ReSamplerAudioProcessorEditor::saveState()
@@ -282,6 +455,11 @@ void ReSamplerAudioProcessorEditor::saveState()
 	propertiesFile->setValue("width", getWidth());
 	propertiesFile->setValue("height", getHeight());
 	propertiesFile->setValue("theme", static_cast<int>(properties.theme));
+	propertiesFile->setValue("viewMode", static_cast<int>(properties.viewMode));
+	propertiesFile->setValue("snapToTransients", properties.snapToTransients);
+	propertiesFile->setValue("snapToBars", properties.snapToBars);
+	propertiesFile->setValue("showHud", properties.showHud);
+	propertiesFile->setValue("exportFormat", static_cast<int>(properties.exportFormat));
 	propertiesFile->setValue("recordingPath", properties.recordingPath);
 	propertiesFile->setValue("bufferLength", audioProcessor.bufferManager->getBufferLength());
 	propertiesFile->saveIfNeeded();
@@ -295,6 +473,22 @@ void ReSamplerAudioProcessorEditor::loadState()
 	else
 		properties.theme = Theme::Rainbow;
 
+	//加载viewMode
+	if (propertiesFile->containsKey("viewMode"))
+		properties.viewMode = static_cast<ViewMode>(propertiesFile->getIntValue("viewMode"));
+	else
+		properties.viewMode = ViewMode::WaveformView;
+
+	//加载snapToTransients
+	properties.snapToTransients = propertiesFile->getBoolValue("snapToTransients", true);
+	properties.snapToBars = propertiesFile->getBoolValue("snapToBars", false);
+
+	//加载showHud
+	properties.showHud = propertiesFile->getBoolValue("showHud", false);
+
+	//加载exportFormat
+	properties.exportFormat = static_cast<ExportFormat>(juce::jlimit(0, numExportFormats - 1, propertiesFile->getIntValue("exportFormat", Wav24)));
+
 	//加载size
 	if (propertiesFile->containsKey("width") && propertiesFile->containsKey("height"))
 	{
@@ -316,114 +510,362 @@ void ReSamplerAudioProcessorEditor::loadState()
 
 }
 
-void ReSamplerAudioProcessorEditor::prepareWaveform()
+void ReSamplerAudioProcessorEditor::drawHud(juce::Graphics& g)
+{
+	//a hibernated ring is on disk, only the wake segment is resident
+	auto& bufferManager = *audioProcessor.bufferManager;
+	size_t ringBytes = bufferManager.isHibernated() ? 0 : static_cast<size_t>(bufferManager.getBufferNumChannels()) * bufferManager.getRingSamples() * sizeof(float);
+	size_t imageBytes = 0;
+	for (auto& image : spectrogramImages)
+		imageBytes += image.isValid() ? static_cast<size_t>(image.getWidth()) * image.getHeight() * 4 : 0;
+	auto callback = audioProcessor.callbackProfiler->getStats();
+
+	//the analysis thread may be reallocating, skip the sizes rather than wait
+	size_t summaryBytes = frozenSnapshot != nullptr ? frozenSummary.getMemoryUsage() : 0;
+	{
+		juce::ScopedTryLock lock(audioProcessor.waveformPyramid->getStorageLock());
+		if (lock.isLocked())
+			summaryBytes += audioProcessor.waveformPyramid->getSummary().getMemoryUsage();
+	}
+	size_t spectrogramBytes = imageBytes;
+	{
+		juce::ScopedTryLock lock(audioProcessor.spectrogram->getStorageLock());
+		if (lock.isLocked())
+			spectrogramBytes += audioProcessor.spectrogram->getMemoryUsage();
+	}
+
+	juce::StringArray lines;
+	lines.add("tiles " + juce::String(tileCache.getNumTiles()) + ", " + PerformanceHud::formatBytes(tileCache.getMemoryUsage()));
+	lines.add("ring " + PerformanceHud::formatBytes(ringBytes) + ", snapshots " + PerformanceHud::formatBytes(audioProcessor.bufferManager->getSnapshotMemoryUsage()));
+	lines.add("summary " + PerformanceHud::formatBytes(summaryBytes));
+	lines.add("spectrogram " + PerformanceHud::formatBytes(spectrogramBytes));
+	juce::String firstFrame = audioProcessor.editorResources->getTimeToFirstFrameText();
+	if (firstFrame.isNotEmpty())
+		lines.add(firstFrame);
+	lines.add("callback " + juce::String(callback.meanMicros, 0) + " us, worst load " + juce::String(callback.maxLoad * 100.0, 0) + "%, misses " + juce::String(callback.numDeadlineMisses));
+
+	hud.draw(g, juce::Rectangle<int>(10, 10, 220, getHeight()), colourScheme.playLine, lines);
+}
+
+void ReSamplerAudioProcessorEditor::updateWaveformTiles()
+{
+	TRACE_ZONE("updateWaveformTiles");
+	auto& pyramid = *audioProcessor.waveformPyramid;
+	tileCache.followSummary(pyramid.getLayoutVersion(), pyramid.getSummaryEnd(), getRingSamples());
+}
+
+void ReSamplerAudioProcessorEditor::readRingRange(int ringStart, int numSamples, juce::AudioBuffer<float>& dest)
+{
+	if (frozenSnapshot != nullptr)
+	{
+		audioProcessor.bufferManager->readFromSnapshot(*frozenSnapshot, dest, ringStart, numSamples);
+		return;
+	}
+
+	//the live ring is read by absolute position, hibernation may free it at any time; a range running
+	//past the write head continues with the oldest audio, and whatever cannot be read stays silent
+	auto& bufferManager = *audioProcessor.bufferManager;
+	juce::int64 start = ringToAbsolute(ringStart);
+	int firstPart = static_cast<int>(juce::jlimit<juce::int64>(0, numSamples, bufferManager.getTotalSamplesWritten() - start));
+	if (firstPart > 0 && !bufferManager.readHistory(start, dest, 0, firstPart))
+		dest.clear(0, firstPart);
+	if (firstPart < numSamples && !bufferManager.readHistory(start + firstPart - getRingSamples(), dest, firstPart, numSamples - firstPart))
+		dest.clear(firstPart, numSamples - firstPart);
+}
+
+int ReSamplerAudioProcessorEditor::getRingSamples() const
+{
+	return juce::jmax(1, audioProcessor.bufferManager->getRingSamples());
+}
+
+double ReSamplerAudioProcessorEditor::getSamplesPerPixel() const
+{
+	double fit = static_cast<double>(getRingSamples()) / juce::jmax(1, getWidth());
+	return editorState.samplesPerPixel > 0.0 ? juce::jmin(editorState.samplesPerPixel, fit) : fit;
+}
+
+int ReSamplerAudioProcessorEditor::xToRingPosition(float x) const
+{
+	int ringSamples = getRingSamples();
+	auto position = static_cast<juce::int64>(std::floor(editorState.viewStart + x * getSamplesPerPixel()));
+	return static_cast<int>((position % ringSamples + ringSamples) % ringSamples);
+}
+
+float ReSamplerAudioProcessorEditor::ringPositionToX(int ringPosition) const
+{
+	double ringSamples = getRingSamples();
+	double relative = std::fmod(ringPosition - editorState.viewStart, ringSamples);
+	if (relative < 0.0)
+		relative += ringSamples;
+	return static_cast<float>(relative / getSamplesPerPixel());
+}
+
+juce::int64 ReSamplerAudioProcessorEditor::ringToAbsolute(int ringPosition) const
+{
+	//the ring holds [written - ringSamples, written), frozen views map through the snapshot's counter
+	int ringSamples = getRingSamples();
+	juce::int64 written = frozenSnapshot != nullptr ? frozenSnapshot->getSamplesWritten() : audioProcessor.bufferManager->getTotalSamplesWritten();
+	int oldest = static_cast<int>(written % ringSamples);
+	return written - ringSamples + (ringPosition - oldest + ringSamples) % ringSamples;
+}
+
+juce::int64 ReSamplerAudioProcessorEditor::snapToTransient(juce::int64 position) const
+{
+	auto maxDistance = static_cast<juce::int64>(std::ceil(8.0 * getSamplesPerPixel()));
+	juce::int64 onset = audioProcessor.onsetDetector->findNearestOnset(position, maxDistance);
+	return onset >= 0 ? onset : position;
+}
+
+void ReSamplerAudioProcessorEditor::drawTransients(juce::Graphics& g)
 {
-	if (waveform.getTotalLength() > 0.0)
+	int ringSamples = getRingSamples();
+	juce::int64 written = frozenSnapshot != nullptr ? frozenSnapshot->getSamplesWritten() : audioProcessor.bufferManager->getTotalSamplesWritten();
+	juce::Array<juce::int64> onsets;
+	audioProcessor.onsetDetector->getOnsets(written - ringSamples, written, onsets);
+
+	g.setColour(colourScheme.playLine.withMultipliedAlpha(0.5f));
+	for (auto onset : onsets)
 	{
-		if (audioProcessor.bufferManager->bufferState.writePosition - offset < 0) // overlap
+		float x = ringPositionToX(static_cast<int>(onset % ringSamples));
+		if (x < getWidth())
+			g.fillRect(x, 0.0f, 1.0f, 6.0f);
+	}
+}
+
+void ReSamplerAudioProcessorEditor::drawSimilar(juce::Graphics& g)
+{
+	int ringSamples = getRingSamples();
+	juce::int64 written = frozenSnapshot != nullptr ? frozenSnapshot->getSamplesWritten() : audioProcessor.bufferManager->getTotalSamplesWritten();
+	float width = juce::jmax(1.0f, static_cast<float>(editorState.selectionLength / getSamplesPerPixel()));
+	float ringWidth = static_cast<float>(ringSamples / getSamplesPerPixel());
+
+	for (auto start : editorState.similarMatches)
+	{
+		//already overwritten
+		if (start < written - ringSamples)
+			continue;
+		float x = ringPositionToX(static_cast<int>(start % ringSamples));
+		for (float left : { x, x - ringWidth })
 		{
-			waveform.addBlock(audioProcessor.bufferManager->getBufferPointer()->getNumSamples(), *(audioProcessor.bufferManager->getBufferPointer()), offset, audioProcessor.bufferManager->getBufferPointer()->getNumSamples() - offset);
-			waveform.addBlock(audioProcessor.bufferManager->getBufferPointer()->getNumSamples(), *(audioProcessor.bufferManager->getBufferPointer()), 0, audioProcessor.bufferManager->bufferState.writePosition);
+			g.setColour(colourScheme.recLine.withAlpha(0.15f));
+			g.fillRect(left, 0.0f, width, static_cast<float>(getHeight()));
+			g.setColour(colourScheme.recLine.withAlpha(0.6f));
+			g.fillRect(left, 0.0f, 1.0f, static_cast<float>(getHeight()));
 		}
-		else
-			waveform.addBlock(audioProcessor.bufferManager->getBufferPointer()->getNumSamples(), *(audioProcessor.bufferManager->getBufferPointer()), offset, audioProcessor.bufferManager->bufferState.writePosition - offset);
-		offset = audioProcessor.bufferManager->bufferState.writePosition;
 	}
 }
 
-bool ReSamplerAudioProcessorEditor::isInSelectedArea(const int pos)
+void ReSamplerAudioProcessorEditor::drawBeatGrid(juce::Graphics& g)
 {
-	/*if (pos <= editorState.startPos * getWidth() + 1)
-		return false;
-	if (pos >= (editorState.startPos + editorState.width) * getWidth() - 1)
-		return false;
-	return true;*/
+	auto grid = audioProcessor.tempoAnalyser->getGrid();
+	if (!grid.isValid() || grid.beatSamples / getSamplesPerPixel() < 4.0)
+		return;
 
-	if (editorState.startPosAbs + editorState.widthAbs <= getWidth())
+	//beat ticks along the bottom, extended back over the whole ring from the newest estimate
+	int ringSamples = getRingSamples();
+	juce::int64 written = frozenSnapshot != nullptr ? frozenSnapshot->getSamplesWritten() : audioProcessor.bufferManager->getTotalSamplesWritten();
+	g.setColour(colourScheme.playLine.withMultipliedAlpha(0.5f));
+	auto firstBeat = static_cast<juce::int64>(std::ceil((written - ringSamples - grid.beatOrigin) / grid.beatSamples));
+	for (juce::int64 beat = firstBeat; grid.beatOrigin + beat * grid.beatSamples < written; beat++)
 	{
-		return (pos > editorState.startPosAbs + 1 && pos < editorState.startPosAbs + editorState.widthAbs - 1);
+		auto position = grid.beatOrigin + static_cast<juce::int64>(std::llround(beat * grid.beatSamples));
+		float x = ringPositionToX(static_cast<int>(((position % ringSamples) + ringSamples) % ringSamples));
+		if (x < getWidth())
+			g.fillRect(x, static_cast<float>(getHeight() - 4), 1.0f, 4.0f);
 	}
-	else
+}
+
+void ReSamplerAudioProcessorEditor::drawBarGrid(juce::Graphics& g)
+{
+	//bar lines from the host playhead, exact even where the tempo changed
+	int ringSamples = getRingSamples();
+	juce::int64 written = frozenSnapshot != nullptr ? frozenSnapshot->getSamplesWritten() : audioProcessor.bufferManager->getTotalSamplesWritten();
+	juce::Array<juce::int64> lines;
+	audioProcessor.playheadIndex->getBarLines(written - ringSamples, written, lines);
+
+	g.setColour(colourScheme.playLine.withMultipliedAlpha(0.25f));
+	float lastX = -1.0e6f;
+	for (auto line : lines)
+	{
+		float x = ringPositionToX(static_cast<int>(((line % ringSamples) + ringSamples) % ringSamples));
+		if (x >= getWidth() || std::abs(x - lastX) < 4.0f)
+			continue;
+		g.fillRect(x, 0.0f, 1.0f, static_cast<float>(getHeight()));
+		lastX = x;
+	}
+}
+
+void ReSamplerAudioProcessorEditor::drawMarkers(juce::Graphics& g)
+{
+	int ringSamples = getRingSamples();
+	juce::int64 written = frozenSnapshot != nullptr ? frozenSnapshot->getSamplesWritten() : audioProcessor.bufferManager->getTotalSamplesWritten();
+
+	g.setColour(colourScheme.recLine.withMultipliedAlpha(0.8f));
+	for (int i = 0; i < editorState.markers.size(); i++)
 	{
-		return (pos > editorState.startPosAbs + 1 || pos < (editorState.startPosAbs + editorState.widthAbs) % getWidth() - 1);
+		juce::int64 marker = editorState.markers[i];
+		if (marker < written - ringSamples)
+			continue;
+
+		float x = ringPositionToX(static_cast<int>(marker % ringSamples));
+		if (x >= getWidth())
+			continue;
+		g.fillRect(x, 0.0f, 1.0f, static_cast<float>(getHeight()));
+		g.setFont(12.0f);
+		g.drawText(juce::String(i + 1), juce::Rectangle<float>(x + 3.0f, 2.0f, 30.0f, 14.0f), juce::Justification::centredLeft);
 	}
 }
 
+void ReSamplerAudioProcessorEditor::drawExportProgress(juce::Graphics& g)
+{
+	auto& exporter = *audioProcessor.batchExporter;
+	auto bar = getLocalBounds().removeFromBottom(4).toFloat();
+	g.setColour(colourScheme.recLine.withMultipliedAlpha(0.3f));
+	g.fillRect(bar);
+	g.setColour(colourScheme.recLine);
+	g.fillRect(bar.withWidth(bar.getWidth() * static_cast<float>(exporter.getProgress())));
+	g.setFont(12.0f);
+	g.drawText("Exporting " + juce::String(exporter.getNumFinished()) + "/" + juce::String(exporter.getNumRegions()),
+		getLocalBounds().removeFromBottom(20).withTrimmedLeft(6), juce::Justification::centredLeft);
+}
+
+void ReSamplerAudioProcessorEditor::zoomAround(float x, double samplesPerPixel)
+{
+	//keep the sample under the mouse where it is
+	double anchor = editorState.viewStart + x * getSamplesPerPixel();
+	double fit = static_cast<double>(getRingSamples()) / juce::jmax(1, getWidth());
+	double minimum = WaveformTileCache::getSamplesPerPixel(WaveformTileCache::minLevel);
+	editorState.samplesPerPixel = juce::jlimit(minimum, fit, samplesPerPixel);
+	if (editorState.samplesPerPixel >= fit)
+		editorState.samplesPerPixel = 0.0;
+
+	setViewStart(anchor - x * getSamplesPerPixel());
+}
+
+void ReSamplerAudioProcessorEditor::setViewStart(double position)
+{
+	double ringSamples = getRingSamples();
+	editorState.viewStart = std::fmod(position, ringSamples);
+	if (editorState.viewStart < 0.0)
+		editorState.viewStart += ringSamples;
+}
+
+bool ReSamplerAudioProcessorEditor::isInSelectedArea(const int pos)
+{
+	int ringSamples = getRingSamples();
+	int margin = static_cast<int>(std::ceil(getSamplesPerPixel()));
+	int relative = (xToRingPosition(static_cast<float>(pos)) - editorState.selectionStart + ringSamples) % ringSamples;
+	return relative > margin && relative < editorState.selectionLength - margin;
+}
+
 juce::String ReSamplerAudioProcessorEditor::exportSelectedArea()
 {
 	juce::File recordingDir(properties.recordingPath);
 	if (!recordingDir.exists())
 		recordingDir.createDirectory();
 
-	auto now = std::chrono::system_clock::now();
-	std::time_t now_time_t = std::chrono::system_clock::to_time_t(now);
-	std::tm now_tm = *std::localtime(&now_time_t);
-	std::ostringstream oss;
-	oss << std::put_time(&now_tm, "%Y%m%d_%H%M%S");
+	juce::String timestamp = juce::Time::getCurrentTime().formatted("%Y%m%d_%H%M%S");
 
-	juce::String filePath = properties.recordingPath + "\\" + "TKRS_" + oss.str() + ".wav";
+	juce::String filePath = properties.recordingPath + "\\" + "TKRS_" + timestamp + AudioExport::getFileExtension(properties.exportFormat);
 	juce::File audioFile(filePath);
 
-	const juce::AudioBuffer<float>& buffer = *audioProcessor.bufferManager->getBufferPointer();
-	int realStartX = (editorState.startPosAbs + getWidth() - editorState.waveformOffsetAbs) % getWidth();
-	double realStartPos = static_cast<double>(realStartX) / getWidth();
-
-	int startSample = static_cast<int>(realStartPos * buffer.getNumSamples());
-	int numSamples = static_cast<int>(editorState.width * buffer.getNumSamples());
+	int startSample = editorState.selectionStart;
+	int numSamples = editorState.selectionLength;
 
-	renderBuffer(buffer, startSample, numSamples, audioProcessor.bufferManager->getBufferSampleRate(), audioFile);
+	if (frozenSnapshot != nullptr)
+	{
+		juce::AudioBuffer<float> frozenBuffer(frozenSnapshot->getNumChannels(), numSamples);
+		audioProcessor.bufferManager->readFromSnapshot(*frozenSnapshot, frozenBuffer, startSample, numSamples);
+		if (!renderBuffer(frozenBuffer, 0, numSamples, audioProcessor.bufferManager->getBufferSampleRate(), audioFile))
+			return {};
+	}
+	else
+	{
+		//overwritten while dragging or still on disk after hibernating, nothing to hand over
+		juce::AudioBuffer<float> liveBuffer(audioProcessor.bufferManager->getBufferNumChannels(), numSamples);
+		if (!audioProcessor.bufferManager->readHistory(ringToAbsolute(startSample), liveBuffer, 0, numSamples))
+			return {};
+		if (!renderBuffer(liveBuffer, 0, numSamples, audioProcessor.bufferManager->getBufferSampleRate(), audioFile))
+			return {};
+	}
 
 	return filePath;
 }
 
-void ReSamplerAudioProcessorEditor::renderBuffer(const juce::AudioBuffer<float>& buffer, int startSample, int numSamples, double sampleRate, const juce::File& file)
+ExportCache::Request ReSamplerAudioProcessorEditor::makeExportRequest() const
 {
-	juce::WavAudioFormat wavFormat;
-	std::unique_ptr<juce::FileOutputStream> fileStream(file.createOutputStream());
+	ExportCache::Request request;
+	request.snapshot = frozenSnapshot;
+	request.ringStart = editorState.selectionStart;
+	request.numSamples = editorState.selectionLength;
+	request.absoluteStart = ringToAbsolute(editorState.selectionStart);
+	request.ringGeneration = audioProcessor.bufferManager->getRingGeneration();
+	request.sampleRate = audioProcessor.bufferManager->getBufferSampleRate();
+	request.format = properties.exportFormat;
+	request.folder = juce::File(properties.recordingPath).getChildFile("TKRS_cache");
+	return request;
+}
 
-	if (fileStream != nullptr)
+void ReSamplerAudioProcessorEditor::prerenderSelection()
+{
+	//选区稳定一段时间后在后台预先渲染，拖出时直接使用
+	if (!editorState.enableSelectArea || editorState.selectionLength <= 0 || isMouseButtonDown())
 	{
-		std::unique_ptr<juce::AudioFormatWriter> writer(wavFormat.createWriterFor(fileStream.get(),
-			sampleRate,
-			buffer.getNumChannels(),
-			24,
-			{},
-			0));
-
-		if (writer != nullptr)
-		{
-			fileStream.release();
-
-			juce::AudioBuffer<float> tempBuffer(buffer.getNumChannels(), numSamples);
+		selectionStableTicks = 0;
+		return;
+	}
 
-			DBG("startSample: " << startSample << " numSamples: " << numSamples << " totalSamples: " << buffer.getNumSamples());
-			if (startSample + numSamples > buffer.getNumSamples())
-			{
-				DBG("crossover");
-				int overlap = startSample + numSamples - buffer.getNumSamples();
-				for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
-				{
-					tempBuffer.copyFrom(channel, 0, buffer.getReadPointer(channel, startSample), numSamples - overlap);
-					tempBuffer.copyFrom(channel, numSamples - overlap, buffer.getReadPointer(channel, 0), overlap);
-				}
-			}
-			else
-			{
-				for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
-				{
-					tempBuffer.copyFrom(channel, 0, buffer.getReadPointer(channel, startSample), numSamples);
-				}
-			}
-			writer->writeFromAudioSampleBuffer(tempBuffer, 0, numSamples);
-		}
+	auto request = makeExportRequest();
+	if (!request.matches(lastSelectionRequest))
+	{
+		lastSelectionRequest = request;
+		lastSelectionRequest.snapshot.reset();
+		selectionStableTicks = 0;
 	}
+	else if (++selectionStableTicks == prerenderDelayTicks)
+		exportCache.prerender(request);
+}
+
+bool ReSamplerAudioProcessorEditor::renderBuffer(const juce::AudioBuffer<float>& buffer, int startSample, int numSamples, double sampleRate, const juce::File& file)
+{
+	TRACE_ZONE("renderBuffer");
+	DBG("startSample: " << startSample << " numSamples: " << numSamples << " totalSamples: " << buffer.getNumSamples());
+	//跨越环形缓冲区末尾的选区直接分两段写入
+	if (AudioExport::writeRing(buffer, startSample, numSamples, sampleRate, properties.exportFormat, file))
+		return true;
+	//写入失败的文件不交给宿主
+	file.deleteFile();
+	return false;
 }
 
 void ReSamplerAudioProcessorEditor::timerCallback()
 {
-	if (waveform.getTotalLength() == 0.0)
-		waveform.setSource(audioProcessor.bufferManager->getBufferPointer(), audioProcessor.bufferManager->getBufferSampleRate(), audioProcessor.bufferManager->getBufferLength());
-	prepareWaveform();
+	TRACE_ZONE("timerCallback");
+	if (firstFrameMillis >= 0.0 && !openGLContext.isAttached())
+	{
+		openGLContext.attachTo(*this);
+		openGLContext.setContinuousRepainting(true);
+	}
+	prerenderSelection();
+	if (batchExportFolder != juce::File() && !audioProcessor.batchExporter->isRunning())
+	{
+		auto& exporter = *audioProcessor.batchExporter;
+		if (exporter.getNumFailed() > 0)
+			juce::AlertWindow::showMessageBoxAsync(juce::MessageBoxIconType::WarningIcon, "Export Regions",
+				juce::String(exporter.getNumFailed()) + " of " + juce::String(exporter.getNumRegions()) + " regions could not be written.");
+		if (exporter.getNumFailed() < exporter.getNumRegions())
+			batchExportFolder.revealToUser();
+		batchExportFolder = juce::File();
+	}
+	if (frozenSnapshot == nullptr)
+	{
+		juce::int64 updateStart = juce::Time::getHighResolutionTicks();
+		updateWaveformTiles();
+		if (properties.viewMode == ViewMode::SpectrogramView)
+			updateSpectrogramImages();
+		if (properties.showHud)
+			hud.addPhase(PerformanceHud::TileUpdate, juce::Time::getHighResolutionTicks() - updateStart);
+	}
 	repaint();
 }
 
@@ -448,15 +890,13 @@ void ReSamplerAudioProcessorEditor::mouseDown(const juce::MouseEvent& event)
 			{
 				audioProcessor.bufferManager->bufferState.isPlaying = true;
 				editorState.playSelected = true;
-				int realReadX = (editorState.startPosAbs + getWidth() - editorState.waveformOffsetAbs) % getWidth();
-				audioProcessor.bufferManager->bufferState.readPosition = static_cast<float>(realReadX) / getWidth() * audioProcessor.bufferManager->getBufferPointer()->getNumSamples();
+				audioProcessor.bufferManager->bufferState.readPosition = editorState.selectionStart;
 
 			}
 			else
 			{
 				audioProcessor.bufferManager->bufferState.isPlaying = true;
-				int realReadX = (event.getMouseDownX() + getWidth() - editorState.waveformOffsetAbs) % getWidth();
-				audioProcessor.bufferManager->bufferState.readPosition = static_cast<float>(realReadX) / getWidth() * audioProcessor.bufferManager->getBufferPointer()->getNumSamples();
+				audioProcessor.bufferManager->bufferState.readPosition = xToRingPosition(static_cast<float>(event.getMouseDownX()));
 			}
 		}
 	}
@@ -492,11 +932,40 @@ void ReSamplerAudioProcessorEditor::mouseDoubleClick(const juce::MouseEvent& eve
 {
 	if (event.mods.isLeftButtonDown() && event.eventComponent == this)
 	{
-		audioProcessor.bufferManager->bufferState.isRecording = !audioProcessor.bufferManager->bufferState.isRecording;
+		toggleSnapshot();
 		repaint();
 	}
 }
 
+void ReSamplerAudioProcessorEditor::toggleSnapshot()
+{
+	audioProcessor.bufferManager->bufferState.isPlaying = false;
+	editorState.playSelected = false;
+
+	if (frozenSnapshot == nullptr)
+	{
+		//冻结当前波形，录制在后台继续
+		frozenSnapshot = audioProcessor.bufferManager->takeSnapshot();
+		audioProcessor.bufferManager->setPlaybackSnapshot(frozenSnapshot);
+
+		//the summary is small, a plain copy keeps the frozen waveform consistent at every zoom level
+		if (frozenSnapshot != nullptr)
+		{
+			juce::ScopedLock lock(audioProcessor.waveformPyramid->getStorageLock());
+			frozenSummary = audioProcessor.waveformPyramid->getSummary();
+			tileCache.clear();
+		}
+	}
+	else
+	{
+		audioProcessor.bufferManager->setPlaybackSnapshot(nullptr);
+		frozenSnapshot.reset();
+
+		frozenSummary = WaveformSummary();
+		tileCache.clear();
+	}
+}
+
 void ReSamplerAudioProcessorEditor::mouseDrag(const juce::MouseEvent& event)
 {
 	editorState.mouseX = event.getMouseDownX() + event.getDistanceFromDragStartX();
@@ -508,16 +977,9 @@ void ReSamplerAudioProcessorEditor::mouseDrag(const juce::MouseEvent& event)
 			editorState.enableSelectArea = false;
 			editorState.playSelected = false;*/
 
+			//平移视图，选区以采样为单位，跟随波形移动
 			int deltaX = event.getDistanceFromDragStartX() - editorState.lastDragDistance;
-			editorState.waveformOffsetAbs += deltaX;
-			editorState.waveformOffsetAbs = (editorState.waveformOffsetAbs % getWidth() + getWidth()) % getWidth();
-			editorState.waveformOffset = static_cast<float>(editorState.waveformOffsetAbs) / getWidth();
-			if (editorState.enableSelectArea)
-			{
-				editorState.startPosAbs += deltaX;
-				editorState.startPosAbs = (editorState.startPosAbs % getWidth() + getWidth()) % getWidth();
-				editorState.startPos = static_cast<float>(editorState.startPosAbs) / getWidth();
-			}
+			setViewStart(editorState.viewStart - deltaX * getSamplesPerPixel());
 			editorState.lastDragDistance = event.getDistanceFromDragStartX();
 			repaint();
 		}
@@ -529,37 +991,72 @@ void ReSamplerAudioProcessorEditor::mouseDrag(const juce::MouseEvent& event)
 				{
 					editorState.dragFlag = false;
 
-					auto filePath = exportSelectedArea();
-					juce::StringArray files;
-					files.add(filePath);
-					juce::DragAndDropContainer::performExternalDragDropOfFiles(files, true);
+					//pre-rendered or previously exported audio is handed over as is
+					juce::File cached = exportCache.getOrRender(makeExportRequest());
+					auto filePath = cached.existsAsFile() ? cached.getFullPathName() : exportSelectedArea();
+					if (filePath.isNotEmpty())
+					{
+						juce::StringArray files;
+						files.add(filePath);
+						juce::DragAndDropContainer::performExternalDragDropOfFiles(files, true);
+					}
+					else
+						juce::AlertWindow::showMessageBoxAsync(juce::MessageBoxIconType::WarningIcon, "Export",
+							"The selection could not be exported, it was overwritten by recording, is still being restored from disk or the file could not be written.");
 					editorState.playSelected = false;
 					audioProcessor.bufferManager->bufferState.isPlaying = false;
 				}
 			}
 			else
 			{
-				if (event.getDistanceFromDragStartX() < 0)
+				int fromX = juce::jlimit(0, getWidth(), juce::jmin(event.getMouseDownX(), event.getMouseDownX() + event.getDistanceFromDragStartX()));
+				int toX = juce::jlimit(0, getWidth(), juce::jmax(event.getMouseDownX(), event.getMouseDownX() + event.getDistanceFromDragStartX()));
+				int ringSamples = getRingSamples();
+				juce::int64 start = ringToAbsolute(xToRingPosition(static_cast<float>(fromX)));
+				juce::int64 end = start + static_cast<juce::int64>(std::round((toX - fromX) * getSamplesPerPixel()));
+
+				//选区边缘吸附到最近的瞬态
+				if (properties.snapToTransients)
 				{
-					editorState.startPosAbs = event.getMouseDownX() + event.getDistanceFromDragStartX();
-					editorState.widthAbs = -event.getDistanceFromDragStartX();
+					juce::int64 snappedStart = snapToTransient(start);
+					juce::int64 snappedEnd = snapToTransient(end);
+					if (snappedEnd > snappedStart && snappedEnd - snappedStart <= ringSamples)
+					{
+						start = snappedStart;
+						end = snappedEnd;
+					}
 				}
-				else
+				//长度取整到整小节，方便循环; 有宿主小节线时直接吸附到小节线
+				auto grid = audioProcessor.tempoAnalyser->getGrid();
+				PlayheadIndex::Entry hostBar;
+				bool snappedToHost = false;
+				if (properties.snapToBars && audioProcessor.playheadIndex->getEntryAt(start, hostBar) && hostBar.isPlaying)
 				{
-					editorState.startPosAbs = event.getMouseDownX();
-					editorState.widthAbs = event.getDistanceFromDragStartX();
+					auto barSamples = static_cast<juce::int64>(hostBar.barLengthPpq / hostBar.ppqPerSample);
+					juce::int64 barStart = audioProcessor.playheadIndex->getNearestBarLine(start, barSamples);
+					juce::int64 barEnd = audioProcessor.playheadIndex->getNearestBarLine(end, barSamples);
+					if (barStart >= 0 && barEnd > barStart && barEnd - barStart <= ringSamples)
+					{
+						start = barStart;
+						end = barEnd;
+						snappedToHost = true;
+					}
 				}
-				if (editorState.startPosAbs < 0)
+				if (properties.snapToBars && !snappedToHost && grid.isValid())
 				{
-					editorState.widthAbs += editorState.startPosAbs;
-					editorState.startPosAbs = 0;
+					double barSamples = grid.getBarSamples();
+					double bars = juce::jmax(1.0, std::round((end - start) / barSamples));
+					while (bars > 1.0 && bars * barSamples > ringSamples)
+						bars -= 1.0;
+					if (!properties.snapToTransients)
+						start = grid.getNearestBeat(start);
+					end = start + static_cast<juce::int64>(std::llround(bars * barSamples));
 				}
-				if (editorState.startPosAbs + editorState.widthAbs >= getWidth())
-					editorState.widthAbs = getWidth() - editorState.startPosAbs;
-				editorState.startPos = static_cast<float>(editorState.startPosAbs) / getWidth();
-				editorState.width = static_cast<float>(editorState.widthAbs) / getWidth();
+				editorState.selectionStart = static_cast<int>(((start % ringSamples) + ringSamples) % ringSamples);
+				editorState.selectionLength = static_cast<int>(juce::jmin<juce::int64>(end - start, ringSamples));
 				editorState.enableSelectArea = true;
 				editorState.playSelected = false;
+				editorState.similarMatches.clear();
 				audioProcessor.bufferManager->bufferState.isPlaying = false;
 				repaint();
 			}
@@ -580,11 +1077,61 @@ void ReSamplerAudioProcessorEditor::mouseMove(const juce::MouseEvent& event)
 	}
 }
 
+void ReSamplerAudioProcessorEditor::mouseWheelMove(const juce::MouseEvent& event, const juce::MouseWheelDetails& wheel)
+{
+	if (event.eventComponent != this)
+		return;
+
+	float x = static_cast<float>(event.getPosition().getX());
+	if (wheel.deltaX != 0.0f || event.mods.isShiftDown())
+	{
+		//水平滚动或Shift+滚轮平移
+		float delta = wheel.deltaX != 0.0f ? wheel.deltaX : wheel.deltaY;
+		setViewStart(editorState.viewStart - delta * getWidth() * 0.5 * getSamplesPerPixel());
+	}
+	else
+	{
+		//滚轮缩放，以鼠标位置为中心
+		zoomAround(x, getSamplesPerPixel() * std::exp(-wheel.deltaY * 4.0));
+	}
+	repaint();
+}
+
+bool ReSamplerAudioProcessorEditor::keyPressed(const juce::KeyPress& key)
+{
+	//M在鼠标位置添加标记，Delete删除鼠标附近的标记
+	float x = static_cast<float>(editorState.mouseIn ? editorState.mouseX : ringPositionToX(audioProcessor.bufferManager->bufferState.writePosition));
+	if (key.getTextCharacter() == 'm' || key.getTextCharacter() == 'M')
+	{
+		addMarker(x);
+		return true;
+	}
+	if (key == juce::KeyPress::deleteKey || key == juce::KeyPress::backspaceKey)
+	{
+		removeMarker(x);
+		return true;
+	}
+	//F查找与选区相似的片段
+	if (key.getTextCharacter() == 'f' || key.getTextCharacter() == 'F')
+	{
+		findSimilar();
+		return true;
+	}
+	return false;
+}
+
 void ReSamplerAudioProcessorEditor::menuButtonClicked()
 {
 	juce::PopupMenu menu;
 	juce::PopupMenu theme;
 	juce::PopupMenu bufferLength;
+	juce::PopupMenu view;
+	juce::PopupMenu sampler;
+	juce::PopupMenu diagnostics;
+	juce::PopupMenu archive;
+	juce::PopupMenu archiveQuota;
+	juce::PopupMenu markers;
+	juce::PopupMenu exportFormat;
 
 	theme.addItem("Rainbow", true, properties.theme == Theme::Rainbow, [this] {setTheme(Theme::Rainbow); });
 	theme.addItem("Dark", true, properties.theme == Theme::Dark, [this] {setTheme(Theme::Dark); });
@@ -599,8 +1146,68 @@ void ReSamplerAudioProcessorEditor::menuButtonClicked()
 	bufferLength.addItem("5min", true, audioProcessor.bufferManager->getBufferLength() == 300, [this] {setBufferLength(300); });
 	//bufferLength.addItem("10min", true, audioProcessor.bufferManager->getBufferLength() == 600, [this] {setBufferLength(600); });
 
+	view.addItem("Waveform", true, properties.viewMode == ViewMode::WaveformView, [this] {setViewMode(ViewMode::WaveformView); });
+	view.addItem("Spectrogram", true, properties.viewMode == ViewMode::SpectrogramView, [this] {setViewMode(ViewMode::SpectrogramView); });
+	view.addItem("Tracks", true, properties.viewMode == ViewMode::TracksView, [this] {setViewMode(ViewMode::TracksView); });
+	view.addItem("ExportTrackSelection", properties.viewMode == ViewMode::TracksView && trackBrowser.hasSelection() && !trackBrowser.isExporting(), false, [this] {exportTracks(); });
+	view.addSeparator();
+	view.addItem("SnapToTransients", true, properties.snapToTransients, [this] {setSnapToTransients(!properties.snapToTransients); });
+	auto grid = audioProcessor.tempoAnalyser->getGrid();
+	PlayheadIndex::Entry hostPosition;
+	juce::String snapLabel("SnapToBars");
+	if (audioProcessor.playheadIndex->getEntryAt(audioProcessor.bufferManager->getTotalSamplesWritten(), hostPosition))
+		snapLabel << " (host " << hostPosition.numerator << "/" << hostPosition.denominator << ", " << juce::String(hostPosition.bpm, 1) << " BPM)";
+	else if (grid.isValid())
+		snapLabel << " (" << juce::String(grid.bpm, 1) << " BPM)";
+	view.addItem(snapLabel, true, properties.snapToBars, [this] {setSnapToBars(!properties.snapToBars); });
+	view.addSeparator();
+	view.addItem("FindSimilar (F)", editorState.enableSelectArea && editorState.selectionLength > 0, false, [this] {findSimilar(); });
+	view.addItem("ClearSimilar", !editorState.similarMatches.isEmpty(), false, [this] {editorState.similarMatches.clear(); repaint(); });
+
+	sampler.addItem("LoadSelection", editorState.enableSelectArea && editorState.selectionLength > 0, false, [this] {loadSelectionToSampler(); });
+	sampler.addItem("Clear", audioProcessor.sliceSampler->getNumSlices() > 0, false, [this] {audioProcessor.sliceSampler->clearSlices(); });
+
+	markers.addItem("AddAtPlayhead", [this] {addMarker(ringPositionToX(frozenSnapshot != nullptr ? frozenSnapshot->getWritePosition() : audioProcessor.bufferManager->bufferState.writePosition)); });
+	markers.addItem("ExportRegions", editorState.markers.size() > 1 && !audioProcessor.batchExporter->isRunning(), false, [this] {exportMarkerRegions(); });
+	markers.addItem("CancelExport", audioProcessor.batchExporter->isRunning(), false, [this] {audioProcessor.batchExporter->cancel(); });
+	markers.addItem("Clear", !editorState.markers.isEmpty(), false, [this] {editorState.markers.clear(); repaint(); });
+	markers.addSeparator();
+	markers.addItem("ExportLast8Bars", audioProcessor.playheadIndex->hasData(), false, [this] {exportLastBars(8); });
+
+	diagnostics.addItem("CallbackTiming", [this] {showCallbackTiming(); });
+	diagnostics.addItem("DumpCallbackTiming", [this] {dumpCallbackTiming(); });
+	diagnostics.addItem("ResetCallbackTiming", [this] {audioProcessor.callbackProfiler->reset(); });
+	diagnostics.addItem("PerformanceHud", true, properties.showHud, [this] {properties.showHud = !properties.showHud; saveState(); repaint(); });
+	diagnostics.addSeparator();
+	diagnostics.addItem("Trace", true, Tracer::getInstance().isEnabled(), [this] {toggleTracing(); });
+
+	for (int quota : { 1, 5, 20, 100 })
+		archiveQuota.addItem(juce::String(quota) + "GB", true, audioProcessor.archiver->getQuota() == (static_cast<juce::int64>(quota) << 30), [this, quota] {setArchiveQuota(quota); });
+	archive.addItem("Enabled", true, audioProcessor.archiver->isEnabled(), [this] {setArchiveEnabled(!audioProcessor.archiver->isEnabled()); });
+	archive.addSubMenu("Quota", archiveQuota);
+	archive.addItem("ExportLast10Minutes", [this] {exportArchive(10 * 60); });
+	archive.addItem("OpenFolder", [this] {audioProcessor.archiver->getArchiveFolder().revealToUser(); });
+	archive.addSeparator();
+	archive.addItem("CaptureBounces", true, audioProcessor.bounceCapture->isEnabled(), [this] {setCaptureBounces(!audioProcessor.bounceCapture->isEnabled()); });
+	archive.addItem("RevealLastBounce", audioProcessor.bounceCapture->getLastFile().existsAsFile(), false, [this] {audioProcessor.bounceCapture->getLastFile().revealToUser(); });
+	archive.addItem("RevealLastCapture (" + juce::String(audioProcessor.triggeredCapture->getNumWritten()) + ")", audioProcessor.triggeredCapture->getLastFile().existsAsFile(), false, [this] {audioProcessor.triggeredCapture->getLastFile().revealToUser(); });
+
 	menu.addSubMenu("BufferLength", bufferLength);
 	menu.addSubMenu("Theme", theme);
+	menu.addSubMenu("View", view);
+	menu.addSubMenu("Sampler", sampler);
+	menu.addSubMenu("Markers", markers);
+	menu.addSubMenu("Archive", archive);
+	for (int format = 0; format < numExportFormats; format++)
+		exportFormat.addItem(AudioExport::getFormatName(static_cast<ExportFormat>(format)), true, properties.exportFormat == format,
+			[this, format] {setExportFormat(static_cast<ExportFormat>(format)); });
+	menu.addSubMenu("ExportFormat", exportFormat);
+	menu.addSubMenu("Diagnostics", diagnostics);
+	menu.addItem(audioProcessor.bufferManager->isSharedMemoryEnabled() ? "SharedMemory (" + audioProcessor.bufferManager->getSharedMemoryName() + ")" : juce::String("SharedMemory"),
+		SharedHistory::isSupported(), audioProcessor.bufferManager->isSharedMemoryEnabled(), [this] {setSharedMemoryEnabled(!audioProcessor.bufferManager->isSharedMemoryEnabled()); });
+	bool hibernates = propertiesFile->getIntValue("hibernateAfterSeconds", IdleHibernator::defaultTimeoutSeconds) > 0;
+	menu.addItem("HibernateWhenIdle (" + juce::String(audioProcessor.idleHibernator->getNumHibernations()) + ")", true, hibernates,
+		[this, hibernates] {propertiesFile->setValue("hibernateAfterSeconds", hibernates ? 0 : IdleHibernator::defaultTimeoutSeconds); propertiesFile->saveIfNeeded(); });
 	menu.addItem("SetRecordingPath", [this] {setRecordingPath(); });
 
 	menu.showMenuAsync(juce::PopupMenu::Options());
@@ -612,17 +1219,19 @@ void ReSamplerAudioProcessorEditor::setBufferLength(int length)
 		return;
 
 	audioProcessor.bufferManager->bufferState.isPlaying = false;
-	editorState.startPos = 0.0f;
-	editorState.width = 0.0f;
-	editorState.waveformOffset = 0.0f;
-	editorState.startPosAbs = 0;
-	editorState.widthAbs = 0;
-	editorState.waveformOffsetAbs = 0;
+	audioProcessor.bufferManager->setPlaybackSnapshot(nullptr);
+	frozenSnapshot.reset();
+	editorState.viewStart = 0.0;
+	editorState.samplesPerPixel = 0.0;
+	editorState.selectionStart = 0;
+	editorState.selectionLength = 0;
 	editorState.enableSelectArea = false;
 	editorState.playSelected = false;
+	editorState.markers.clear();
+	editorState.similarMatches.clear();
 
 	audioProcessor.bufferManager->setBufferLength(length);
-	waveform.setSource(audioProcessor.bufferManager->getBufferPointer(), audioProcessor.bufferManager->getBufferSampleRate(), length);
+	tileCache.clear();
 
 	saveState();
 	repaint();
@@ -633,10 +1242,279 @@ void ReSamplerAudioProcessorEditor::setTheme(Theme theme)
 	if (properties.theme == theme)
 		return;
 	properties.theme = theme;
+	buildSpectrogramPalette();
+	saveState();
+	repaint();
+}
+
+void ReSamplerAudioProcessorEditor::setViewMode(ViewMode viewMode)
+{
+	if (properties.viewMode == viewMode)
+		return;
+	properties.viewMode = viewMode;
+	trackBrowser.setVisible(viewMode == ViewMode::TracksView);
+	saveState();
+	repaint();
+}
+
+void ReSamplerAudioProcessorEditor::setSnapToTransients(bool shouldSnap)
+{
+	properties.snapToTransients = shouldSnap;
+	saveState();
+	repaint();
+}
+
+void ReSamplerAudioProcessorEditor::setSnapToBars(bool shouldSnap)
+{
+	properties.snapToBars = shouldSnap;
 	saveState();
 	repaint();
 }
 
+void ReSamplerAudioProcessorEditor::setExportFormat(ExportFormat format)
+{
+	//拖拽、标记、归档和多轨导出都使用这个格式
+	properties.exportFormat = format;
+	saveState();
+}
+
+void ReSamplerAudioProcessorEditor::loadSelectionToSampler()
+{
+	//选区按瞬态切片，MIDI音符从C1开始依次触发各个切片
+	//冻结时从快照读取，否则按绝对位置读取历史，被录音覆盖的选区不加载
+	int numSamples = editorState.selectionLength;
+	juce::int64 start = ringToAbsolute(editorState.selectionStart);
+	juce::AudioBuffer<float> audio(audioProcessor.bufferManager->getBufferNumChannels(), numSamples);
+	if (frozenSnapshot != nullptr)
+		audioProcessor.bufferManager->readFromSnapshot(*frozenSnapshot, audio, editorState.selectionStart, numSamples);
+	else if (!audioProcessor.bufferManager->readHistory(start, audio, 0, numSamples))
+	{
+		juce::AlertWindow::showMessageBoxAsync(juce::MessageBoxIconType::WarningIcon, "Load To Sampler",
+			"The selection was overwritten by recording or is still being restored from disk, try again or select a more recent range.");
+		return;
+	}
+	juce::Array<juce::int64> onsets;
+	audioProcessor.onsetDetector->getOnsets(start, start + numSamples, onsets);
+
+	juce::Array<int> sliceStarts;
+	sliceStarts.add(0);
+	for (auto onset : onsets)
+	{
+		//skip onsets too close to the previous slice to be worth a key
+		if (onset - start - sliceStarts.getLast() > SliceSampler::fadeSamples * 2)
+			sliceStarts.add(static_cast<int>(onset - start));
+	}
+
+	audioProcessor.sliceSampler->loadSlices(audio, numSamples, sliceStarts);
+}
+
+void ReSamplerAudioProcessorEditor::addMarker(float x)
+{
+	juce::int64 marker = ringToAbsolute(xToRingPosition(x));
+	if (properties.snapToTransients)
+		marker = snapToTransient(marker);
+	juce::DefaultElementComparator<juce::int64> comparator;
+	if (!editorState.markers.contains(marker))
+		editorState.markers.addSorted(comparator, marker);
+	repaint();
+}
+
+void ReSamplerAudioProcessorEditor::removeMarker(float x)
+{
+	juce::int64 position = ringToAbsolute(xToRingPosition(x));
+	auto maxDistance = static_cast<juce::int64>(std::ceil(8.0 * getSamplesPerPixel()));
+	int nearest = -1;
+	for (int i = 0; i < editorState.markers.size(); i++)
+	{
+		juce::int64 distance = std::abs(editorState.markers[i] - position);
+		if (distance <= maxDistance && (nearest < 0 || distance < std::abs(editorState.markers[nearest] - position)))
+			nearest = i;
+	}
+	if (nearest >= 0)
+	{
+		editorState.markers.remove(nearest);
+		repaint();
+	}
+}
+
+void ReSamplerAudioProcessorEditor::exportMarkerRegions()
+{
+	//标记之间的每一段各导出一个文件，冻结时导出冻结的内容，否则导出当前的历史
+	std::shared_ptr<BufferSnapshot> snapshot = frozenSnapshot != nullptr ? frozenSnapshot : audioProcessor.bufferManager->takeSnapshot();
+	if (snapshot == nullptr)
+	{
+		juce::AlertWindow::showMessageBoxAsync(juce::MessageBoxIconType::WarningIcon, "Export Regions",
+			"All " + juce::String(BufferManager::maxSnapshots) + " snapshots are in use or the history is still being restored from disk, try again once an export has finished.");
+		return;
+	}
+
+	int ringSamples = snapshot->getNumSamples();
+	juce::int64 written = snapshot->getSamplesWritten();
+	juce::int64 oldest = juce::jmax<juce::int64>(0, written - ringSamples);
+
+	juce::String timestamp = juce::Time::getCurrentTime().formatted("%Y%m%d_%H%M%S");
+	juce::File folder = juce::File(properties.recordingPath).getChildFile("TKRS_regions_" + timestamp);
+
+	juce::Array<BatchExporter::Region> regions;
+	for (int i = 0; i + 1 < editorState.markers.size(); i++)
+	{
+		juce::int64 start = juce::jmax(editorState.markers[i], oldest);
+		juce::int64 end = juce::jmin(editorState.markers[i + 1], written);
+		if (end <= start)
+			continue;
+
+		BatchExporter::Region region;
+		region.ringStart = static_cast<int>(start % ringSamples);
+		region.numSamples = static_cast<int>(end - start);
+		region.file = folder.getChildFile("TKRS_region_" + juce::String(i + 1).paddedLeft('0', 2) + AudioExport::getFileExtension(properties.exportFormat));
+		regions.add(region);
+	}
+
+	if (regions.isEmpty() || !folder.createDirectory())
+		return;
+	if (audioProcessor.batchExporter->start(*audioProcessor.bufferManager, snapshot, regions, audioProcessor.bufferManager->getBufferSampleRate(), properties.exportFormat))
+		batchExportFolder = folder;
+}
+
+void ReSamplerAudioProcessorEditor::exportLastBars(int numBars)
+{
+	//按宿主的小节线导出最后几个完整小节，中途变速也准确
+	int ringSamples = getRingSamples();
+	juce::int64 written = frozenSnapshot != nullptr ? frozenSnapshot->getSamplesWritten() : audioProcessor.bufferManager->getTotalSamplesWritten();
+	juce::int64 start = 0;
+	juce::int64 end = 0;
+	if (!audioProcessor.playheadIndex->getLastBars(numBars, juce::jmax<juce::int64>(0, written - ringSamples), written, start, end))
+		return;
+
+	//冻结时从快照读取，否则按绝对位置读取历史，复制途中被录音覆盖则放弃
+	int numSamples = static_cast<int>(end - start);
+	juce::AudioBuffer<float> audio(audioProcessor.bufferManager->getBufferNumChannels(), numSamples);
+	if (frozenSnapshot != nullptr)
+		audioProcessor.bufferManager->readFromSnapshot(*frozenSnapshot, audio, static_cast<int>(start % ringSamples), numSamples);
+	else if (!audioProcessor.bufferManager->readHistory(start, audio, 0, numSamples))
+	{
+		juce::AlertWindow::showMessageBoxAsync(juce::MessageBoxIconType::WarningIcon, "Export Last Bars",
+			"The bars were overwritten by recording or are still being restored from disk, try again or export fewer bars.");
+		return;
+	}
+
+	juce::String timestamp = juce::Time::getCurrentTime().formatted("%Y%m%d_%H%M%S");
+	juce::File file = juce::File(properties.recordingPath).getChildFile("TKRS_" + juce::String(numBars) + "bars_" + timestamp + AudioExport::getFileExtension(properties.exportFormat));
+	if (renderBuffer(audio, 0, numSamples, audioProcessor.bufferManager->getBufferSampleRate(), file))
+		file.revealToUser();
+	else
+		juce::AlertWindow::showMessageBoxAsync(juce::MessageBoxIconType::WarningIcon, "Export Last Bars", "Cannot write " + file.getFullPathName());
+}
+
+void ReSamplerAudioProcessorEditor::findSimilar()
+{
+	//用指纹索引查找选区在历史中的其他出现位置
+	editorState.similarMatches.clear();
+	if (editorState.enableSelectArea && editorState.selectionLength > 0)
+	{
+		juce::int64 start = ringToAbsolute(editorState.selectionStart);
+		juce::Array<FingerprintIndex::Match> matches;
+		audioProcessor.fingerprintIndex->findSimilar(start, start + editorState.selectionLength, matches);
+		for (auto& match : matches)
+			editorState.similarMatches.add(match.startSample);
+	}
+	repaint();
+}
+
+void ReSamplerAudioProcessorEditor::showCallbackTiming()
+{
+	juce::AlertWindow::showMessageBoxAsync(juce::MessageBoxIconType::InfoIcon, "Callback Timing", audioProcessor.callbackProfiler->toText());
+}
+
+void ReSamplerAudioProcessorEditor::dumpCallbackTiming()
+{
+	juce::String timestamp = juce::Time::getCurrentTime().formatted("%Y%m%d_%H%M%S");
+
+	juce::File file = juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory).getChildFile("ReSampler").getChildFile("TKRS_callback_" + timestamp + ".txt");
+	if (audioProcessor.callbackProfiler->dumpToFile(file))
+		file.revealToUser();
+}
+
+void ReSamplerAudioProcessorEditor::toggleTracing()
+{
+	auto& tracer = Tracer::getInstance();
+	if (!tracer.isEnabled())
+	{
+		tracer.start();
+		return;
+	}
+
+	juce::String timestamp = juce::Time::getCurrentTime().formatted("%Y%m%d_%H%M%S");
+
+	//在chrome://tracing或ui.perfetto.dev中打开
+	juce::File file = juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory).getChildFile("ReSampler").getChildFile("TKRS_trace_" + timestamp + ".json");
+	if (tracer.stop(file))
+		file.revealToUser();
+}
+
+void ReSamplerAudioProcessorEditor::setArchiveEnabled(bool shouldArchive)
+{
+	audioProcessor.archiver->setEnabled(shouldArchive);
+	propertiesFile->setValue("archiveEnabled", shouldArchive);
+	propertiesFile->saveIfNeeded();
+}
+
+void ReSamplerAudioProcessorEditor::setArchiveQuota(int gigabytes)
+{
+	audioProcessor.archiver->setQuota(static_cast<juce::int64>(gigabytes) << 30);
+	propertiesFile->setValue("archiveQuotaGB", gigabytes);
+	propertiesFile->saveIfNeeded();
+}
+
+void ReSamplerAudioProcessorEditor::setCaptureBounces(bool shouldCapture)
+{
+	//离线渲染时把整段输出直接写到录音目录，不受缓冲区长度限制
+	audioProcessor.bounceCapture->setEnabled(shouldCapture);
+	propertiesFile->setValue("captureBounces", shouldCapture);
+	propertiesFile->saveIfNeeded();
+}
+
+void ReSamplerAudioProcessorEditor::exportArchive(int seconds)
+{
+	//从归档中导出最近一段时间的音频，正在写入的分段不包含在内
+	//在后台逐段解码写入，完成后回到消息线程打开文件夹
+	int sampleRate = audioProcessor.bufferManager->getBufferSampleRate();
+	juce::int64 startMillis = juce::Time::currentTimeMillis() - static_cast<juce::int64>(seconds) * 1000;
+	juce::File file = juce::File(properties.recordingPath).getChildFile("TKRS_archive_" + juce::Time(startMillis).formatted("%Y%m%d_%H%M%S") + AudioExport::getFileExtension(properties.exportFormat));
+	audioProcessor.archiver->exportToFile(startMillis, static_cast<juce::int64>(seconds) * sampleRate, sampleRate, audioProcessor.bufferManager->getBufferNumChannels(),
+		properties.exportFormat, file, [file](juce::int64 numFound)
+		{
+			if (numFound > 0)
+				file.revealToUser();
+		});
+}
+
+void ReSamplerAudioProcessorEditor::setSharedMemoryEnabled(bool shouldShare)
+{
+	//把缓冲区放进命名共享内存，供本机其他进程读取，见Tools/SharedHistoryReader
+	bool shared = audioProcessor.bufferManager->setSharedMemoryEnabled(shouldShare) && shouldShare;
+	propertiesFile->setValue("sharedMemory", shared);
+	propertiesFile->saveIfNeeded();
+}
+
+void ReSamplerAudioProcessorEditor::exportTracks()
+{
+	//多轨选区一次导出，每个轨道一个文件
+	juce::String timestamp = juce::Time::getCurrentTime().formatted("%Y%m%d_%H%M%S");
+
+	//在后台线程导出，完成后回到消息线程提示
+	juce::File folder = juce::File(properties.recordingPath).getChildFile("TKRS_tracks_" + timestamp);
+	trackBrowser.onExportFinished = [folder](int numExported, int numLapped)
+		{
+			if (numLapped > 0)
+				juce::AlertWindow::showMessageBoxAsync(juce::MessageBoxIconType::WarningIcon, "Export Tracks",
+					juce::String(numLapped) + " of " + juce::String(numExported) + " tracks were overwritten by recording while exporting, select a more recent range.");
+			if (numExported > 0)
+				folder.revealToUser();
+		};
+	trackBrowser.exportSelection(folder, properties.exportFormat);
+}
+
 void ReSamplerAudioProcessorEditor::setRecordingPath()
 {
 	fileChooser = std::make_unique<juce::FileChooser>("Select a folder to save recordings",
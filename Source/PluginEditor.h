@@ -10,6 +10,11 @@
 
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
+#include "WaveformTileCache.h"
+#include "PerformanceHud.h"
+#include "ExportCache.h"
+#include "TrackBrowser.h"
+#include "AudioExport.h"
 
 //==============================================================================
 /**
@@ -22,20 +27,39 @@ enum Theme
 	Matrix
 };
 
+enum ViewMode
+{
+	WaveformView,
+	SpectrogramView,
+	TracksView
+};
+
 struct Properties
 {
 	juce::String recordingPath;
 	Theme theme = Rainbow;
+	ViewMode viewMode = WaveformView;
+	bool snapToTransients = true;
+	bool snapToBars = false;
+	bool showHud = false;
+	ExportFormat exportFormat = Wav24;
 };
 
 struct EditorState
 {
-	float startPos = 0.0f;
-	float width = 0.0f;
-	float waveformOffset = 0.0f;
-	int startPosAbs = 0;
-	int widthAbs = 0;
-	int waveformOffsetAbs = 0;
+	//viewport, viewStart is the ring position at the left edge, samplesPerPixel <= 0 fits the whole ring
+	double viewStart = 0.0;
+	double samplesPerPixel = 0.0;
+
+	//selection in ring positions, may wrap past the end of the ring
+	int selectionStart = 0;
+	int selectionLength = 0;
+
+	//region markers as absolute sample positions, kept sorted
+	juce::Array<juce::int64> markers;
+
+	//other occurrences of the selection as absolute sample positions, same length as the selection
+	juce::Array<juce::int64> similarMatches;
 
 	int lastDragDistance = 0;
 	int mouseX = 0;
@@ -72,18 +96,44 @@ public:
 	void resized() override;
 
 private:
+	//Tools/EditorBenchmark drives the timer, theme and buffer length directly
+	friend struct EditorBenchmark;
+
 	void paintRainbow(juce::Graphics& g, int recLineX, int playLineX);
 	void paintDark(juce::Graphics& g, int recLineX, int playLineX);
 	void paintLight(juce::Graphics& g, int recLineX, int playLineX);
 	void paintMatrix(juce::Graphics& g, int recLineX, int playLineX);
+	void drawSpectrogram(juce::Graphics& g);
+	void updateSpectrogramImages();
+	void buildSpectrogramPalette();
+	void drawHud(juce::Graphics& g);
 
 	void manageProperties();
+	void recordFirstFrame();
 	void saveState();
 	void loadState();
-	void prepareWaveform();
+	void updateWaveformTiles();
+	void readRingRange(int ringStart, int numSamples, juce::AudioBuffer<float>& dest);
 	bool isInSelectedArea(const int pos);
+	int getRingSamples() const;
+	double getSamplesPerPixel() const;
+	int xToRingPosition(float x) const;
+	float ringPositionToX(int ringPosition) const;
+	juce::int64 ringToAbsolute(int ringPosition) const;
+	juce::int64 snapToTransient(juce::int64 position) const;
+	void drawTransients(juce::Graphics& g);
+	void drawMarkers(juce::Graphics& g);
+	void drawSimilar(juce::Graphics& g);
+	void drawBeatGrid(juce::Graphics& g);
+	void drawBarGrid(juce::Graphics& g);
+	void drawExportProgress(juce::Graphics& g);
+	void zoomAround(float x, double samplesPerPixel);
+	void setViewStart(double position);
+	void toggleSnapshot();
 	juce::String exportSelectedArea();
-	void renderBuffer(const juce::AudioBuffer<float>& buffer, int startSample, int numSamples, double sampleRate, const juce::File& file);
+	ExportCache::Request makeExportRequest() const;
+	void prerenderSelection();
+	bool renderBuffer(const juce::AudioBuffer<float>& buffer, int startSample, int numSamples, double sampleRate, const juce::File& file);
 
 	void timerCallback() override;
 	void mouseDown(const juce::MouseEvent& event) override;
@@ -93,31 +143,66 @@ private:
 	void mouseEnter(const juce::MouseEvent& event) override { editorState.mouseIn = true; };
 	void mouseExit(const juce::MouseEvent& event) override { editorState.mouseIn = false; editorState.mouseX = 0; };
 	void mouseMove(const juce::MouseEvent& event) override;
+	void mouseWheelMove(const juce::MouseEvent& event, const juce::MouseWheelDetails& wheel) override;
+	bool keyPressed(const juce::KeyPress& key) override;
 	void menuButtonClicked();
 
 	void setBufferLength(int length);
 	void setTheme(Theme theme);
+	void setViewMode(ViewMode viewMode);
+	void setSnapToTransients(bool shouldSnap);
+	void setSnapToBars(bool shouldSnap);
+	void setExportFormat(ExportFormat format);
+	void loadSelectionToSampler();
+	void addMarker(float x);
+	void removeMarker(float x);
+	void exportMarkerRegions();
+	void exportLastBars(int numBars);
+	void findSimilar();
+	void showCallbackTiming();
+	void dumpCallbackTiming();
+	void toggleTracing();
+	void setArchiveEnabled(bool shouldArchive);
+	void setArchiveQuota(int gigabytes);
+	void exportArchive(int seconds);
+	void setCaptureBounces(bool shouldCapture);
+	void setSharedMemoryEnabled(bool shouldShare);
+	void exportTracks();
 	void setRecordingPath();
 
-	void newOpenGLContextCreated() override { };
-	void renderOpenGL() override { };
+	void newOpenGLContextCreated() override;
+	void renderOpenGL() override;
 	void openGLContextClosing() override { };
 
+	//editor construction, for the time to the first frame
+	juce::int64 openedTicks = juce::Time::getHighResolutionTicks();
+	double firstFrameMillis = -1.0;
 	juce::OpenGLContext openGLContext;
 
 	ReSamplerAudioProcessor& audioProcessor;
 	juce::ComponentBoundsConstrainer constrainer;
-	std::unique_ptr<juce::PropertiesFile> propertiesFile;
+	juce::PropertiesFile* propertiesFile = nullptr;
 	Properties properties;
 	EditorState editorState;
 	ColourScheme colourScheme;
-	int offset = 0;
-
-	juce::AudioThumbnailCache thumbnailCache{ 6 };
-	juce::AudioFormatManager formatManager;
-	juce::AudioThumbnail waveform{ 44100, formatManager, thumbnailCache };
-
+	std::shared_ptr<BufferSnapshot> frozenSnapshot;
+
+	WaveformTileCache& tileCache;
+	PerformanceHud hud;
+	ExportCache exportCache;
+	ExportCache::Request lastSelectionRequest;
+	int selectionStableTicks = 0;
+	static constexpr int prerenderDelayTicks = 10;
+	WaveformSummary frozenSummary;
+
+	std::vector<juce::Image> spectrogramImages;
+	std::vector<juce::uint32> spectrogramImageVersions;
+	int spectrogramLayout = -1;
+	juce::Colour spectrogramPalette[256];
+
+	TrackBrowser trackBrowser;
 	juce::TextButton menuButton{ "Menu" };
 	std::unique_ptr<juce::FileChooser> fileChooser;
+	juce::File batchExportFolder;
 	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ReSamplerAudioProcessorEditor)
 };
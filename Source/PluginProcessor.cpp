@@ -26,10 +26,50 @@ ReSamplerAudioProcessor::ReSamplerAudioProcessor()
     if (!ReSamplerFolder.exists())
 		ReSamplerFolder.createDirectory();
 	bufferManager = std::make_unique<BufferManager>();
+	callbackProfiler = std::make_unique<CallbackProfiler>();
+	bufferManager->setProfiler(callbackProfiler.get());
+	spectrogram = std::make_unique<Spectrogram>();
+	waveformPyramid = std::make_unique<WaveformPyramid>();
+	onsetDetector = std::make_unique<OnsetDetector>();
+	tempoAnalyser = std::make_unique<TempoAnalyser>();
+	fingerprintIndex = std::make_unique<FingerprintIndex>();
+	playheadIndex = std::make_unique<PlayheadIndex>();
+	historyAnalyser = std::make_unique<HistoryAnalyser>(*bufferManager);
+	historyAnalyser->addStage(spectrogram.get());
+	historyAnalyser->addStage(waveformPyramid.get());
+	historyAnalyser->addStage(onsetDetector.get());
+	historyAnalyser->addStage(tempoAnalyser.get());
+	historyAnalyser->addStage(fingerprintIndex.get());
+	sliceSampler = std::make_unique<SliceSampler>();
+	//所有设置都来自进程共享的同一个设置文件
+	auto& settings = editorResources->getSettings();
+	if (settings.getBoolValue("sharedMemory", false))
+		bufferManager->setSharedMemoryEnabled(true);
+	archiver = std::make_unique<Archiver>(*bufferManager, settings);
+	batchExporter = std::make_unique<BatchExporter>();
+	bounceCapture = std::make_unique<BounceCapture>(settings);
+	tileCache = std::make_unique<WaveformTileCache>();
+	triggeredCapture = std::make_unique<TriggeredCapture>(*bufferManager, settings);
+
+	addParameter(captureTrigger = new juce::AudioParameterBool({ "capture", 1 }, "Capture", false));
+	addParameter(captureSeconds = new juce::AudioParameterFloat({ "captureSeconds", 1 }, "Capture Seconds", juce::NormalisableRange<float>(1.0f, 600.0f, 1.0f), 30.0f));
+	addParameter(captureSincePrevious = new juce::AudioParameterBool({ "captureSincePrevious", 1 }, "Capture Since Previous", false));
+	//-1 turns a MIDI trigger off
+	captureTriggerNote = settings.getIntValue("captureTriggerNote", 24);
+	captureTriggerController = settings.getIntValue("captureTriggerCC", 102);
+	idleHibernator = std::make_unique<IdleHibernator>(*bufferManager, settings);
+	instanceId = InstanceRegistry::getInstance().add(*bufferManager, *waveformPyramid);
 }
 
 ReSamplerAudioProcessor::~ReSamplerAudioProcessor()
 {
+	InstanceRegistry::getInstance().remove(instanceId);
+	historyAnalyser.reset();
+	archiver.reset();
+	batchExporter.reset();
+	bounceCapture.reset();
+	triggeredCapture.reset();
+	idleHibernator.reset();
 }
 
 //==============================================================================
@@ -97,7 +137,10 @@ void ReSamplerAudioProcessor::changeProgramName (int index, const juce::String&
 //==============================================================================
 void ReSamplerAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
-	bufferManager->initializeBuffer(getTotalNumInputChannels(), sampleRate);
+	bufferManager->initializeBuffer(getTotalNumInputChannels(), sampleRate, editorResources->getSettings().getIntValue("bufferLength", 30));
+	bufferManager->setMaximumBlockSize(samplesPerBlock);
+	sliceSampler->prepareToPlay(samplesPerBlock);
+	idleHibernator->setSuspended(false);
     // Use this method as the place to do any pre-playback
     // initialisation that you need..
 }
@@ -106,6 +149,9 @@ void ReSamplerAudioProcessor::releaseResources()
 {
     // When playback stops, you can use this as an opportunity to free up any
     // spare memory, etc.
+	bounceCapture->finish();
+	//挂起的实例几秒后把历史写到磁盘并释放内存
+	idleHibernator->setSuspended(true);
 }
 
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -137,6 +183,8 @@ bool ReSamplerAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts
 void ReSamplerAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
     juce::ScopedNoDenormals noDenormals;
+    auto callbackStart = juce::Time::getHighResolutionTicks();
+	TRACE_ZONE("processBlock");
     auto totalNumInputChannels  = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
 
@@ -149,8 +197,107 @@ void ReSamplerAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, ju
 
     //    // ..do something to the data...
     //}
+	//离线渲染: 大块流式写入, 可选整段录制到文件
+	bool offline = isNonRealtime();
+	bufferManager->setOfflineMode(offline);
+	//宿主的小节/速度信息，与缓冲区的绝对位置对齐
+	if (bufferManager->bufferState.isRecording)
+		if (auto* playHead = getPlayHead())
+			if (auto position = playHead->getPosition())
+				playheadIndex->record(bufferManager->getRingGeneration(), bufferManager->getTotalSamplesWritten(), *position, getSampleRate());
+	idleHibernator->setBypassed(false);
+	idleHibernator->blockProcessed(buffer, totalNumInputChannels);
+	juce::int64 blockStart = bufferManager->getTotalSamplesWritten();
 	bufferManager->writeToBuffer(buffer);
+	advanceSampleClock(blockStart, buffer.getNumSamples());
+	handleCaptureTriggers(blockStart, buffer.getNumSamples(), midiMessages);
+	if (offline)
+		bounceCapture->write(buffer, totalNumInputChannels, getSampleRate());
 	bufferManager->readFromBuffer(buffer);
+	sliceSampler->processBlock(buffer, midiMessages);
+
+	callbackProfiler->addCallback(callbackStart, juce::Time::getHighResolutionTicks(), buffer.getNumSamples(), getSampleRate());
+}
+
+void ReSamplerAudioProcessor::advanceSampleClock(juce::int64 blockStart, int numSamples)
+{
+	//多轨视图的对齐时钟: 连续录音时偏移不变, 中断(未录音/缓冲区重建/宿主停止调用)后重新对齐
+	if (bufferManager->getTotalSamplesWritten() != blockStart + numSamples)
+	{
+		clockBlockEnd = -1;
+		return;
+	}
+	double now = juce::Time::getMillisecondCounterHiRes();
+	bool continuous = blockStart == clockBlockEnd && now - clockBlockMillis < juce::jmax(100.0, 4000.0 * numSamples / getSampleRate());
+	bufferManager->setClockOffset(InstanceRegistry::getInstance().advanceClock(bufferManager->getClockOffset(), continuous, blockStart, numSamples));
+	clockBlockEnd = blockStart + numSamples;
+	clockBlockMillis = now;
+}
+
+void ReSamplerAudioProcessor::processBlockBypassed (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+{
+	//旁路时不录音, 约10秒后进入休眠
+	idleHibernator->setBypassed(true);
+	AudioProcessor::processBlockBypassed(buffer, midiMessages);
+}
+
+void ReSamplerAudioProcessor::handleCaptureTriggers(juce::int64 blockStart, int numSamples, const juce::MidiBuffer& midiMessages)
+{
+	//只发布范围，复制和编码在后台线程
+	if (bufferManager->getRingSamples() == 0)
+		return;
+	int generation = bufferManager->getRingGeneration();
+	if (generation != lastCaptureGeneration)
+	{
+		lastCaptureGeneration = generation;
+		lastCaptureEnd = -1;
+	}
+
+	auto fire = [&](int offset)
+		{
+			//paused recording has nothing after the write head
+			juce::int64 written = bufferManager->getTotalSamplesWritten();
+			juce::int64 end = bufferManager->bufferState.isRecording ? juce::jmin(written, blockStart + offset) : written;
+			int ringSamples = bufferManager->getRingSamples();
+			int sampleRate = bufferManager->getBufferSampleRate();
+			//a second of room so the writer thread can copy before the head comes around
+			juce::int64 maxLength = juce::jmin<juce::int64>(written, juce::jmax(ringSamples / 2, ringSamples - sampleRate));
+			juce::int64 length = captureSincePrevious->get() && lastCaptureEnd >= 0 ? end - lastCaptureEnd
+				: static_cast<juce::int64>(captureSeconds->get() * sampleRate);
+			length = juce::jlimit<juce::int64>(0, maxLength, length);
+			if (length > 0)
+				triggeredCapture->publish(end - length, end, generation);
+			lastCaptureEnd = end;
+		};
+
+	bool trigger = captureTrigger->get();
+	if (trigger && !lastCaptureTrigger)
+		fire(0);
+	lastCaptureTrigger = trigger;
+
+	for (const auto metadata : midiMessages)
+	{
+		auto message = metadata.getMessage();
+		int offset = juce::jlimit(0, numSamples, metadata.samplePosition);
+		if (message.isNoteOn() && message.getNoteNumber() == captureTriggerNote)
+			fire(offset);
+		else if (message.isController() && message.getControllerNumber() == captureTriggerController)
+		{
+			bool high = message.getControllerValue() >= 64;
+			if (high && !captureControllerHigh)
+				fire(offset);
+			captureControllerHigh = high;
+		}
+	}
+}
+
+void ReSamplerAudioProcessor::setNonRealtime (bool isNonRealtime) noexcept
+{
+	AudioProcessor::setNonRealtime(isNonRealtime);
+	bufferManager->setOfflineMode(isNonRealtime);
+	//the bounce is over once the host goes back to realtime
+	if (!isNonRealtime)
+		bounceCapture->finish();
 }
 
 //==============================================================================
@@ -167,15 +314,28 @@ juce::AudioProcessorEditor* ReSamplerAudioProcessor::createEditor()
 //==============================================================================
 void ReSamplerAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
 {
-    // You should use this method to store your parameters in the memory block.
-    // You could do that either as raw data, or use the XML or ValueTree classes
-    // as intermediaries to make it easy to save and load complex data.
+	//the trigger itself is momentary and not saved
+	juce::XmlElement state("ReSampler");
+	state.setAttribute("captureSeconds", captureSeconds->get());
+	state.setAttribute("captureSincePrevious", captureSincePrevious->get());
+	state.setAttribute("archiveId", archiver->getArchiveId());
+	copyXmlToBinary(state, destData);
 }
 
 void ReSamplerAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
-    // You should use this method to restore your parameters from this memory block,
-    // whose contents will have been created by the getStateInformation() call.
+	if (auto state = getXmlFromBinary(data, sizeInBytes))
+	{
+		*captureSeconds = static_cast<float>(state->getDoubleAttribute("captureSeconds", 30.0));
+		*captureSincePrevious = state->getBoolAttribute("captureSincePrevious", false);
+		archiver->setArchiveId(state->getStringAttribute("archiveId"));
+	}
+}
+
+void ReSamplerAudioProcessor::updateTrackProperties (const TrackProperties& properties)
+{
+	//hosts that report track names label this instance in the track browser
+	InstanceRegistry::getInstance().setName(instanceId, properties.name.value_or(juce::String()));
 }
 
 //==============================================================================
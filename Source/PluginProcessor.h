@@ -10,6 +10,22 @@
 
 #include <JuceHeader.h>
 #include "BufferManager.h"
+#include "HistoryAnalyser.h"
+#include "Spectrogram.h"
+#include "WaveformPyramid.h"
+#include "WaveformTileCache.h"
+#include "EditorResources.h"
+#include "OnsetDetector.h"
+#include "FingerprintIndex.h"
+#include "TempoAnalyser.h"
+#include "PlayheadIndex.h"
+#include "SliceSampler.h"
+#include "Archiver.h"
+#include "BatchExporter.h"
+#include "BounceCapture.h"
+#include "TriggeredCapture.h"
+#include "IdleHibernator.h"
+#include "InstanceRegistry.h"
 
 //==============================================================================
 /**
@@ -30,6 +46,7 @@ public:
    #endif
 
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlockBypassed (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
 
     //==============================================================================
     juce::AudioProcessorEditor* createEditor() override;
@@ -53,11 +70,48 @@ public:
     //==============================================================================
     void getStateInformation (juce::MemoryBlock& destData) override;
     void setStateInformation (const void* data, int sizeInBytes) override;
+    void updateTrackProperties (const TrackProperties& properties) override;
+    void setNonRealtime (bool isNonRealtime) noexcept override;
 
 	std::unique_ptr<BufferManager> bufferManager;
+	std::unique_ptr<CallbackProfiler> callbackProfiler;
+	std::unique_ptr<Spectrogram> spectrogram;
+	std::unique_ptr<WaveformPyramid> waveformPyramid;
+	std::unique_ptr<OnsetDetector> onsetDetector;
+	std::unique_ptr<TempoAnalyser> tempoAnalyser;
+	std::unique_ptr<FingerprintIndex> fingerprintIndex;
+	std::unique_ptr<PlayheadIndex> playheadIndex;
+	std::unique_ptr<SliceSampler> sliceSampler;
+	std::unique_ptr<Archiver> archiver;
+	std::unique_ptr<BatchExporter> batchExporter;
+	std::unique_ptr<BounceCapture> bounceCapture;
+	std::unique_ptr<TriggeredCapture> triggeredCapture;
+	std::unique_ptr<IdleHibernator> idleHibernator;
+	std::unique_ptr<HistoryAnalyser> historyAnalyser;
+	//kept between editor openings, so a new editor draws its first frame straight away
+	std::unique_ptr<WaveformTileCache> tileCache;
+	juce::SharedResourcePointer<EditorResources> editorResources;
+
+	//hands-free capture: a rising edge of the parameter, the trigger CC going up or the trigger note
+	juce::AudioParameterBool* captureTrigger = nullptr;
+	juce::AudioParameterFloat* captureSeconds = nullptr;
+	juce::AudioParameterBool* captureSincePrevious = nullptr;
 
 private:
     //==============================================================================
+	void handleCaptureTriggers(juce::int64 blockStart, int numSamples, const juce::MidiBuffer& midiMessages);
+	void advanceSampleClock(juce::int64 blockStart, int numSamples);
+
+    int instanceId = 0;
+	int captureTriggerNote = 24;
+	int captureTriggerController = 102;
+	bool lastCaptureTrigger = false;
+	bool captureControllerHigh = false;
+	juce::int64 lastCaptureEnd = -1;
+	int lastCaptureGeneration = -1;
+	//where the last block that advanced the process sample clock ended, and when
+	juce::int64 clockBlockEnd = -1;
+	double clockBlockMillis = 0.0;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ReSamplerAudioProcessor)
 };
@@ -0,0 +1,147 @@
+/*
+  ==============================================================================
+
+	SharedHistory.cpp
+	Created: 19 Oct 2026 3:44:19pm
+	Author:  Tokamak
+
+  ==============================================================================
+*/
+
+#include "SharedHistory.h"
+
+#if JUCE_MAC || JUCE_LINUX || JUCE_BSD
+ #include <cerrno>
+ #include <csignal>
+ #include <fcntl.h>
+ #include <sys/mman.h>
+ #include <unistd.h>
+ #define RESAMPLER_SHARED_HISTORY 1
+#else
+ #define RESAMPLER_SHARED_HISTORY 0
+#endif
+
+SharedHistory::SharedHistory()
+{
+}
+
+SharedHistory::~SharedHistory()
+{
+	releasePrevious();
+	retire(current, true);
+}
+
+bool SharedHistory::isSupported()
+{
+	return RESAMPLER_SHARED_HISTORY != 0;
+}
+
+float* const* SharedHistory::create(int numChannels, int ringSamples, int sampleRate, int generation)
+{
+	releasePrevious();
+
+	//readers that still have the old segment mapped keep it until they unmap, the name is free right away
+	juce::String name = current.name;
+	previous = current;
+	current = Mapping();
+#if RESAMPLER_SHARED_HISTORY
+	if (previous.header != nullptr)
+		shm_unlink(previous.name.toRawUTF8());
+#endif
+
+	size_t size = SharedHistoryLayout::getSegmentSize(static_cast<std::uint32_t>(numChannels), static_cast<std::uint32_t>(ringSamples));
+	bool mapped = name.isNotEmpty() && map(name, size);
+	for (int instance = 0; !mapped && instance < maxInstances; instance++)
+		mapped = map(juce::String(SharedHistoryLayout::defaultName) + (instance == 0 ? juce::String() : "_" + juce::String(instance + 1)), size);
+	if (!mapped)
+		return nullptr;
+
+	auto* header = current.header;
+	header->version = SharedHistoryLayout::version;
+	header->numChannels = static_cast<std::uint32_t>(numChannels);
+	header->ringSamples = static_cast<std::uint32_t>(ringSamples);
+	header->sampleRate = static_cast<std::uint32_t>(sampleRate);
+#if RESAMPLER_SHARED_HISTORY
+	header->writerProcessId = static_cast<std::int32_t>(getpid());
+#endif
+	header->generation.store(static_cast<std::uint32_t>(generation), std::memory_order_relaxed);
+	header->retired.store(0, std::memory_order_relaxed);
+	header->samplesWritten.store(0, std::memory_order_relaxed);
+	header->writeEnd.store(0, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	std::memcpy(header->magic, SharedHistoryLayout::magic, sizeof(header->magic));
+
+	planes.resize(static_cast<size_t>(numChannels));
+	for (int channel = 0; channel < numChannels; channel++)
+		planes[static_cast<size_t>(channel)] = const_cast<float*>(SharedHistoryLayout::getChannel(header, static_cast<std::uint32_t>(channel)));
+	return planes.data();
+}
+
+void SharedHistory::releasePrevious()
+{
+	//the name was unlinked when the replacement was created
+	retire(previous, false);
+}
+
+bool SharedHistory::map(const juce::String& name, size_t size)
+{
+#if RESAMPLER_SHARED_HISTORY
+	int fd = shm_open(name.toRawUTF8(), O_CREAT | O_EXCL | O_RDWR, 0600);
+	if (fd < 0 && errno == EEXIST)
+	{
+		//a segment left behind by a crashed writer can be taken over, a live one cannot
+		int existing = shm_open(name.toRawUTF8(), O_RDONLY, 0);
+		bool stale = true;
+		if (existing >= 0)
+		{
+			if (void* data = mmap(nullptr, sizeof(SharedHistoryLayout::Header), PROT_READ, MAP_SHARED, existing, 0); data != MAP_FAILED)
+			{
+				auto* header = static_cast<const SharedHistoryLayout::Header*>(data);
+				stale = header->retired.load() != 0 || (kill(header->writerProcessId, 0) != 0 && errno == ESRCH);
+				munmap(data, sizeof(SharedHistoryLayout::Header));
+			}
+			::close(existing);
+		}
+		if (!stale)
+			return false;
+		shm_unlink(name.toRawUTF8());
+		fd = shm_open(name.toRawUTF8(), O_CREAT | O_EXCL | O_RDWR, 0600);
+	}
+	if (fd < 0)
+		return false;
+
+	void* data = MAP_FAILED;
+	if (ftruncate(fd, static_cast<off_t>(size)) == 0)
+		data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	::close(fd);
+	if (data == MAP_FAILED)
+	{
+		shm_unlink(name.toRawUTF8());
+		return false;
+	}
+
+	current.header = static_cast<SharedHistoryLayout::Header*>(data);
+	current.size = size;
+	current.name = name;
+	return true;
+#else
+	juce::ignoreUnused(name, size);
+	return false;
+#endif
+}
+
+void SharedHistory::retire(Mapping& mapping, bool unlinkName)
+{
+	if (mapping.header == nullptr)
+		return;
+
+	mapping.header->retired.store(1, std::memory_order_release);
+#if RESAMPLER_SHARED_HISTORY
+	munmap(mapping.header, mapping.size);
+	if (unlinkName)
+		shm_unlink(mapping.name.toRawUTF8());
+#else
+	juce::ignoreUnused(unlinkName);
+#endif
+	mapping = Mapping();
+}
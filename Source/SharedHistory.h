@@ -0,0 +1,77 @@
+/*
+  ==============================================================================
+
+	SharedHistory.h
+	Created: 19 Oct 2026 3:44:19pm
+	Author:  Tokamak
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "SharedHistoryLayout.h"
+
+//==============================================================================
+/**
+	Owns the named POSIX shared memory segment the ring lives in when the shared
+	history feed is on. BufferManager points its ring at the planes returned by
+	create() and publishes its sample counter after every block, external
+	processes map the same name read-only (see SharedHistoryLayout.h).
+
+	Changing the ring layout maps a fresh segment under the same name and marks
+	the previous one retired, readers that still have it mapped see the flag and
+	map the name again.
+*/
+class SharedHistory
+{
+public:
+	SharedHistory();
+	~SharedHistory();
+
+	static bool isSupported();
+
+	//maps a zeroed segment for the layout, the previous one stays mapped until releasePrevious(),
+	//returns nullptr if the segment could not be created
+	float* const* create(int numChannels, int ringSamples, int sampleRate, int generation);
+	void releasePrevious();
+
+	bool isOpen() const { return current.header != nullptr; }
+	juce::String getName() const { return current.name; }
+
+	//audio thread, before the block is copied into the planes
+	void beginBlock(juce::int64 writeEnd) noexcept
+	{
+		if (current.header == nullptr)
+			return;
+		current.header->writeEnd.store(writeEnd, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+	}
+
+	//audio thread, after the block has been copied into the planes
+	void publish(juce::int64 samplesWritten) noexcept
+	{
+		if (current.header == nullptr)
+			return;
+		current.header->samplesWritten.store(samplesWritten, std::memory_order_release);
+	}
+
+	static constexpr int maxInstances = 16;
+
+private:
+	struct Mapping
+	{
+		SharedHistoryLayout::Header* header = nullptr;
+		size_t size = 0;
+		juce::String name;
+	};
+
+	bool map(const juce::String& name, size_t size);
+	static void retire(Mapping& mapping, bool unlinkName);
+
+	Mapping current;
+	Mapping previous;
+	std::vector<float*> planes;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SharedHistory)
+};
@@ -0,0 +1,75 @@
+/*
+  ==============================================================================
+
+	SharedHistoryLayout.h
+	Created: 19 Oct 2026 3:44:19pm
+	Author:  Tokamak
+
+	Layout of the shared memory history segment. Only standard types are used
+	so external readers can include this file without JUCE.
+
+	The segment starts with a Header, followed at dataOffset by numChannels
+	planes of ringSamples floats each. Sample n (absolute, never wrapping) of a
+	channel lives at index n % ringSamples of its plane. To read [start, start + count):
+
+	  1. load generation and samplesWritten (acquire)
+	  2. require start >= samplesWritten - ringSamples and start + count <= samplesWritten
+	  3. copy the samples straight out of the planes
+	  4. std::atomic_thread_fence(std::memory_order_acquire), then load writeEnd,
+	     generation and retired; the copy is valid if the generation is unchanged,
+	     retired is 0 and start >= writeEnd - ringSamples
+
+	The writer stores writeEnd (the end of the block it is about to copy) and
+	issues a release fence before touching the planes, then stores samplesWritten
+	(release) once the block is in. writeEnd is therefore never behind any sample
+	a reader could have seen overwritten.
+
+	A retired segment has been replaced (new ring length or sample rate) or
+	closed; map the name again to follow the writer.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace SharedHistoryLayout
+{
+	constexpr char magic[8] = { 'T', 'K', 'R', 'S', 'H', 'I', 'S', 'T' };
+	constexpr std::uint32_t version = 2;
+	constexpr std::size_t dataOffset = 256;
+	constexpr const char* defaultName = "/ReSampler";
+
+	struct Header
+	{
+		char magic[8];
+		std::uint32_t version;
+		std::uint32_t numChannels;
+		std::uint32_t ringSamples;
+		std::uint32_t sampleRate;
+		std::int32_t writerProcessId;
+		std::uint32_t reserved;
+
+		std::atomic<std::uint32_t> generation;
+		std::atomic<std::uint32_t> retired;
+		std::uint32_t padding;
+		std::atomic<std::int64_t> samplesWritten;
+		std::atomic<std::int64_t> writeEnd;
+	};
+
+	static_assert(sizeof(Header) <= dataOffset, "header must fit in front of the channel planes");
+	static_assert(std::atomic<std::int64_t>::is_always_lock_free, "the header is shared between processes");
+	static_assert(std::atomic<std::uint32_t>::is_always_lock_free, "the header is shared between processes");
+
+	inline std::size_t getSegmentSize(std::uint32_t numChannels, std::uint32_t ringSamples)
+	{
+		return dataOffset + static_cast<std::size_t>(numChannels) * ringSamples * sizeof(float);
+	}
+
+	inline const float* getChannel(const Header* header, std::uint32_t channel)
+	{
+		return reinterpret_cast<const float*>(reinterpret_cast<const char*>(header) + dataOffset) + static_cast<std::size_t>(channel) * header->ringSamples;
+	}
+}
@@ -0,0 +1,263 @@
+/*
+  ==============================================================================
+
+	SliceSampler.cpp
+	Created: 19 Oct 2026 3:26:32pm
+	Author:  Tokamak
+
+  ==============================================================================
+*/
+
+#include "SliceSampler.h"
+#include "Tracer.h"
+
+SliceSampler::SliceSampler()
+{
+	startTimer(garbageIntervalMs);
+}
+
+SliceSampler::~SliceSampler()
+{
+	stopTimer();
+	delete current;
+	delete draining;
+	delete pending.exchange(nullptr);
+	delete retired.exchange(nullptr);
+}
+
+void SliceSampler::prepareToPlay(int maximumBlockSize)
+{
+	envelope.assign(juce::jmax(1, maximumBlockSize), 0.0f);
+	for (auto& voice : voices)
+		voice.active = false;
+	for (auto& tail : tails)
+		tail.active = false;
+	numActiveVoices = 0;
+	//not called while processBlock runs, nothing plays from the previous set any more
+	delete draining;
+	draining = nullptr;
+}
+
+void SliceSampler::loadSlices(const juce::AudioBuffer<float>& audio, int numSamples, const juce::Array<int>& sliceStarts)
+{
+	auto* set = new SliceSet();
+	set->audio.setSize(audio.getNumChannels(), numSamples);
+	for (int channel = 0; channel < audio.getNumChannels(); channel++)
+		set->audio.copyFrom(channel, 0, audio, channel, 0, numSamples);
+
+	for (int start : sliceStarts)
+	{
+		if (set->numSlices == maxSlices)
+			break;
+		if (start >= 0 && start < numSamples && (set->numSlices == 0 || start > set->starts[set->numSlices - 1]))
+			set->starts[set->numSlices++] = start;
+	}
+	set->starts[set->numSlices] = numSamples;
+
+	publish(set);
+}
+
+void SliceSampler::clearSlices()
+{
+	publish(new SliceSet());
+}
+
+void SliceSampler::publish(SliceSet* set)
+{
+	collectGarbage();
+	numSlices = set->numSlices;
+
+	//a set the audio thread has not picked up yet is still ours to delete
+	delete pending.exchange(set);
+}
+
+void SliceSampler::collectGarbage()
+{
+	delete retired.exchange(nullptr);
+}
+
+void SliceSampler::processBlock(juce::AudioBuffer<float>& buffer, const juce::MidiBuffer& midiMessages)
+{
+	TRACE_ZONE("SliceSampler::processBlock");
+	//only swap once the previous set has been collected and its voices have faded out, so nothing is ever freed here
+	if (retired.load() == nullptr && draining == nullptr)
+	{
+		if (auto* next = pending.exchange(nullptr))
+		{
+			for (auto& voice : voices)
+				if (voice.active && voice.release < 0)
+					voice.release = fadeSamples;
+			draining = current;
+			current = next;
+		}
+	}
+
+	if (envelope.empty())
+		return;
+
+	int position = 0;
+	for (const auto metadata : midiMessages)
+	{
+		int eventPosition = juce::jlimit(0, buffer.getNumSamples(), metadata.samplePosition);
+		renderVoices(buffer, position, eventPosition - position);
+		position = eventPosition;
+
+		auto message = metadata.getMessage();
+		if (message.isNoteOn() && current != nullptr)
+			startVoice(message.getNoteNumber(), message.getFloatVelocity());
+		else if (message.isNoteOff())
+			stopVoice(message.getNoteNumber());
+		else if (message.isAllNotesOff() || message.isAllSoundOff())
+		{
+			for (auto& voice : voices)
+				if (voice.active && voice.release < 0)
+					voice.release = fadeSamples;
+		}
+	}
+	renderVoices(buffer, position, buffer.getNumSamples() - position);
+
+	int active = 0;
+	bool drained = true;
+	for (auto& voice : voices)
+	{
+		active += voice.active ? 1 : 0;
+		drained = drained && !(voice.active && voice.set == draining);
+	}
+	for (auto& tail : tails)
+		drained = drained && !(tail.active && tail.set == draining);
+	numActiveVoices = active;
+	if (draining != nullptr && drained)
+	{
+		retired = draining;
+		draining = nullptr;
+	}
+}
+
+void SliceSampler::startVoice(int note, float velocity)
+{
+	int slice = note - firstNote;
+	if (slice < 0 || slice >= current->numSlices)
+		return;
+
+	//the voice already playing this note fades out while the new one fades in
+	stopVoice(note);
+
+	//take a free voice, otherwise steal the oldest one, preferring voices already releasing
+	Voice* target = nullptr;
+	for (auto& voice : voices)
+	{
+		if (!voice.active)
+		{
+			target = &voice;
+			break;
+		}
+		if (target == nullptr || (voice.release >= 0) > (target->release >= 0)
+			|| ((voice.release >= 0) == (target->release >= 0) && voice.age < target->age))
+			target = &voice;
+	}
+
+	if (target->active)
+		moveToTail(*target);
+
+	target->active = true;
+	target->set = current;
+	target->note = note;
+	target->start = current->starts[slice];
+	target->position = target->start;
+	target->end = current->starts[slice + 1];
+	target->gain = velocity;
+	target->release = -1;
+	target->age = ++voiceCounter;
+}
+
+void SliceSampler::moveToTail(const Voice& voice)
+{
+	//the stolen voice keeps playing from where it is and fades out over at most fadeSamples, starting at its
+	//current gain; with every tail busy the one closest to silence makes room
+	Voice* tail = &tails[0];
+	for (auto& candidate : tails)
+	{
+		if (!candidate.active)
+		{
+			tail = &candidate;
+			break;
+		}
+		if (candidate.release < tail->release)
+			tail = &candidate;
+	}
+
+	*tail = voice;
+	if (tail->release < 0)
+		tail->release = fadeSamples;
+}
+
+void SliceSampler::stopVoice(int note)
+{
+	for (auto& voice : voices)
+	{
+		if (voice.active && voice.note == note && voice.release < 0)
+			voice.release = fadeSamples;
+	}
+}
+
+void SliceSampler::renderVoices(juce::AudioBuffer<float>& buffer, int startSample, int numSamples)
+{
+	//the envelope scratch buffer was sized in prepareToPlay, larger host blocks are rendered in chunks
+	while (numSamples > 0)
+	{
+		int chunk = juce::jmin(numSamples, static_cast<int>(envelope.size()));
+		for (auto& voice : voices)
+		{
+			if (voice.active)
+				renderVoice(voice, buffer, startSample, chunk);
+		}
+		for (auto& tail : tails)
+		{
+			if (tail.active)
+				renderVoice(tail, buffer, startSample, chunk);
+		}
+		startSample += chunk;
+		numSamples -= chunk;
+	}
+}
+
+void SliceSampler::renderVoice(Voice& voice, juce::AudioBuffer<float>& buffer, int startSample, int numSamples)
+{
+	int num = juce::jmin(numSamples, voice.end - voice.position);
+	if (voice.release >= 0)
+		num = juce::jmin(num, voice.release);
+
+	const auto& audio = voice.set->audio;
+	int sourceChannels = audio.getNumChannels();
+	if (num > 0 && sourceChannels > 0)
+	{
+		bool steady = voice.release < 0 && voice.position - voice.start >= fadeSamples && voice.end - (voice.position + num) >= fadeSamples;
+		if (!steady)
+		{
+			for (int i = 0; i < num; i++)
+			{
+				int position = voice.position + i;
+				float fade = juce::jmin(1.0f, (position - voice.start) / static_cast<float>(fadeSamples), (voice.end - position) / static_cast<float>(fadeSamples));
+				if (voice.release >= 0)
+					fade *= (voice.release - i) / static_cast<float>(fadeSamples);
+				envelope[i] = fade * voice.gain;
+			}
+		}
+
+		for (int channel = 0; channel < buffer.getNumChannels(); channel++)
+		{
+			float* dest = buffer.getWritePointer(channel, startSample);
+			const float* source = audio.getReadPointer(channel % sourceChannels, voice.position);
+			if (steady)
+				juce::FloatVectorOperations::addWithMultiply(dest, source, voice.gain, num);
+			else
+				juce::FloatVectorOperations::addWithMultiply(dest, source, envelope.data(), num);
+		}
+	}
+
+	voice.position += juce::jmax(0, num);
+	if (voice.release >= 0)
+		voice.release -= juce::jmax(0, num);
+	if (voice.position >= voice.end || voice.release == 0)
+		voice.active = false;
+}
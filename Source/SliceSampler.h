@@ -0,0 +1,96 @@
+/*
+  ==============================================================================
+
+	SliceSampler.h
+	Created: 19 Oct 2026 3:26:32pm
+	Author:  Tokamak
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+	Plays slices of a captured phrase from MIDI notes, note firstNote triggers
+	slice 0, the next note slice 1 and so on. The phrase is copied on the message
+	thread and handed to the audio thread through an atomic pointer, the audio
+	thread never allocates, locks or frees. Voices are preallocated, each one has
+	its own read head with short fades at the slice start, the slice end and on
+	note off, so retriggering a note crossfades with the voice it replaces. A
+	voice stolen because all of them are busy is moved to a tail slot and fades
+	out there rather than being cut off mid-sample.
+
+	Loading new slices fades the playing voices out against the set they started
+	from; that set is only retired once the last of them has finished. Retired
+	sets are freed by a timer of the sampler itself, whether an editor is open
+	or not.
+*/
+class SliceSampler : private juce::Timer
+{
+public:
+	SliceSampler();
+	~SliceSampler() override;
+
+	void prepareToPlay(int maximumBlockSize);
+	void processBlock(juce::AudioBuffer<float>& buffer, const juce::MidiBuffer& midiMessages);
+
+	//message thread
+	void loadSlices(const juce::AudioBuffer<float>& audio, int numSamples, const juce::Array<int>& sliceStarts);
+	void clearSlices();
+	void collectGarbage();
+	int getNumSlices() const { return numSlices.load(); }
+	int getNumActiveVoices() const { return numActiveVoices.load(); }
+
+	static constexpr int maxVoices = 32;
+	static constexpr int maxTails = 8;
+	static constexpr int maxSlices = 64;
+	static constexpr int firstNote = 36;
+	static constexpr int fadeSamples = 64;
+	static constexpr int garbageIntervalMs = 250;
+
+private:
+	struct SliceSet
+	{
+		juce::AudioBuffer<float> audio;
+		int starts[maxSlices + 1] = {};
+		int numSlices = 0;
+	};
+
+	struct Voice
+	{
+		bool active = false;
+		const SliceSet* set = nullptr;
+		int note = -1;
+		int start = 0;
+		int position = 0;
+		int end = 0;
+		float gain = 0.0f;
+		int release = -1;	//remaining fade out samples after note off, -1 while held
+		juce::uint32 age = 0;
+	};
+
+	void startVoice(int note, float velocity);
+	void stopVoice(int note);
+	void moveToTail(const Voice& voice);
+	void renderVoices(juce::AudioBuffer<float>& buffer, int startSample, int numSamples);
+	void renderVoice(Voice& voice, juce::AudioBuffer<float>& buffer, int startSample, int numSamples);
+	void publish(SliceSet* set);
+	void timerCallback() override { collectGarbage(); }
+
+	SliceSet* current = nullptr;
+	//audio thread only, the previous set while voices started from it fade out
+	SliceSet* draining = nullptr;
+	std::atomic<SliceSet*> pending{ nullptr };
+	std::atomic<SliceSet*> retired{ nullptr };
+
+	Voice voices[maxVoices];
+	//stolen voices fading out, not counted as active
+	Voice tails[maxTails];
+	juce::uint32 voiceCounter = 0;
+	std::vector<float> envelope;
+
+	std::atomic<int> numSlices{ 0 };
+	std::atomic<int> numActiveVoices{ 0 };
+};
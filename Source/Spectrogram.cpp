@@ -0,0 +1,67 @@
+/*
+  ==============================================================================
+
+	Spectrogram.cpp
+	Created: 19 Oct 2026 3:16:58pm
+	Author:  Tokamak
+
+  ==============================================================================
+*/
+
+#include "Spectrogram.h"
+
+void Spectrogram::prepare(int ringSamples, int numChannels, int sampleRate, int hopSize)
+{
+	juce::ScopedLock lock(storageLock);
+
+	ringLength = ringSamples;
+	hop = hopSize;
+	numColumns = (ringSamples + hopSize - 1) / hopSize;
+	numTiles = (numColumns + tileColumns - 1) / tileColumns;
+	columns.assign(static_cast<size_t>(numTiles) * tileColumns * numBands, 0);
+	tileVersions.reset(new std::atomic<juce::uint32>[numTiles]);
+	for (int tile = 0; tile < numTiles; tile++)
+		tileVersions[tile].store(0);
+
+	//log-spaced bands from 40 Hz up to nyquist
+	int numBins = HistoryAnalyser::numBins;
+	float binWidth = static_cast<float>(sampleRate) / HistoryAnalyser::fftSize;
+	float lowFrequency = 40.0f;
+	float highFrequency = sampleRate * 0.5f;
+	bandFirstBin.resize(numBands);
+	bandLastBin.resize(numBands);
+	for (int band = 0; band < numBands; band++)
+	{
+		float from = lowFrequency * std::pow(highFrequency / lowFrequency, static_cast<float>(band) / numBands);
+		float to = lowFrequency * std::pow(highFrequency / lowFrequency, static_cast<float>(band + 1) / numBands);
+		bandFirstBin[band] = juce::jlimit(1, numBins - 1, static_cast<int>(from / binWidth));
+		bandLastBin[band] = juce::jlimit(bandFirstBin[band], numBins - 1, static_cast<int>(to / binWidth));
+	}
+
+	layoutVersion.fetch_add(1, std::memory_order_acq_rel);
+}
+
+void Spectrogram::processFrame(const AnalysisFrame& frame)
+{
+	if (numColumns == 0)
+		return;
+
+	//the column is placed at the centre of the analysis window
+	int ringPosition = static_cast<int>((frame.startSample + frame.fftSize / 2) % ringLength);
+	int column = ringPosition / hop;
+	juce::uint8* dest = columns.data() + static_cast<size_t>(column) * numBands;
+
+	//hann window, one-sided spectrum
+	float normalise = 4.0f / frame.fftSize;
+	for (int band = 0; band < numBands; band++)
+	{
+		float peak = 0.0f;
+		for (int bin = bandFirstBin[band]; bin <= bandLastBin[band]; bin++)
+			peak = juce::jmax(peak, frame.magnitudes[bin]);
+
+		float decibels = juce::Decibels::gainToDecibels(peak * normalise, minDecibels);
+		dest[band] = static_cast<juce::uint8>(juce::jlimit(0.0f, 255.0f, (decibels - minDecibels) * 255.0f / -minDecibels));
+	}
+
+	tileVersions[column / tileColumns].fetch_add(1, std::memory_order_acq_rel);
+}
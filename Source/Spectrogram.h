@@ -0,0 +1,58 @@
+/*
+  ==============================================================================
+
+	Spectrogram.h
+	Created: 19 Oct 2026 3:16:58pm
+	Author:  Tokamak
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "HistoryAnalyser.h"
+
+//==============================================================================
+/**
+	Ring-aligned spectrogram of the history. One column per analysis hop, each
+	column holding numBands log-spaced bands as 8-bit log magnitudes
+	(0 = -96 dB, 255 = 0 dBFS). Columns are grouped into tiles so the editor only
+	needs to re-render the tiles whose version changed since the last frame.
+*/
+class Spectrogram : public AnalysisStage
+{
+public:
+	static constexpr int numBands = 128;
+	static constexpr int tileColumns = 256;
+	static constexpr float minDecibels = -96.0f;
+
+	void prepare(int ringSamples, int numChannels, int sampleRate, int hopSize) override;
+	void processFrame(const AnalysisFrame& frame) override;
+
+	//the editor takes this with a ScopedTryLock while reading tiles, prepare() holds it while reallocating
+	juce::CriticalSection& getStorageLock() { return storageLock; }
+	int getLayoutVersion() const { return layoutVersion.load(std::memory_order_acquire); }
+
+	int getNumTiles() const { return numTiles; }
+	int getNumColumns() const { return numColumns; }
+	int getNumColumnsInTile(int tile) const { return juce::jmin(tileColumns, numColumns - tile * tileColumns); }
+	int getHopSize() const { return hop; }
+	int getRingSamples() const { return ringLength; }
+	juce::uint32 getTileVersion(int tile) const { return tileVersions[tile].load(std::memory_order_acquire); }
+	//column-major, numBands bytes per column, band 0 is the lowest frequency
+	const juce::uint8* getTileData(int tile) const { return columns.data() + static_cast<size_t>(tile) * tileColumns * numBands; }
+	size_t getMemoryUsage() const { return columns.size(); }
+
+private:
+	juce::CriticalSection storageLock;
+	std::atomic<int> layoutVersion{ 0 };
+
+	int ringLength = 0;
+	int hop = 512;
+	int numColumns = 0;
+	int numTiles = 0;
+	std::vector<juce::uint8> columns;
+	std::unique_ptr<std::atomic<juce::uint32>[]> tileVersions;
+	std::vector<int> bandFirstBin;
+	std::vector<int> bandLastBin;
+};
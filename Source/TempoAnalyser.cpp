@@ -0,0 +1,152 @@
+/*
+  ==============================================================================
+
+	TempoAnalyser.cpp
+	Created: 19 Oct 2026 3:48:22pm
+	Author:  Tokamak
+
+  ==============================================================================
+*/
+
+#include "TempoAnalyser.h"
+#include "Tracer.h"
+
+juce::int64 BeatGrid::getNearestBeat(juce::int64 position) const
+{
+	double beats = std::round((position - beatOrigin) / beatSamples);
+	return beatOrigin + static_cast<juce::int64>(std::llround(beats * beatSamples));
+}
+
+void TempoAnalyser::prepare(int ringSamples, int numChannels, int sampleRate, int hopSize)
+{
+	{
+		juce::ScopedLock lock(gridLock);
+		grid = BeatGrid();
+	}
+
+	rate = sampleRate;
+	hop = hopSize;
+	framesSinceUpdate = 0;
+	numFrames = 0;
+	previousSpectrum.assign(HistoryAnalyser::numBins, 0.0f);
+	envelope.assign(envelopeFrames, 0.0f);
+	envelopeIndex = 0;
+	fftData.assign(static_cast<size_t>(2 << fftOrder), 0.0f);
+	autocorrelation.assign(envelopeFrames, 0.0f);
+}
+
+void TempoAnalyser::processFrame(const AnalysisFrame& frame)
+{
+	//half-wave rectified flux of the log spectrum, the same onset strength the onset detector peaks on
+	float normalise = 4.0f / frame.fftSize;
+	float flux = 0.0f;
+	for (int bin = 1; bin < frame.numBins; bin++)
+	{
+		float value = std::log1p(100.0f * frame.magnitudes[bin] * normalise);
+		flux += juce::jmax(0.0f, value - previousSpectrum[bin]);
+		previousSpectrum[bin] = value;
+	}
+	envelope[static_cast<size_t>(envelopeIndex)] = flux / frame.numBins;
+	envelopeIndex = (envelopeIndex + 1) % envelopeFrames;
+	numFrames = juce::jmin(numFrames + 1, envelopeFrames);
+
+	if (++framesSinceUpdate >= static_cast<int>(updateSeconds * rate / hop) && numFrames == envelopeFrames)
+	{
+		framesSinceUpdate = 0;
+		updateEstimate(frame.startSample + frame.fftSize / 2);
+	}
+}
+
+void TempoAnalyser::updateEstimate(juce::int64 newestFrameCentre)
+{
+	TRACE_ZONE("updateTempo");
+	//mean-removed envelope, zero padded to twice its length so the circular autocorrelation is linear
+	float mean = 0.0f;
+	for (float value : envelope)
+		mean += value;
+	mean /= envelopeFrames;
+
+	std::fill(fftData.begin(), fftData.end(), 0.0f);
+	for (int age = 0; age < envelopeFrames; age++)
+		fftData[static_cast<size_t>(envelopeFrames - 1 - age)] = getEnvelope(age) - mean;
+
+	fft.performRealOnlyForwardTransform(fftData.data());
+	int size = fft.getSize();
+	for (int bin = 0; bin <= size / 2; bin++)
+	{
+		float re = fftData[static_cast<size_t>(bin * 2)];
+		float im = fftData[static_cast<size_t>(bin * 2 + 1)];
+		fftData[static_cast<size_t>(bin * 2)] = re * re + im * im;
+		fftData[static_cast<size_t>(bin * 2 + 1)] = 0.0f;
+	}
+	fft.performRealOnlyInverseTransform(fftData.data());
+
+	float energy = fftData[0];
+	if (energy <= 0.0f)
+		return;
+	for (int lag = 0; lag < envelopeFrames; lag++)
+		autocorrelation[static_cast<size_t>(lag)] = fftData[static_cast<size_t>(lag)] / energy;
+
+	//strongest lag in the tempo range, the double lag adds support for the same pulse and a
+	//log-gaussian around 120 BPM settles the octave
+	double frameRate = static_cast<double>(rate) / hop;
+	int minimumLag = juce::jmax(2, static_cast<int>(std::floor(60.0 * frameRate / maximumBpm)));
+	int maximumLag = juce::jmin(envelopeFrames / 2 - 2, static_cast<int>(std::ceil(60.0 * frameRate / minimumBpm)));
+	int bestLag = 0;
+	float bestScore = 0.0f;
+	for (int lag = minimumLag; lag <= maximumLag; lag++)
+	{
+		double bpm = 60.0 * frameRate / lag;
+		float prior = static_cast<float>(std::exp(-0.5 * std::pow(std::log2(bpm / 120.0) / 0.9, 2.0)));
+		float score = (autocorrelation[static_cast<size_t>(lag)] + 0.5f * autocorrelation[static_cast<size_t>(lag * 2)]) * prior;
+		if (score > bestScore)
+		{
+			bestScore = score;
+			bestLag = lag;
+		}
+	}
+	if (bestLag == 0)
+		return;
+
+	//parabolic interpolation for a sub-frame period
+	float left = autocorrelation[static_cast<size_t>(bestLag - 1)];
+	float centre = autocorrelation[static_cast<size_t>(bestLag)];
+	float right = autocorrelation[static_cast<size_t>(bestLag + 1)];
+	float curvature = left - 2.0f * centre + right;
+	double period = bestLag + (curvature < 0.0f ? 0.5 * (left - right) / curvature : 0.0);
+
+	//phase: the comb offset with the most onset strength, counted back from the newest frame
+	int numBeats = static_cast<int>(envelopeFrames / period);
+	int bestPhase = 0;
+	float bestComb = -1.0f;
+	for (int phase = 0; phase < bestLag; phase++)
+	{
+		float comb = 0.0f;
+		for (int beat = 0; beat < numBeats; beat++)
+		{
+			int age = phase + static_cast<int>(std::round(beat * period));
+			if (age < envelopeFrames)
+				comb += getEnvelope(age);
+		}
+		if (comb > bestComb)
+		{
+			bestComb = comb;
+			bestPhase = phase;
+		}
+	}
+
+	BeatGrid estimate;
+	estimate.beatSamples = period * hop;
+	estimate.bpm = 60.0 * rate / estimate.beatSamples;
+	estimate.beatOrigin = newestFrameCentre - static_cast<juce::int64>(bestPhase) * hop;
+	estimate.confidence = juce::jlimit(0.0f, 1.0f, centre);
+
+	juce::ScopedLock lock(gridLock);
+	grid = estimate;
+}
+
+BeatGrid TempoAnalyser::getGrid() const
+{
+	juce::ScopedLock lock(gridLock);
+	return grid;
+}
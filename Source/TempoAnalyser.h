@@ -0,0 +1,73 @@
+/*
+  ==============================================================================
+
+	TempoAnalyser.h
+	Created: 19 Oct 2026 3:48:22pm
+	Author:  Tokamak
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "HistoryAnalyser.h"
+
+struct BeatGrid
+{
+	double bpm = 0.0;
+	double beatSamples = 0.0;
+	juce::int64 beatOrigin = 0;	//absolute position of a beat
+	float confidence = 0.0f;
+
+	bool isValid() const { return beatSamples > 0.0 && confidence >= minimumConfidence; }
+	double getBarSamples() const { return beatSamples * beatsPerBar; }
+	juce::int64 getNearestBeat(juce::int64 position) const;
+
+	static constexpr int beatsPerBar = 4;
+	static constexpr float minimumConfidence = 0.1f;
+};
+
+//==============================================================================
+/**
+	Tempo and beat grid estimation over the most recent audio.
+
+	Every frame adds one spectral-flux value to an onset envelope of the last
+	envelopeFrames hops. Once per second of new audio the envelope is
+	autocorrelated through an FFT, the strongest lag between minimumBpm and
+	maximumBpm (weighted towards 120 BPM, with its double lag added in) gives the
+	tempo, and a comb over the envelope gives the phase. The cost is one FFT pair
+	and a comb per second no matter how long the ring is.
+*/
+class TempoAnalyser : public AnalysisStage
+{
+public:
+	void prepare(int ringSamples, int numChannels, int sampleRate, int hopSize) override;
+	void processFrame(const AnalysisFrame& frame) override;
+
+	BeatGrid getGrid() const;
+
+	static constexpr int envelopeFrames = 1024;
+	static constexpr int fftOrder = 11;
+	static constexpr double minimumBpm = 60.0;
+	static constexpr double maximumBpm = 200.0;
+	static constexpr double updateSeconds = 1.0;
+
+private:
+	void updateEstimate(juce::int64 newestFrameCentre);
+	float getEnvelope(int age) const { return envelope[static_cast<size_t>((envelopeIndex - 1 - age + envelopeFrames) % envelopeFrames)]; }
+
+	mutable juce::CriticalSection gridLock;
+	BeatGrid grid;
+
+	int rate = 44100;
+	int hop = 512;
+	int framesSinceUpdate = 0;
+	int numFrames = 0;
+	std::vector<float> previousSpectrum;
+	std::vector<float> envelope;
+	int envelopeIndex = 0;
+
+	juce::dsp::FFT fft{ fftOrder };
+	std::vector<float> fftData;
+	std::vector<float> autocorrelation;
+};
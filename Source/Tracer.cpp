@@ -0,0 +1,139 @@
+/*
+  ==============================================================================
+
+	Tracer.cpp
+	Created: 19 Oct 2026 3:29:55pm
+	Author:  Tokamak
+
+  ==============================================================================
+*/
+
+#include <cstring>
+#include "Tracer.h"
+
+Tracer& Tracer::getInstance()
+{
+	static Tracer tracer;
+	return tracer;
+}
+
+void Tracer::start()
+{
+	juce::ScopedLock lock(controlLock);
+	if (enabled)
+		return;
+
+	//allocated the first time tracing starts and kept, so threads can claim buffers without allocating
+	if (buffers == nullptr)
+	{
+		buffers = std::make_unique<ThreadBuffer[]>(maxThreads);
+		for (int i = 0; i < maxThreads; i++)
+			buffers[i].events.resize(eventsPerThread);
+	}
+
+	for (int i = 0; i < maxThreads; i++)
+		buffers[i].numEvents.store(0, std::memory_order_relaxed);
+	numClaimed = 0;
+	numDropped = 0;
+	sessionStart = juce::Time::getHighResolutionTicks();
+	session.fetch_add(1, std::memory_order_release);
+	enabled = true;
+}
+
+bool Tracer::stop(const juce::File& file)
+{
+	juce::ScopedLock lock(controlLock);
+	if (!enabled)
+		return false;
+	enabled = false;
+
+	//zones that were already open finish into their buffers, only the published prefix is written
+	return writeJson(file);
+}
+
+Tracer::ThreadBuffer* Tracer::getThreadBuffer()
+{
+	struct ThreadSlot
+	{
+		ThreadBuffer* buffer = nullptr;
+		int session = -1;
+	};
+	thread_local ThreadSlot slot;
+
+	int currentSession = session.load(std::memory_order_acquire);
+	if (slot.session == currentSession)
+		return slot.buffer;
+
+	slot.session = currentSession;
+	slot.buffer = nullptr;
+	int index = numClaimed.fetch_add(1, std::memory_order_relaxed);
+	if (index >= maxThreads)
+		return nullptr;
+
+	//copied straight into the preallocated name, no juce::String is built on the audio thread
+	auto& buffer = buffers[index];
+	if (juce::MessageManager::existsAndIsCurrentThread())
+		std::strncpy(buffer.name, "Message Thread", sizeof(buffer.name) - 1);
+	else if (auto* thread = juce::Thread::getCurrentThread())
+		std::strncpy(buffer.name, thread->getThreadName().toRawUTF8(), sizeof(buffer.name) - 1);
+	else
+		std::strncpy(buffer.name, "Host Thread", sizeof(buffer.name) - 1);
+	buffer.name[sizeof(buffer.name) - 1] = 0;
+
+	slot.buffer = &buffer;
+	return slot.buffer;
+}
+
+void Tracer::addEvent(const char* name, juce::int64 startTicks, juce::int64 endTicks)
+{
+	if (!isEnabled())
+		return;
+
+	auto* buffer = getThreadBuffer();
+	int index = buffer != nullptr ? buffer->numEvents.load(std::memory_order_relaxed) : eventsPerThread;
+	if (index >= eventsPerThread)
+	{
+		numDropped.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	buffer->events[index] = { name, startTicks, endTicks };
+	buffer->numEvents.store(index + 1, std::memory_order_release);
+}
+
+bool Tracer::writeJson(const juce::File& file)
+{
+	juce::FileOutputStream stream(file);
+	if (!stream.openedOk())
+		return false;
+	stream.setPosition(0);
+	stream.truncate();
+
+	double ticksToMicros = 1.0e6 / static_cast<double>(juce::Time::getHighResolutionTicksPerSecond());
+	int numThreads = juce::jmin(maxThreads, numClaimed.load());
+
+	stream << "{\"displayTimeUnit\":\"ms\",\"otherData\":{\"droppedEvents\":" << numDropped.load() << "},\"traceEvents\":[\n";
+	bool first = true;
+	for (int thread = 0; thread < numThreads; thread++)
+	{
+		auto& buffer = buffers[thread];
+		if (!first)
+			stream << ",\n";
+		first = false;
+		stream << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << (thread + 1)
+			<< ",\"args\":{\"name\":" << juce::JSON::toString(juce::String(buffer.name)) << "}}";
+
+		int numEvents = buffer.numEvents.load(std::memory_order_acquire);
+		for (int i = 0; i < numEvents; i++)
+		{
+			const auto& event = buffer.events[i];
+			double start = (juce::jmax(event.start, sessionStart) - sessionStart) * ticksToMicros;
+			double duration = juce::jmax<juce::int64>(0, event.end - juce::jmax(event.start, sessionStart)) * ticksToMicros;
+			stream << ",\n{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << (thread + 1)
+				<< ",\"ts\":" << juce::String(start, 3) << ",\"dur\":" << juce::String(duration, 3) << "}";
+		}
+	}
+	stream << "\n]}\n";
+	stream.flush();
+	return !stream.getStatus().failed();
+}
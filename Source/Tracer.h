@@ -0,0 +1,86 @@
+/*
+  ==============================================================================
+
+	Tracer.h
+	Created: 19 Oct 2026 3:29:55pm
+	Author:  Tokamak
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+	Process-wide trace capture written as Chrome trace JSON (chrome://tracing,
+	ui.perfetto.dev). Every thread appends to its own preallocated event buffer,
+	claimed with a single atomic increment, so zones on the audio thread neither
+	lock nor allocate. Disabled zones cost one relaxed load.
+*/
+class Tracer
+{
+public:
+	static Tracer& getInstance();
+
+	//message thread
+	void start();
+	bool stop(const juce::File& file);
+	bool isEnabled() const { return enabled.load(std::memory_order_relaxed); }
+
+	//any thread, name must be a string literal
+	void addEvent(const char* name, juce::int64 startTicks, juce::int64 endTicks);
+
+	static constexpr int maxThreads = 16;
+	static constexpr int eventsPerThread = 1 << 15;
+
+private:
+	struct Event
+	{
+		const char* name;
+		juce::int64 start;
+		juce::int64 end;
+	};
+
+	struct ThreadBuffer
+	{
+		std::vector<Event> events;
+		std::atomic<int> numEvents{ 0 };
+		char name[32] = {};
+	};
+
+	ThreadBuffer* getThreadBuffer();
+	bool writeJson(const juce::File& file);
+
+	juce::CriticalSection controlLock;
+	std::atomic<bool> enabled{ false };
+	std::atomic<int> session{ 0 };
+	std::atomic<int> numClaimed{ 0 };
+	std::atomic<int> numDropped{ 0 };
+	juce::int64 sessionStart = 0;
+	std::unique_ptr<ThreadBuffer[]> buffers;
+};
+
+//==============================================================================
+class TraceZone
+{
+public:
+	explicit TraceZone(const char* zoneName)
+		: name(zoneName), start(Tracer::getInstance().isEnabled() ? juce::Time::getHighResolutionTicks() : 0)
+	{
+	}
+
+	~TraceZone()
+	{
+		if (start != 0)
+			Tracer::getInstance().addEvent(name, start, juce::Time::getHighResolutionTicks());
+	}
+
+private:
+	const char* name;
+	juce::int64 start;
+
+	JUCE_DECLARE_NON_COPYABLE(TraceZone)
+};
+
+#define TRACE_ZONE(name) TraceZone JUCE_JOIN_MACRO(traceZone_, __LINE__)(name)
@@ -0,0 +1,363 @@
+/*
+  ==============================================================================
+
+	TrackBrowser.cpp
+	Created: 19 Oct 2026 3:46:55pm
+	Author:  Tokamak
+
+  ==============================================================================
+*/
+
+#include "TrackBrowser.h"
+#include "Tracer.h"
+
+//==============================================================================
+class TrackBrowser::ExportThread : public juce::Thread
+{
+public:
+	struct Track
+	{
+		int id = 0;
+		juce::String name;
+		juce::int64 start = 0;
+		int numSamples = 0;
+		std::unique_ptr<juce::AudioFormatWriter> writer;
+		bool lapped = false;
+	};
+
+	ExportThread(TrackBrowser& owner, const juce::File& folderToWrite, ExportFormat formatToWrite, std::vector<Track> tracksToExport)
+		: juce::Thread("ReSampler Track Export"), browser(&owner), folder(folderToWrite), format(formatToWrite), tracks(std::move(tracksToExport))
+	{
+	}
+
+	~ExportThread() override
+	{
+		stopThread(10000);
+	}
+
+	void run() override
+	{
+		TRACE_ZONE("exportSelection");
+		auto& registry = InstanceRegistry::getInstance();
+		if (folder.createDirectory())
+		{
+			openWriters(registry);
+			exportTracks(registry);
+		}
+
+		//the writers finish their files before the editor hears about it
+		int numExported = 0, numLapped = 0;
+		for (auto& track : tracks)
+		{
+			numExported += track.writer != nullptr ? 1 : 0;
+			numLapped += track.writer != nullptr && track.lapped ? 1 : 0;
+			track.writer.reset();
+		}
+		juce::MessageManager::callAsync([safeBrowser = browser, numExported, numLapped]
+			{
+				if (safeBrowser != nullptr && safeBrowser->onExportFinished)
+					safeBrowser->onExportFinished(numExported, numLapped);
+			});
+	}
+
+private:
+	//the instance may have been removed since the selection was made, the registry lock keeps it alive while in use
+	static BufferManager* findBufferManager(InstanceRegistry& registry, int id)
+	{
+		for (auto& instance : registry.getInstances())
+			if (instance.id == id)
+				return instance.bufferManager;
+		return nullptr;
+	}
+
+	void restoreTracks(InstanceRegistry& registry)
+	{
+		//a hibernated track is read back from disk by its own IdleHibernator rather than exported as silence;
+		//never here under the registry lock, which every editor's paint and every instance's destruction waits on
+		while (!threadShouldExit())
+		{
+			bool restoring = false;
+			{
+				juce::ScopedLock lock(registry.getLock());
+				for (auto& track : tracks)
+				{
+					auto* bufferManager = findBufferManager(registry, track.id);
+					if (bufferManager != nullptr && bufferManager->isHibernated())
+					{
+						bufferManager->requestRestore();
+						restoring = true;
+					}
+				}
+			}
+			if (!restoring)
+				break;
+			wait(restorePollMillis);
+		}
+	}
+
+	void openWriters(InstanceRegistry& registry)
+	{
+		restoreTracks(registry);
+		for (auto& track : tracks)
+		{
+			juce::ScopedLock lock(registry.getLock());
+			auto* bufferManager = findBufferManager(registry, track.id);
+			if (bufferManager == nullptr || bufferManager->getRingSamples() == 0)
+				continue;
+
+			std::unique_ptr<juce::FileOutputStream> fileStream(folder.getChildFile("TKRS_" + track.name + AudioExport::getFileExtension(format)).createOutputStream());
+			if (fileStream == nullptr)
+				continue;
+			track.numSamples = juce::jmin(track.numSamples, bufferManager->getRingSamples());
+			track.writer = AudioExport::createWriter(format, fileStream.get(), bufferManager->getBufferSampleRate(), bufferManager->getBufferNumChannels());
+			if (track.writer != nullptr)
+				fileStream.release();
+		}
+	}
+
+	void exportTracks(InstanceRegistry& registry)
+	{
+		//one pass over time, each track's chunk goes from its ring straight into its writer;
+		//the registry lock is only held for one chunk so the editors keep painting
+		int longest = 0;
+		for (auto& track : tracks)
+			longest = juce::jmax(longest, track.writer != nullptr ? track.numSamples : 0);
+		for (int done = 0; done < longest && !threadShouldExit(); done += chunkSamples)
+		{
+			for (auto& track : tracks)
+			{
+				int numSamples = juce::jmin(chunkSamples, track.numSamples - done);
+				if (track.writer == nullptr || numSamples <= 0)
+					continue;
+
+				juce::ScopedLock lock(registry.getLock());
+				auto* bufferManager = findBufferManager(registry, track.id);
+				auto* writer = track.writer.get();
+				bool valid = bufferManager != nullptr && bufferManager->visitHistory(track.start + done, numSamples, [writer](const float* const* channels, int numChannels, int num)
+					{
+						juce::ignoreUnused(numChannels);
+						writer->writeFromFloatArrays(channels, writer->getNumChannels(), num);
+					});
+				track.lapped = track.lapped || !valid;
+			}
+		}
+	}
+
+	static constexpr int restorePollMillis = 20;
+
+	juce::Component::SafePointer<TrackBrowser> browser;
+	juce::File folder;
+	ExportFormat format;
+	std::vector<Track> tracks;
+};
+
+//==============================================================================
+TrackBrowser::TrackBrowser()
+{
+	setOpaque(true);
+}
+
+TrackBrowser::~TrackBrowser()
+{
+	exportThread.reset();
+}
+
+void TrackBrowser::setColours(juce::Colour background, juce::Colour wave, juce::Colour selection, juce::Colour text)
+{
+	backgroundColour = background;
+	waveColour = wave;
+	selectionColour = selection;
+	textColour = text;
+}
+
+void TrackBrowser::clearSelection()
+{
+	selectionStart = selectionEnd = 0.0;
+	selectedIds.clear();
+	repaint();
+}
+
+double TrackBrowser::xToClock(float x) const
+{
+	double width = juce::jmax(1, getWidth() - labelWidth);
+	return viewEnd - visibleSeconds * clockRate * (1.0 - (x - labelWidth) / width);
+}
+
+float TrackBrowser::clockToX(double clock) const
+{
+	double width = juce::jmax(1, getWidth() - labelWidth);
+	return static_cast<float>(labelWidth + width * (1.0 - (viewEnd - clock) / (visibleSeconds * clockRate)));
+}
+
+juce::int64 TrackBrowser::clockToSample(const InstanceRegistry::Instance& instance, double clock)
+{
+	//every instance keeps a fixed offset from its own sample counter to the process clock
+	return static_cast<juce::int64>(std::floor(clock)) - instance.bufferManager->getClockOffset();
+}
+
+void TrackBrowser::paint(juce::Graphics& g)
+{
+	TRACE_ZONE("TrackBrowser::paint");
+	g.fillAll(backgroundColour);
+
+	//an export or an instance going away may hold the registry, skip the rows this frame rather than wait
+	auto& registry = InstanceRegistry::getInstance();
+	juce::ScopedTryLock lock(registry.getLock());
+	if (!lock.isLocked())
+		return;
+	auto& instances = registry.getInstances();
+	rowIds.clearQuick();
+	if (instances.isEmpty())
+		return;
+	viewEnd = static_cast<double>(registry.getClock());
+	if (instances[0].bufferManager->getBufferSampleRate() > 0)
+		clockRate = instances[0].bufferManager->getBufferSampleRate();
+
+	int rowHeight = juce::jmax(16, getHeight() / instances.size());
+	for (int i = 0; i < instances.size(); i++)
+	{
+		auto row = juce::Rectangle<int>(0, i * rowHeight, getWidth(), rowHeight);
+		rowIds.add(instances[i].id);
+		drawRow(g, instances[i], row);
+
+		if (hasSelection() && selectedIds.contains(instances[i].id))
+		{
+			float x0 = juce::jmax(static_cast<float>(labelWidth), clockToX(selectionStart));
+			float x1 = juce::jmin(static_cast<float>(getWidth()), clockToX(selectionEnd));
+			g.setColour(selectionColour);
+			if (x1 > x0)
+				g.fillRect(x0, static_cast<float>(row.getY()), x1 - x0, static_cast<float>(row.getHeight()));
+		}
+
+		g.setColour(textColour.withMultipliedAlpha(0.3f));
+		g.drawHorizontalLine(row.getBottom() - 1, 0.0f, static_cast<float>(getWidth()));
+	}
+}
+
+void TrackBrowser::drawRow(juce::Graphics& g, const InstanceRegistry::Instance& instance, juce::Rectangle<int> area)
+{
+	g.setColour(textColour);
+	g.setFont(12.0f);
+	g.drawFittedText(instance.name, area.removeFromLeft(labelWidth).reduced(4, 0), juce::Justification::centredLeft, 1);
+
+	//read the instance's summary in place, skip the row this frame if its analyser is reallocating
+	auto& pyramid = *instance.waveformPyramid;
+	juce::ScopedTryLock lock(pyramid.getStorageLock());
+	if (!lock.isLocked())
+		return;
+	const auto& summary = pyramid.getSummary();
+	if (summary.isEmpty())
+		return;
+
+	juce::int64 summaryEnd = pyramid.getSummaryEnd();
+	juce::int64 oldest = summaryEnd - summary.ringSamples;
+	float centre = static_cast<float>(area.getCentreY());
+	float halfHeight = area.getHeight() * 0.45f;
+
+	juce::RectangleList<float> columns;
+	juce::int64 next = clockToSample(instance, xToClock(static_cast<float>(area.getX())));
+	for (int x = area.getX(); x < area.getRight(); x++)
+	{
+		juce::int64 start = next;
+		next = clockToSample(instance, xToClock(static_cast<float>(x + 1)));
+		juce::int64 end = juce::jmax(start + 1, next);
+		if (start < oldest || end > summaryEnd)
+			continue;
+
+		float minValue = 0.0f, maxValue = 0.0f;
+		for (int channel = 0; channel < summary.numChannels; channel++)
+		{
+			float channelMin, channelMax;
+			summary.getMinMax(channel, static_cast<int>(start % summary.ringSamples), static_cast<int>(end - start), channelMin, channelMax);
+			minValue = juce::jmin(minValue, channelMin);
+			maxValue = juce::jmax(maxValue, channelMax);
+		}
+		columns.addWithoutMerging({ static_cast<float>(x), centre - maxValue * halfHeight, 1.0f, juce::jmax(1.0f, (maxValue - minValue) * halfHeight) });
+	}
+
+	g.setColour(waveColour);
+	g.fillRectList(columns);
+}
+
+void TrackBrowser::mouseDown(const juce::MouseEvent& event)
+{
+	if (event.x < labelWidth)
+	{
+		clearSelection();
+		return;
+	}
+	updateSelection(event);
+}
+
+void TrackBrowser::mouseDrag(const juce::MouseEvent& event)
+{
+	if (event.getMouseDownX() >= labelWidth)
+		updateSelection(event);
+}
+
+void TrackBrowser::updateSelection(const juce::MouseEvent& event)
+{
+	float x0 = static_cast<float>(juce::jmax(labelWidth, juce::jmin(event.getMouseDownX(), event.x)));
+	float x1 = static_cast<float>(juce::jmin(getWidth(), juce::jmax(event.getMouseDownX(), event.x)));
+	selectionStart = xToClock(x0);
+	selectionEnd = xToClock(x1);
+
+	//every row the drag crosses is part of the selection
+	selectedIds.clearQuick();
+	if (!rowIds.isEmpty())
+	{
+		int rowHeight = juce::jmax(16, getHeight() / rowIds.size());
+		int firstRow = juce::jlimit(0, rowIds.size() - 1, juce::jmin(event.getMouseDownY(), event.y) / rowHeight);
+		int lastRow = juce::jlimit(0, rowIds.size() - 1, juce::jmax(event.getMouseDownY(), event.y) / rowHeight);
+		for (int row = firstRow; row <= lastRow; row++)
+			selectedIds.add(rowIds[row]);
+	}
+	repaint();
+}
+
+bool TrackBrowser::isExporting() const
+{
+	return exportThread != nullptr && exportThread->isThreadRunning();
+}
+
+bool TrackBrowser::exportSelection(const juce::File& folder, ExportFormat format)
+{
+	if (isExporting() || !hasSelection())
+		return false;
+
+	//the ranges are fixed now, files are opened and written on the export thread
+	std::vector<ExportThread::Track> tracks;
+	juce::StringArray usedNames;
+	{
+		auto& registry = InstanceRegistry::getInstance();
+		juce::ScopedLock lock(registry.getLock());
+		for (auto& instance : registry.getInstances())
+		{
+			if (!selectedIds.contains(instance.id))
+				continue;
+
+			juce::int64 start = clockToSample(instance, selectionStart);
+			juce::int64 end = clockToSample(instance, selectionEnd);
+			if (end <= start)
+				continue;
+
+			juce::String name = juce::File::createLegalFileName(instance.name);
+			if (usedNames.contains(name))
+				name << "_" << instance.id;
+			usedNames.add(name);
+
+			ExportThread::Track track;
+			track.id = instance.id;
+			track.name = name;
+			track.start = start;
+			track.numSamples = static_cast<int>(juce::jmin<juce::int64>(end - start, std::numeric_limits<int>::max()));
+			tracks.push_back(std::move(track));
+		}
+	}
+	if (tracks.empty())
+		return false;
+
+	exportThread = std::make_unique<ExportThread>(*this, folder, format, std::move(tracks));
+	exportThread->startThread(juce::Thread::Priority::background);
+	return true;
+}
@@ -0,0 +1,76 @@
+/*
+  ==============================================================================
+
+	TrackBrowser.h
+	Created: 19 Oct 2026 3:46:55pm
+	Author:  Tokamak
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "AudioExport.h"
+#include "InstanceRegistry.h"
+
+//==============================================================================
+/**
+	Stacked, time-aligned view of every ReSampler instance in the process.
+
+	Rows are drawn from each instance's own waveform summary and lined up on the
+	process sample clock (InstanceRegistry::advanceClock), so no other editor
+	has to be open. A drag selects a clock range over the rows it crosses, the
+	selection exports on a background thread straight from the rings through
+	visitHistory, one chunk of every track at a time. Hibernated tracks are
+	restored by their IdleHibernator before they are read, the export thread
+	only asks for it and waits.
+*/
+class TrackBrowser : public juce::Component
+{
+public:
+	TrackBrowser();
+	~TrackBrowser() override;
+
+	void setColours(juce::Colour background, juce::Colour wave, juce::Colour selection, juce::Colour text);
+	void setVisibleSeconds(double seconds) { visibleSeconds = seconds; }
+
+	bool hasSelection() const { return !selectedIds.isEmpty() && selectionEnd > selectionStart; }
+	void clearSelection();
+	//writes one file per selected track into folder in the background, false if an export is still running;
+	//onExportFinished is called on the message thread with the number of tracks written and lapped by recording
+	bool exportSelection(const juce::File& folder, ExportFormat format);
+	bool isExporting() const;
+	std::function<void(int numExported, int numLapped)> onExportFinished;
+
+	void paint(juce::Graphics& g) override;
+	void mouseDown(const juce::MouseEvent& event) override;
+	void mouseDrag(const juce::MouseEvent& event) override;
+
+	static constexpr int labelWidth = 110;
+	static constexpr int chunkSamples = 65536;
+
+private:
+	class ExportThread;
+
+	double xToClock(float x) const;
+	float clockToX(double clock) const;
+	static juce::int64 clockToSample(const InstanceRegistry::Instance& instance, double clock);
+	void drawRow(juce::Graphics& g, const InstanceRegistry::Instance& instance, juce::Rectangle<int> area);
+	void updateSelection(const juce::MouseEvent& event);
+
+	double visibleSeconds = 30.0;
+	double viewEnd = 0.0;
+	//all instances of a process run at the host rate, the view uses the first one's
+	double clockRate = 44100.0;
+
+	//process sample clock range and the instances it covers
+	double selectionStart = 0.0;
+	double selectionEnd = 0.0;
+	juce::Array<int> selectedIds;
+	juce::Array<int> rowIds;
+
+	juce::Colour backgroundColour, waveColour, selectionColour, textColour;
+	std::unique_ptr<ExportThread> exportThread;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TrackBrowser)
+};
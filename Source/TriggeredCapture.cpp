@@ -0,0 +1,105 @@
+/*
+  ==============================================================================
+
+	TriggeredCapture.cpp
+	Created: 19 Oct 2026 4:11:18pm
+	Author:  Tokamak
+
+  ==============================================================================
+*/
+
+#include "TriggeredCapture.h"
+#include "BufferManager.h"
+#include "AudioExport.h"
+#include "Tracer.h"
+
+TriggeredCapture::TriggeredCapture(BufferManager& manager, juce::PropertiesFile& settingsToUse)
+	: juce::Thread("ReSampler Triggered Capture"), bufferManager(manager), settings(settingsToUse)
+{
+	startThread(juce::Thread::Priority::low);
+}
+
+TriggeredCapture::~TriggeredCapture()
+{
+	stopThread(5000);
+}
+
+bool TriggeredCapture::publish(juce::int64 startSample, juce::int64 endSample, int generation)
+{
+	if (queue.getFreeSpace() < 1)
+		return false;
+	int start1, size1, start2, size2;
+	queue.prepareToWrite(1, start1, size1, start2, size2);
+	ranges[start1] = { startSample, endSample, generation };
+	queue.finishedWrite(1);
+	return true;
+}
+
+juce::File TriggeredCapture::getLastFile() const
+{
+	juce::ScopedLock lock(fileLock);
+	return lastFile;
+}
+
+void TriggeredCapture::run()
+{
+	//polled, the audio thread must not signal an event
+	while (!threadShouldExit())
+	{
+		while (queue.getNumReady() > 0 && !threadShouldExit())
+		{
+			int start1, size1, start2, size2;
+			queue.prepareToRead(1, start1, size1, start2, size2);
+			Range range = ranges[start1];
+			queue.finishedRead(1);
+			write(range);
+		}
+		wait(20);
+	}
+}
+
+void TriggeredCapture::write(Range range)
+{
+	TRACE_ZONE("TriggeredCapture::write");
+	if (bufferManager.getRingSamples() == 0 || range.generation != bufferManager.getRingGeneration() || range.end <= range.start)
+	{
+		numFailed++;
+		return;
+	}
+
+	int numChannels = bufferManager.getBufferNumChannels();
+	int numSamples = static_cast<int>(range.end - range.start);
+	juce::AudioBuffer<float> audio(numChannels, numSamples);
+	int dropped = 0;
+	bool copied = bufferManager.readHistory(range.start, audio, 0, numSamples);
+	if (!copied)
+	{
+		//lapped, keep what is still there with a quarter second of room in front of the write head
+		juce::int64 oldest = bufferManager.getTotalSamplesWritten() - bufferManager.getRingSamples() + bufferManager.getBufferSampleRate() / 4;
+		dropped = static_cast<int>(juce::jlimit<juce::int64>(0, numSamples, oldest - range.start));
+		copied = dropped < numSamples && bufferManager.readHistory(range.start + dropped, audio, 0, numSamples - dropped);
+	}
+	if (!copied)
+	{
+		numFailed++;
+		return;
+	}
+
+	//same folder and format as the drag exports, read each time so changes apply
+	juce::File folder(settings.getValue("recordingPath",
+		juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory).getFullPathName() + "\\ReSampler\\Recordings"));
+	auto format = static_cast<ExportFormat>(juce::jlimit(0, numExportFormats - 1, settings.getIntValue("exportFormat", Wav24)));
+	folder.createDirectory();
+
+	juce::String timestamp = juce::Time::getCurrentTime().formatted("%Y%m%d_%H%M%S");
+	juce::File file = folder.getNonexistentChildFile("TKRS_capture_" + timestamp, AudioExport::getFileExtension(format), false);
+
+	if (!AudioExport::writeFile(audio, 0, numSamples - dropped, bufferManager.getBufferSampleRate(), format, file))
+	{
+		numFailed++;
+		return;
+	}
+	numWritten++;
+	juce::ScopedLock lock(fileLock);
+	lastFile = file;
+}
@@ -0,0 +1,63 @@
+/*
+  ==============================================================================
+
+	TriggeredCapture.h
+	Created: 19 Oct 2026 4:11:18pm
+	Author:  Tokamak
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+class BufferManager;
+
+//==============================================================================
+/**
+	Writes ranges of the history to files when a host parameter or a MIDI
+	trigger fires, with no editor open.
+
+	The audio thread only pushes the absolute range into a lock-free FIFO. A
+	background thread copies it out of the ring with readHistory and encodes it
+	in the export format chosen in the editor. Ranges are capped below the ring
+	length so the copy normally starts before the write head comes around; if it
+	is lapped anyway, the oldest part is dropped and the rest is still written.
+*/
+class TriggeredCapture : public juce::Thread
+{
+public:
+	TriggeredCapture(BufferManager& manager, juce::PropertiesFile& settingsToUse);
+	~TriggeredCapture() override;
+
+	//audio thread, false if the queue is full
+	bool publish(juce::int64 startSample, juce::int64 endSample, int generation);
+
+	juce::File getLastFile() const;
+	int getNumWritten() const { return numWritten.load(); }
+	int getNumFailed() const { return numFailed.load(); }
+
+	void run() override;
+
+	static constexpr int queueSize = 64;
+
+private:
+	struct Range
+	{
+		juce::int64 start = 0;
+		juce::int64 end = 0;
+		int generation = 0;
+	};
+
+	void write(Range range);
+
+	BufferManager& bufferManager;
+	juce::PropertiesFile& settings;
+	juce::AbstractFifo queue{ queueSize };
+	Range ranges[queueSize];
+
+	juce::CriticalSection fileLock;
+	juce::File lastFile;
+	std::atomic<int> numWritten{ 0 };
+	std::atomic<int> numFailed{ 0 };
+};
@@ -0,0 +1,138 @@
+/*
+  ==============================================================================
+
+	WaveformPyramid.cpp
+	Created: 19 Oct 2026 3:21:47pm
+	Author:  Tokamak
+
+  ==============================================================================
+*/
+
+#include "WaveformPyramid.h"
+
+static juce::int16 quantise(float value)
+{
+	return static_cast<juce::int16>(juce::jlimit(-WaveformSummary::fullScale, WaveformSummary::fullScale, juce::roundToInt(value * WaveformSummary::fullScale)));
+}
+
+void WaveformSummary::getMinMax(int channel, int ringStart, int numSamples, float& minValue, float& maxValue) const
+{
+	minValue = 0.0f;
+	maxValue = 0.0f;
+	if (isEmpty() || numSamples <= 0)
+		return;
+
+	int level = 0;
+	while (level + 1 < numLevels && getBlockSize(level + 1) <= numSamples)
+		level++;
+
+	int blockSize = getBlockSize(level);
+	int numBlocks = getNumBlocks(level);
+	const juce::int16* data = levels[level].data() + static_cast<size_t>(channel) * numBlocks * 2;
+
+	int first = ringStart / blockSize;
+	int count = juce::jmax(1, (ringStart + numSamples - 1) / blockSize - first + 1);
+	int low = fullScale;
+	int high = -fullScale;
+	for (int i = 0; i < count; i++)
+	{
+		int block = (first + i) % numBlocks;
+		low = juce::jmin(low, static_cast<int>(data[block * 2]));
+		high = juce::jmax(high, static_cast<int>(data[block * 2 + 1]));
+	}
+	minValue = low / static_cast<float>(fullScale);
+	maxValue = high / static_cast<float>(fullScale);
+}
+
+size_t WaveformSummary::getMemoryUsage() const
+{
+	size_t bytes = 0;
+	for (auto& level : levels)
+		bytes += level.size() * sizeof(juce::int16);
+	return bytes;
+}
+
+//==============================================================================
+void WaveformPyramid::prepare(int ringSamples, int numChannels, int sampleRate, int hopSize)
+{
+	juce::ScopedLock lock(storageLock);
+
+	summary.ringSamples = ringSamples;
+	summary.numChannels = numChannels;
+	summary.levels.resize(WaveformSummary::numLevels);
+	for (int level = 0; level < WaveformSummary::numLevels; level++)
+		summary.levels[level].assign(static_cast<size_t>(summary.getNumBlocks(level)) * numChannels * 2, 0);
+
+	summaryEnd.store(0, std::memory_order_release);
+	layoutVersion.fetch_add(1, std::memory_order_acq_rel);
+}
+
+void WaveformPyramid::processSamples(juce::int64 startSample, const juce::AudioBuffer<float>& buffer, int startInBuffer, int numSamples)
+{
+	if (summary.isEmpty())
+		return;
+
+	int ringSamples = summary.ringSamples;
+	int blockSize = WaveformSummary::getBlockSize(0);
+	int numBlocks = summary.getNumBlocks(0);
+	int numChannels = juce::jmin(summary.numChannels, buffer.getNumChannels());
+	int position = static_cast<int>(startSample % ringSamples);
+	int done = 0;
+
+	while (done < numSamples)
+	{
+		int block = position / blockSize;
+		int blockEnd = juce::jmin((block + 1) * blockSize, ringSamples);
+		int chunk = juce::jmin(numSamples - done, blockEnd - position);
+		bool startsBlock = position == block * blockSize;
+
+		for (int channel = 0; channel < numChannels; channel++)
+		{
+			auto range = juce::FloatVectorOperations::findMinAndMax(buffer.getReadPointer(channel, startInBuffer + done), chunk);
+			juce::int16* pair = summary.levels[0].data() + (static_cast<size_t>(channel) * numBlocks + block) * 2;
+			juce::int16 low = quantise(range.getStart());
+			juce::int16 high = quantise(range.getEnd());
+			pair[0] = startsBlock ? low : juce::jmin(pair[0], low);
+			pair[1] = startsBlock ? high : juce::jmax(pair[1], high);
+		}
+
+		updateParents(1, block, block);
+		done += chunk;
+		position = (position + chunk) % ringSamples;
+	}
+
+	summaryEnd.store(startSample + numSamples, std::memory_order_release);
+}
+
+void WaveformPyramid::updateParents(int level, int firstBlock, int lastBlock)
+{
+	if (level >= WaveformSummary::numLevels)
+		return;
+
+	int childBlocks = summary.getNumBlocks(level - 1);
+	int numBlocks = summary.getNumBlocks(level);
+	int firstParent = firstBlock / WaveformSummary::levelFactor;
+	int lastParent = lastBlock / WaveformSummary::levelFactor;
+
+	for (int channel = 0; channel < summary.numChannels; channel++)
+	{
+		const juce::int16* children = summary.levels[level - 1].data() + static_cast<size_t>(channel) * childBlocks * 2;
+		juce::int16* parents = summary.levels[level].data() + static_cast<size_t>(channel) * numBlocks * 2;
+
+		for (int parent = firstParent; parent <= lastParent; parent++)
+		{
+			int low = WaveformSummary::fullScale;
+			int high = -WaveformSummary::fullScale;
+			int lastChild = juce::jmin(childBlocks, (parent + 1) * WaveformSummary::levelFactor);
+			for (int child = parent * WaveformSummary::levelFactor; child < lastChild; child++)
+			{
+				low = juce::jmin(low, static_cast<int>(children[child * 2]));
+				high = juce::jmax(high, static_cast<int>(children[child * 2 + 1]));
+			}
+			parents[parent * 2] = static_cast<juce::int16>(low);
+			parents[parent * 2 + 1] = static_cast<juce::int16>(high);
+		}
+	}
+
+	updateParents(level + 1, firstParent, lastParent);
+}
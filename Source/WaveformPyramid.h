@@ -0,0 +1,66 @@
+/*
+  ==============================================================================
+
+	WaveformPyramid.h
+	Created: 19 Oct 2026 3:21:47pm
+	Author:  Tokamak
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "HistoryAnalyser.h"
+
+//==============================================================================
+/**
+	Ring-aligned min/max summary of the history at several resolutions.
+	Level 0 holds one 16-bit min/max pair per channel for every baseBlockSize
+	samples, each further level merges levelFactor blocks of the level below.
+	16 bits resolve quiet material down to -90 dBFS, 8 bits drew everything
+	below -42 dBFS as a flat line.
+	Plain data, so the editor can keep a copy of it while the view is frozen.
+*/
+struct WaveformSummary
+{
+	static constexpr int baseBlockSize = 16;
+	static constexpr int levelFactor = 4;
+	static constexpr int numLevels = 6;
+
+	int ringSamples = 0;
+	int numChannels = 0;
+	//levels[level][(channel * numBlocks + block) * 2] = min, +1 = max
+	std::vector<std::vector<juce::int16>> levels;
+
+	static int getBlockSize(int level) { return baseBlockSize << (2 * level); }
+	static constexpr int fullScale = 32767;
+	int getNumBlocks(int level) const { return (ringSamples + getBlockSize(level) - 1) / getBlockSize(level); }
+	bool isEmpty() const { return ringSamples == 0 || numChannels == 0; }
+
+	//min/max of [ringStart, ringStart + numSamples) at the coarsest level that still resolves the range
+	void getMinMax(int channel, int ringStart, int numSamples, float& minValue, float& maxValue) const;
+	size_t getMemoryUsage() const;
+};
+
+class WaveformPyramid : public AnalysisStage
+{
+public:
+	void prepare(int ringSamples, int numChannels, int sampleRate, int hopSize) override;
+	void processFrame(const AnalysisFrame& frame) override {}
+	void processSamples(juce::int64 startSample, const juce::AudioBuffer<float>& buffer, int startInBuffer, int numSamples) override;
+
+	//readers hold this while touching getSummary(), prepare() holds it while reallocating
+	juce::CriticalSection& getStorageLock() { return storageLock; }
+	const WaveformSummary& getSummary() const { return summary; }
+	int getLayoutVersion() const { return layoutVersion.load(std::memory_order_acquire); }
+	//absolute end of the audio summarised so far
+	juce::int64 getSummaryEnd() const { return summaryEnd.load(std::memory_order_acquire); }
+
+private:
+	void updateParents(int level, int firstBlock, int lastBlock);
+
+	juce::CriticalSection storageLock;
+	std::atomic<int> layoutVersion{ 0 };
+	std::atomic<juce::int64> summaryEnd{ 0 };
+	WaveformSummary summary;
+};
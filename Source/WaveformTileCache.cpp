@@ -0,0 +1,198 @@
+/*
+  ==============================================================================
+
+	WaveformTileCache.cpp
+	Created: 19 Oct 2026 3:21:47pm
+	Author:  Tokamak
+
+  ==============================================================================
+*/
+
+#include "WaveformTileCache.h"
+#include "Tracer.h"
+
+int WaveformTileCache::getLevelForZoom(double samplesPerPixel)
+{
+	//the finer neighbouring level, so tiles are only ever scaled down
+	return juce::jlimit(minLevel, maxLevel, static_cast<int>(std::floor(std::log2(samplesPerPixel))));
+}
+
+void WaveformTileCache::draw(juce::Graphics& g, int width, int height, double viewStart, double samplesPerPixel,
+	const WaveformSummary* summary, bool allowRender)
+{
+	TRACE_ZONE("WaveformTileCache::draw");
+	if (summary == nullptr || summary->isEmpty() || width <= 0 || height <= 0)
+		return;
+
+	if (height != tileHeight)
+	{
+		clear();
+		tileHeight = height;
+	}
+
+	frameCounter++;
+	int ringSamples = summary->ringSamples;
+	int level = getLevelForZoom(samplesPerPixel);
+	int tileSamples = getTileSamples(level);
+	double viewEnd = viewStart + width * samplesPerPixel;
+	double position = viewStart;
+
+	g.setImageResamplingQuality(juce::Graphics::lowResamplingQuality);
+
+	while (position < viewEnd)
+	{
+		int ringPosition = static_cast<int>(std::fmod(std::floor(position), static_cast<double>(ringSamples)));
+		int tile = ringPosition / tileSamples;
+		int tileStart = tile * tileSamples;
+		int tileEnd = juce::jmin(tileStart + tileSamples, ringSamples);
+
+		auto found = tiles.find(makeKey(level, tile));
+		if (found == tiles.end() && allowRender)
+		{
+			Tile newTile;
+			newTile.image = renderTile(level, tile, ringSamples, height, summary);
+			cacheBytes += static_cast<size_t>(newTile.image.getWidth()) * newTile.image.getHeight();
+			found = tiles.emplace(makeKey(level, tile), newTile).first;
+		}
+
+		double tileX = (std::floor(position) - (ringPosition - tileStart) - viewStart) / samplesPerPixel;
+		double tileW = (tileEnd - tileStart) / samplesPerPixel;
+		if (found != tiles.end())
+		{
+			found->second.lastUsed = frameCounter;
+			g.drawImage(found->second.image, juce::Rectangle<float>(static_cast<float>(tileX), 0.0f, static_cast<float>(tileW), static_cast<float>(height)),
+				juce::RectanglePlacement::stretchToFit, true);
+		}
+
+		position = std::floor(position) + (tileEnd - ringPosition);
+	}
+
+	shrinkTo(maxCacheBytes);
+}
+
+juce::Image WaveformTileCache::renderTile(int level, int tile, int ringSamples, int height, const WaveformSummary* summary)
+{
+	int tileSamples = getTileSamples(level);
+	int tileStart = tile * tileSamples;
+	int numSamples = juce::jmin(tileSamples, ringSamples - tileStart);
+	double samplesPerPixel = getSamplesPerPixel(level);
+	int imageWidth = juce::jmax(1, static_cast<int>(std::ceil(numSamples / samplesPerPixel)));
+	int numChannels = summary->numChannels;
+
+	juce::Image image(juce::Image::SingleChannel, imageWidth, height, true);
+	juce::Graphics g(image);
+	g.setColour(juce::Colours::white);
+
+	//below the first summary level the samples are read straight from the ring
+	bool useRawSamples = samplesPerPixel < WaveformSummary::baseBlockSize && rawReader != nullptr;
+	if (useRawSamples)
+	{
+		//one extra sample in front so neighbouring tiles join up
+		rawBuffer.setSize(numChannels, numSamples + 1, false, false, true);
+		rawReader((tileStart + ringSamples - 1) % ringSamples, numSamples + 1, rawBuffer);
+	}
+
+	float channelHeight = static_cast<float>(height) / numChannels;
+	for (int channel = 0; channel < numChannels; channel++)
+	{
+		float centre = channelHeight * (channel + 0.5f);
+		float halfHeight = channelHeight * 0.5f;
+
+		for (int x = 0; x < imageWidth; x++)
+		{
+			float minValue = 0.0f;
+			float maxValue = 0.0f;
+			int first = static_cast<int>(x * samplesPerPixel);
+			int count = juce::jmax(1, static_cast<int>((x + 1) * samplesPerPixel) - first);
+			count = juce::jmin(count, numSamples - first);
+			if (count <= 0)
+				break;
+
+			if (useRawSamples)
+			{
+				//include the previous sample so single samples are drawn as connected lines
+				auto range = juce::FloatVectorOperations::findMinAndMax(rawBuffer.getReadPointer(channel, first), count + 1);
+				minValue = range.getStart();
+				maxValue = range.getEnd();
+			}
+			else
+				summary->getMinMax(channel, tileStart + first, count, minValue, maxValue);
+
+			float top = centre - juce::jlimit(-1.0f, 1.0f, maxValue) * halfHeight;
+			float bottom = centre - juce::jlimit(-1.0f, 1.0f, minValue) * halfHeight;
+			g.fillRect(static_cast<float>(x), top, 1.0f, juce::jmax(1.0f, bottom - top));
+		}
+	}
+
+	return image;
+}
+
+void WaveformTileCache::invalidate(int ringStart, int numSamples, int ringSamples)
+{
+	if (numSamples >= ringSamples)
+	{
+		clear();
+		return;
+	}
+
+	int ringEnd = ringStart + numSamples;
+	for (auto it = tiles.begin(); it != tiles.end();)
+	{
+		int level = static_cast<int>(it->first >> 40) + minLevel;
+		int tileSamples = getTileSamples(level);
+		int tileStart = static_cast<int>(it->first & 0xffffffffff) * tileSamples;
+		int tileEnd = tileStart + tileSamples;
+
+		//the dirty range may wrap past the end of the ring, raw tiles also depend on the sample before them
+		bool overlaps = (tileStart <= ringEnd && tileEnd > ringStart)
+			|| (ringEnd > ringSamples && tileStart <= ringEnd - ringSamples);
+		if (overlaps)
+		{
+			cacheBytes -= static_cast<size_t>(it->second.image.getWidth()) * it->second.image.getHeight();
+			it = tiles.erase(it);
+		}
+		else
+			++it;
+	}
+}
+
+void WaveformTileCache::clear()
+{
+	tiles.clear();
+	cacheBytes = 0;
+}
+
+void WaveformTileCache::followSummary(int layoutVersion, juce::int64 summaryEnd, int ringSamples)
+{
+	if (summaryLayout != layoutVersion)
+	{
+		summaryLayout = layoutVersion;
+		lastSummaryEnd = 0;
+		clear();
+	}
+
+	if (summaryEnd > lastSummaryEnd)
+	{
+		juce::int64 dirty = juce::jmin<juce::int64>(summaryEnd - lastSummaryEnd, ringSamples);
+		invalidate(static_cast<int>((summaryEnd - dirty) % ringSamples), static_cast<int>(dirty), ringSamples);
+		lastSummaryEnd = summaryEnd;
+	}
+}
+
+void WaveformTileCache::shrinkTo(size_t maxBytes)
+{
+	while (cacheBytes > maxBytes && !tiles.empty())
+	{
+		auto oldest = tiles.begin();
+		for (auto it = tiles.begin(); it != tiles.end(); ++it)
+			if (it->second.lastUsed < oldest->second.lastUsed)
+				oldest = it;
+
+		//never evict what is on screen right now
+		if (oldest->second.lastUsed == frameCounter)
+			break;
+
+		cacheBytes -= static_cast<size_t>(oldest->second.image.getWidth()) * oldest->second.image.getHeight();
+		tiles.erase(oldest);
+	}
+}
@@ -0,0 +1,74 @@
+/*
+  ==============================================================================
+
+	WaveformTileCache.h
+	Created: 19 Oct 2026 3:21:47pm
+	Author:  Tokamak
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "WaveformPyramid.h"
+
+//==============================================================================
+/**
+	Renders the waveform as alpha-mask tiles of tileWidth pixels, one set per
+	power-of-two zoom level, and keeps them in an LRU cache so panning and
+	zooming only redraw the tiles that are new on screen. Tiles are drawn with
+	fillAlphaChannelWithCurrentBrush, so the theme's gradient still applies.
+
+	The processor owns the cache, so an editor opened again starts with the
+	tiles the last one left behind.
+*/
+class WaveformTileCache
+{
+public:
+	static constexpr int tileWidth = 256;
+	//level = log2(samples per pixel), negative levels show several pixels per sample
+	static constexpr int minLevel = -3;
+	static constexpr int maxLevel = 20;
+	static constexpr size_t maxCacheBytes = 32 * 1024 * 1024;
+
+	using RawReader = std::function<void(int ringStart, int numSamples, juce::AudioBuffer<float>& dest)>;
+
+	void setRawReader(RawReader reader) { rawReader = std::move(reader); }
+
+	//summary may be null while nothing has been analysed yet, tiles are only rendered when allowRender is set
+	void draw(juce::Graphics& g, int width, int height, double viewStart, double samplesPerPixel,
+		const WaveformSummary* summary, bool allowRender);
+	void invalidate(int ringStart, int numSamples, int ringSamples);
+	void clear();
+	//drops the tiles covering audio summarised since the last call, everything if the summary was relaid
+	void followSummary(int layoutVersion, juce::int64 summaryEnd, int ringSamples);
+	int getSummaryLayout() const { return summaryLayout; }
+	//least recently drawn tiles first, the ones on screen stay
+	void shrinkTo(size_t maxBytes);
+
+	size_t getMemoryUsage() const { return cacheBytes; }
+	int getNumTiles() const { return static_cast<int>(tiles.size()); }
+
+	static int getLevelForZoom(double samplesPerPixel);
+	static double getSamplesPerPixel(int level) { return std::ldexp(1.0, level); }
+
+private:
+	struct Tile
+	{
+		juce::Image image;
+		juce::uint32 lastUsed = 0;
+	};
+
+	static juce::int64 makeKey(int level, int tile) { return (static_cast<juce::int64>(level - minLevel) << 40) | tile; }
+	int getTileSamples(int level) const { return juce::jmax(1, static_cast<int>(tileWidth * getSamplesPerPixel(level))); }
+	juce::Image renderTile(int level, int tile, int ringSamples, int height, const WaveformSummary* summary);
+
+	std::map<juce::int64, Tile> tiles;
+	size_t cacheBytes = 0;
+	juce::uint32 frameCounter = 0;
+	int tileHeight = 0;
+	int summaryLayout = -1;
+	juce::int64 lastSummaryEnd = 0;
+	RawReader rawReader;
+	juce::AudioBuffer<float> rawBuffer;
+};
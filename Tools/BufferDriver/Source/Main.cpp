@@ -0,0 +1,507 @@
+/*
+  ==============================================================================
+
+	Main.cpp
+	Created: 19 Oct 2026 4:07:21pm
+	Author:  Tokamak
+
+	Headless driver for BufferManager. Streams WAV files through writeToBuffer
+	and readFromBuffer block by block as fast as the machine allows, applies a
+	script of transport and export commands at exact sample offsets, writes the
+	exports through the plugin's own export code and reports throughput as JSON.
+	Input files are processed in parallel, one per core.
+
+	BufferDriver --benchmark-writer S [--output-dir dir] [--report file.json]
+		exports S seconds of a stereo ring across its wrap with each WAV format,
+		through WavAudioFormat and through PcmWriter, to memory and to a file
+
+	BufferDriver [options] input.wav...
+		--block N			samples per block (512)
+		--length S			ring length in seconds (30)
+		--script file		commands to apply, see below
+		--format name		export format: wav16 wav24 wav32 flac16 flac24 aiff24 wav16dither (wav24)
+		--output-dir dir	where exports go (current directory)
+		--render			also write what the plugin would output, <input>_render.wav
+		--offline			write blocks like a host bounce (streaming stores)
+		--threads N			files processed at once (number of cores)
+		--report file.json	write the report to a file instead of stdout
+
+	Script, one command per line, # starts a comment. Offsets are input samples,
+	or seconds with an s suffix. Commands at the same offset run in file order,
+	before the block that starts there.
+
+		<at> pause					stop recording
+		<at> record					resume recording
+		<at> play <from>			play back from a history position
+		<at> stop					stop playback
+		<at> select <from> <length>	select a range of the history
+		<at> export [name]			export the selection
+
+	History positions count samples written to the ring, so they stand still
+	while recording is paused. Negative positions are relative to the write head,
+	"select -10s 10s" is the last ten seconds.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <iostream>
+#include "../../../Source/BufferManager.h"
+#include "../../../Source/AudioExport.h"
+
+//==============================================================================
+struct ScriptCommand
+{
+	juce::String at;
+	juce::String name;
+	juce::StringArray arguments;
+	int line = 0;
+};
+
+struct DriverSettings
+{
+	int blockSize = 512;
+	int bufferLength = 30;
+	ExportFormat format = Wav24;
+	juce::File outputDirectory;
+	bool render = false;
+	bool offline = false;
+	juce::Array<ScriptCommand> script;
+};
+
+//samples, or seconds with an s suffix
+static juce::int64 parsePosition(const juce::String& text, double sampleRate)
+{
+	if (text.endsWithIgnoreCase("s"))
+		return static_cast<juce::int64>(std::llround(text.dropLastCharacters(1).getDoubleValue() * sampleRate));
+	return text.getLargeIntValue();
+}
+
+static bool parseFormat(const juce::String& text, ExportFormat& format)
+{
+	static const char* names[] = { "wav16", "wav24", "wav32", "flac16", "flac24", "aiff24", "wav16dither" };
+	for (int i = 0; i < numExportFormats; i++)
+	{
+		if (text.equalsIgnoreCase(names[i]))
+		{
+			format = static_cast<ExportFormat>(i);
+			return true;
+		}
+	}
+	return false;
+}
+
+static bool parseScript(const juce::File& file, juce::Array<ScriptCommand>& script)
+{
+	static const juce::StringArray knownCommands{ "pause", "record", "play", "stop", "select", "export" };
+	juce::StringArray lines;
+	lines.addLines(file.loadFileAsString());
+	for (int i = 0; i < lines.size(); i++)
+	{
+		auto tokens = juce::StringArray::fromTokens(lines[i].upToFirstOccurrenceOf("#", false, false), true);
+		tokens.removeEmptyStrings();
+		if (tokens.isEmpty())
+			continue;
+
+		ScriptCommand command;
+		command.line = i + 1;
+		command.at = tokens[0];
+		command.name = tokens[1].toLowerCase();
+		for (int token = 2; token < tokens.size(); token++)
+			command.arguments.add(tokens[token]);
+		if (!knownCommands.contains(command.name) || (command.name == "play" && command.arguments.size() < 1)
+			|| (command.name == "select" && command.arguments.size() < 2))
+		{
+			std::cerr << file.getFileName() << ":" << command.line << ": cannot parse \"" << lines[i] << "\"" << std::endl;
+			return false;
+		}
+		script.add(command);
+	}
+	return true;
+}
+
+//==============================================================================
+class FileDriver
+{
+public:
+	FileDriver(const juce::File& inputFile, const DriverSettings& driverSettings)
+		: input(inputFile), settings(driverSettings)
+	{
+	}
+
+	juce::var run()
+	{
+		auto* result = new juce::DynamicObject();
+		result->setProperty("file", input.getFullPathName());
+
+		juce::AudioFormatManager formatManager;
+		formatManager.registerBasicFormats();
+		std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(input));
+		if (reader == nullptr)
+		{
+			result->setProperty("error", "cannot read the file");
+			return juce::var(result);
+		}
+		sampleRate = reader->sampleRate;
+		int numChannels = static_cast<int>(reader->numChannels);
+
+		//the same setup prepareToPlay does, with the driver's own buffer length
+		bufferManager.initializeBuffer(numChannels, static_cast<int>(sampleRate), settings.bufferLength);
+		bufferManager.setOfflineMode(settings.offline);
+
+		//commands sorted by offset, file order kept for equal offsets
+		juce::Array<std::pair<juce::int64, ScriptCommand>> commands;
+		for (auto& command : settings.script)
+			commands.add({ parsePosition(command.at, sampleRate), command });
+		std::stable_sort(commands.begin(), commands.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+		std::unique_ptr<juce::AudioFormatWriter> renderWriter;
+		if (settings.render)
+		{
+			juce::File renderFile = getOutputFile("render", Wav24);
+			renderFile.deleteFile();
+			std::unique_ptr<juce::FileOutputStream> stream(renderFile.createOutputStream());
+			if (stream != nullptr && (renderWriter = AudioExport::createWriter(Wav24, stream.get(), sampleRate, numChannels)) != nullptr)
+				stream.release();
+			else
+				errors.add("cannot write " + renderFile.getFullPathName());
+		}
+
+		juce::AudioBuffer<float> block(numChannels, settings.blockSize);
+		juce::int64 length = reader->lengthInSamples;
+		juce::int64 position = 0;
+		int nextCommand = 0;
+		juce::int64 ringTicks = 0;
+		int numBlocks = 0;
+		auto startTicks = juce::Time::getHighResolutionTicks();
+
+		while (position < length)
+		{
+			while (nextCommand < commands.size() && commands[nextCommand].first <= position)
+				apply(commands.getReference(nextCommand++).second);
+
+			//blocks are cut at command offsets so every command lands on its exact sample
+			juce::int64 blockEnd = juce::jmin(length, position + settings.blockSize);
+			if (nextCommand < commands.size())
+				blockEnd = juce::jmin(blockEnd, commands[nextCommand].first);
+			int numSamples = static_cast<int>(blockEnd - position);
+			block.setSize(numChannels, numSamples, false, false, true);
+			reader->read(&block, 0, numSamples, position, true, true);
+
+			auto blockStart = juce::Time::getHighResolutionTicks();
+			bufferManager.writeToBuffer(block);
+			bufferManager.readFromBuffer(block);
+			ringTicks += juce::Time::getHighResolutionTicks() - blockStart;
+
+			if (renderWriter != nullptr)
+				renderWriter->writeFromAudioSampleBuffer(block, 0, numSamples);
+			position = blockEnd;
+			numBlocks++;
+		}
+
+		//commands at or past the end of the file, typically the final export
+		while (nextCommand < commands.size())
+			apply(commands.getReference(nextCommand++).second);
+		renderWriter.reset();
+
+		double wallSeconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+		double ringSeconds = juce::Time::highResolutionTicksToSeconds(ringTicks);
+		double audioSeconds = length / sampleRate;
+		double bytes = static_cast<double>(length) * numChannels * sizeof(float);
+		result->setProperty("sampleRate", sampleRate);
+		result->setProperty("channels", numChannels);
+		result->setProperty("samples", length);
+		result->setProperty("blocks", numBlocks);
+		result->setProperty("audioSeconds", audioSeconds);
+		result->setProperty("wallSeconds", wallSeconds);
+		result->setProperty("ringSeconds", ringSeconds);
+		result->setProperty("exportSeconds", exportSeconds);
+		result->setProperty("realtimeFactor", audioSeconds / juce::jmax(1.0e-9, wallSeconds));
+		result->setProperty("ringRealtimeFactor", audioSeconds / juce::jmax(1.0e-9, ringSeconds));
+		result->setProperty("ringMegabytesPerSecond", bytes / (1024.0 * 1024.0) / juce::jmax(1.0e-9, ringSeconds));
+		result->setProperty("exports", exports);
+		if (errors.size() > 0)
+			result->setProperty("errors", errors);
+		return juce::var(result);
+	}
+
+private:
+	//a history position, negative ones count back from the write head
+	juce::int64 toHistory(const juce::String& text) const
+	{
+		juce::int64 value = parsePosition(text, sampleRate);
+		return value < 0 ? bufferManager.getTotalSamplesWritten() + value : value;
+	}
+
+	juce::File getOutputFile(const juce::String& suffix, ExportFormat format) const
+	{
+		return settings.outputDirectory.getChildFile(input.getFileNameWithoutExtension() + "_" + suffix + AudioExport::getFileExtension(format));
+	}
+
+	void apply(const ScriptCommand& command)
+	{
+		auto& state = bufferManager.bufferState;
+		int ringSamples = bufferManager.getRingSamples();
+		if (command.name == "pause")
+			state.isRecording = false;
+		else if (command.name == "record")
+			state.isRecording = true;
+		else if (command.name == "stop")
+			state.isPlaying = false;
+		else if (command.name == "play")
+		{
+			juce::int64 from = toHistory(command.arguments[0]);
+			state.readPosition = static_cast<int>(((from % ringSamples) + ringSamples) % ringSamples);
+			state.isPlaying = true;
+		}
+		else if (command.name == "select")
+		{
+			selectionStart = toHistory(command.arguments[0]);
+			selectionLength = juce::jlimit<juce::int64>(0, ringSamples, parsePosition(command.arguments[1], sampleRate));
+		}
+		else if (command.name == "export")
+		{
+			exportSelection(command.arguments.isEmpty() ? "export" + juce::String(exports.size() + 1) : command.arguments[0], command.line);
+		}
+	}
+
+	void exportSelection(const juce::String& name, int line)
+	{
+		auto* entry = new juce::DynamicObject();
+		juce::File file = getOutputFile(name, settings.format);
+		entry->setProperty("name", name);
+		entry->setProperty("file", file.getFullPathName());
+		entry->setProperty("start", selectionStart);
+		entry->setProperty("length", selectionLength);
+
+		auto start = juce::Time::getHighResolutionTicks();
+		int numSamples = static_cast<int>(selectionLength);
+		juce::AudioBuffer<float> audio(bufferManager.getBufferNumChannels(), juce::jmax(1, numSamples));
+		bool ok = numSamples > 0 && bufferManager.readHistory(selectionStart, audio, 0, numSamples);
+		file.deleteFile();
+		if (!ok)
+			errors.add("line " + juce::String(line) + ": selection is not in the history");
+		else if (!(ok = AudioExport::writeFile(audio, 0, numSamples, sampleRate, settings.format, file)))
+			errors.add("line " + juce::String(line) + ": cannot write " + file.getFullPathName());
+		exportSeconds += juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+
+		entry->setProperty("ok", ok);
+		exports.add(juce::var(entry));
+	}
+
+	juce::File input;
+	const DriverSettings& settings;
+	BufferManager bufferManager;
+	double sampleRate = 44100.0;
+	juce::int64 selectionStart = 0;
+	juce::int64 selectionLength = 0;
+	double exportSeconds = 0.0;
+	juce::Array<juce::var> exports;
+	juce::Array<juce::var> errors;
+};
+
+//==============================================================================
+//counts bytes and keeps nothing, so the conversion is measured without the disk
+class NullOutputStream : public juce::OutputStream
+{
+public:
+	void flush() override {}
+	bool setPosition(juce::int64 newPosition) override
+	{
+		position = newPosition;
+		return true;
+	}
+	juce::int64 getPosition() override { return position; }
+	bool write(const void*, size_t numBytes) override
+	{
+		position += static_cast<juce::int64>(numBytes);
+		return true;
+	}
+
+private:
+	juce::int64 position = 0;
+};
+
+static juce::var benchmarkWriters(double seconds, const juce::File& directory)
+{
+	const double sampleRate = 48000.0;
+	const int numChannels = 2;
+	int numSamples = juce::jmax(1, static_cast<int>(seconds * sampleRate));
+	juce::AudioBuffer<float> ring(numChannels, numSamples);
+	juce::Random random(1);
+	for (int channel = 0; channel < numChannels; channel++)
+		for (int i = 0; i < numSamples; i++)
+			ring.setSample(channel, i, 0.5f * (random.nextFloat() * 2.0f - 1.0f));
+
+	//like a live selection: the export starts a third into the ring and wraps around
+	int start = numSamples / 3;
+	double gigabytes = static_cast<double>(numSamples) * numChannels * sizeof(float) / 1.0e9;
+	juce::File file = directory.getNonexistentChildFile("BufferDriver_writer", ".wav", false);
+
+	auto measure = [&](ExportFormat format, bool usePcmWriter, bool toFile)
+		{
+			double best = 1.0e9;
+			for (int run = 0; run < 3; run++)
+			{
+				file.deleteFile();
+				std::unique_ptr<juce::OutputStream> stream;
+				if (toFile)
+					stream = file.createOutputStream();
+				else
+					stream = std::make_unique<NullOutputStream>();
+				if (stream == nullptr)
+					return 0.0;
+
+				auto startTicks = juce::Time::getHighResolutionTicks();
+				std::unique_ptr<juce::AudioFormatWriter> writer;
+				if (usePcmWriter)
+					writer = AudioExport::createWriter(format, stream.get(), sampleRate, numChannels);
+				else
+					writer.reset(juce::WavAudioFormat().createWriterFor(stream.get(), sampleRate, numChannels, AudioExport::getBitsPerSample(format), {}, 0));
+				if (writer == nullptr)
+					return 0.0;
+				stream.release();
+				writer->writeFromAudioSampleBuffer(ring, start, numSamples - start);
+				writer->writeFromAudioSampleBuffer(ring, 0, start);
+				writer.reset();
+				best = juce::jmin(best, juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks));
+			}
+			return gigabytes / juce::jmax(1.0e-9, best);
+		};
+
+	juce::Array<juce::var> results;
+	for (auto format : { Wav16, Wav16Dither, Wav24, Wav32Float })
+	{
+		auto* result = new juce::DynamicObject();
+		result->setProperty("format", AudioExport::getFormatName(format));
+		//WavAudioFormat has no dither, its plain 16-bit path is the baseline
+		for (bool toFile : { false, true })
+		{
+			double baseline = measure(format == Wav16Dither ? Wav16 : format, false, toFile);
+			double pcm = measure(format, true, toFile);
+			juce::String target = toFile ? "File" : "Memory";
+			result->setProperty("wavAudioFormat" + target + "GBps", baseline);
+			result->setProperty("pcmWriter" + target + "GBps", pcm);
+			result->setProperty("speedup" + target, pcm / juce::jmax(1.0e-9, baseline));
+		}
+		results.add(juce::var(result));
+		std::cerr << ".";
+	}
+	std::cerr << std::endl;
+	file.deleteFile();
+
+	auto* report = new juce::DynamicObject();
+	report->setProperty("sampleRate", sampleRate);
+	report->setProperty("channels", numChannels);
+	report->setProperty("seconds", numSamples / sampleRate);
+	report->setProperty("inputGigabytes", gigabytes);
+	report->setProperty("results", results);
+	return juce::var(report);
+}
+
+static int writeReport(const juce::ArgumentList& args, const juce::var& report)
+{
+	juce::String json = juce::JSON::toString(report);
+	if (args.containsOption("--report"))
+		return juce::File::getCurrentWorkingDirectory().getChildFile(args.getValueForOption("--report")).replaceWithText(json) ? 0 : 1;
+	std::cout << json << std::endl;
+	return 0;
+}
+
+//==============================================================================
+static int run(const juce::ArgumentList& args)
+{
+	static const juce::StringArray valueOptions{ "--block", "--length", "--script", "--format", "--output-dir", "--threads", "--report", "--benchmark-writer" };
+	juce::File workingDirectory = juce::File::getCurrentWorkingDirectory();
+
+	DriverSettings settings;
+	if (args.containsOption("--block"))
+		settings.blockSize = juce::jmax(1, args.getValueForOption("--block").getIntValue());
+	if (args.containsOption("--length"))
+		settings.bufferLength = juce::jlimit(1, 600, args.getValueForOption("--length").getIntValue());
+	if (args.containsOption("--format") && !parseFormat(args.getValueForOption("--format"), settings.format))
+	{
+		std::cerr << "unknown format " << args.getValueForOption("--format") << std::endl;
+		return 1;
+	}
+	if (args.containsOption("--script") && !parseScript(workingDirectory.getChildFile(args.getValueForOption("--script")), settings.script))
+		return 1;
+	settings.outputDirectory = args.containsOption("--output-dir") ? workingDirectory.getChildFile(args.getValueForOption("--output-dir")) : workingDirectory;
+	settings.outputDirectory.createDirectory();
+	if (args.containsOption("--benchmark-writer"))
+		return writeReport(args, benchmarkWriters(juce::jlimit(1.0, 3600.0, args.getValueForOption("--benchmark-writer").getDoubleValue()), settings.outputDirectory));
+	settings.render = args.containsOption("--render");
+	settings.offline = args.containsOption("--offline");
+
+	//every argument that is neither an option nor an option's value is an input
+	juce::Array<juce::File> inputs;
+	for (int i = 0; i < args.size(); i++)
+	{
+		auto text = args[i].text;
+		if (valueOptions.contains(text))
+			i++;
+		else if (!text.startsWith("-"))
+			inputs.add(workingDirectory.getChildFile(text.unquoted()));
+	}
+	if (inputs.isEmpty())
+	{
+		std::cerr << "usage: BufferDriver [--block N] [--length S] [--script file] [--format wav24] [--output-dir dir] [--render] [--offline] [--threads N] [--report file.json] input.wav..." << std::endl;
+		std::cerr << "       BufferDriver --benchmark-writer S [--output-dir dir] [--report file.json]" << std::endl;
+		return 1;
+	}
+
+	int numThreads = args.containsOption("--threads") ? juce::jmax(1, args.getValueForOption("--threads").getIntValue()) : juce::SystemStats::getNumCpus();
+	std::vector<juce::var> results(static_cast<size_t>(inputs.size()));
+	auto startTicks = juce::Time::getHighResolutionTicks();
+	{
+		juce::ThreadPool pool(juce::ThreadPoolOptions().withThreadName("BufferDriver").withNumberOfThreads(juce::jmin(numThreads, inputs.size())));
+		std::atomic<int> remaining{ inputs.size() };
+		juce::WaitableEvent finished;
+		for (int i = 0; i < inputs.size(); i++)
+		{
+			pool.addJob([&, i]
+				{
+					FileDriver driver(inputs[i], settings);
+					results[static_cast<size_t>(i)] = driver.run();
+					std::cerr << ".";
+					if (--remaining == 0)
+						finished.signal();
+				});
+		}
+		finished.wait();
+	}
+	std::cerr << std::endl;
+	double wallSeconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+
+	double audioSeconds = 0.0;
+	int numFailed = 0;
+	juce::Array<juce::var> files;
+	for (auto& result : results)
+	{
+		audioSeconds += static_cast<double>(result.getProperty("audioSeconds", 0.0));
+		numFailed += result.hasProperty("error") || result.hasProperty("errors") ? 1 : 0;
+		files.add(result);
+	}
+
+	auto* report = new juce::DynamicObject();
+	report->setProperty("blockSize", settings.blockSize);
+	report->setProperty("bufferLength", settings.bufferLength);
+	report->setProperty("format", AudioExport::getFormatName(settings.format));
+	report->setProperty("threads", juce::jmin(numThreads, inputs.size()));
+	report->setProperty("audioSeconds", audioSeconds);
+	report->setProperty("wallSeconds", wallSeconds);
+	report->setProperty("realtimeFactor", audioSeconds / juce::jmax(1.0e-9, wallSeconds));
+	report->setProperty("failed", numFailed);
+	report->setProperty("files", files);
+	if (writeReport(args, juce::var(report)) != 0)
+		return 1;
+	return numFailed > 0 ? 1 : 0;
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+	juce::ScopedJuceInitialiser_GUI juceInitialiser;
+	juce::ArgumentList args(argc, argv);
+	return run(args);
+}
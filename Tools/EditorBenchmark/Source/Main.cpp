@@ -0,0 +1,247 @@
+/*
+  ==============================================================================
+
+	Main.cpp
+	Created: 19 Oct 2026 3:33:32pm
+	Author:  Tokamak
+
+	Headless rendering benchmark for ReSamplerAudioProcessorEditor. Fills the
+	history with synthetic audio, then for every buffer length, window size and
+	theme runs the editor timer and paints into an off-screen image, reporting
+	frame times and main thread allocations as JSON.
+
+	EditorBenchmark [--frames N] [--quick] [--output file.json]
+
+	No OpenGL context is created because the editor never gets a peer. On Linux
+	run it under xvfb-run if the JUCE build insists on a display.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include "../../../Source/PluginProcessor.h"
+#include "../../../Source/PluginEditor.h"
+
+//==============================================================================
+//allocation counting, only for the thread that switches it on
+namespace
+{
+	thread_local bool countAllocations = false;
+	thread_local juce::int64 numAllocations = 0;
+	thread_local juce::int64 allocatedBytes = 0;
+}
+
+void* operator new(std::size_t size)
+{
+	if (countAllocations)
+	{
+		numAllocations++;
+		allocatedBytes += static_cast<juce::int64>(size);
+	}
+	if (void* p = std::malloc(size == 0 ? 1 : size))
+		return p;
+	throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) { return operator new(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+//==============================================================================
+struct EditorBenchmark
+{
+	static constexpr double sampleRate = 48000.0;
+	static constexpr int blockSize = 512;
+
+	ReSamplerAudioProcessor& processor;
+	ReSamplerAudioProcessorEditor& editor;
+	juce::AudioBuffer<float> block{ 2, blockSize };
+	juce::int64 generated = 0;
+
+	//deterministic drums over a pad with a little noise, so onsets, tiles and the spectrogram all have work
+	void generateBlock()
+	{
+		juce::Random random(generated);
+		for (int i = 0; i < blockSize; i++)
+		{
+			double t = (generated + i) / sampleRate;
+			double beat = std::fmod(t, 0.5);
+			float kick = static_cast<float>(std::sin(juce::MathConstants<double>::twoPi * 60.0 * beat) * std::exp(-beat * 12.0));
+			float pad = 0.2f * static_cast<float>(std::sin(juce::MathConstants<double>::twoPi * 220.0 * t) * std::sin(juce::MathConstants<double>::twoPi * 0.1 * t));
+			float noise = 0.03f * (random.nextFloat() * 2.0f - 1.0f);
+			block.setSample(0, i, 0.6f * kick + pad + noise);
+			block.setSample(1, i, 0.6f * kick - pad + noise);
+		}
+		generated += blockSize;
+	}
+
+	void writeAudio(double seconds)
+	{
+		int numBlocks = juce::roundToInt(seconds * sampleRate / blockSize);
+		for (int i = 0; i < numBlocks; i++)
+		{
+			generateBlock();
+			processor.bufferManager->writeToBuffer(block);
+
+			//catch up well before the analyser would skip ahead (half a ring)
+			if (i % 64 == 63)
+				analyse();
+		}
+		analyse();
+	}
+
+	void analyse()
+	{
+		while (processor.historyAnalyser->processPendingFrames(4096) > 0)
+		{
+		}
+	}
+
+	juce::var runCase(Theme theme, int width, int height, int bufferSeconds, int numFrames)
+	{
+		editor.setTheme(theme);
+		editor.setSize(width, height);
+		editor.tileCache.clear();
+
+		juce::Image image(juce::Image::ARGB, width, height, true);
+		juce::Array<double> frameTimes;
+		juce::int64 frameAllocations = 0;
+		juce::int64 frameBytes = 0;
+		double coldMillis = 0.0;
+
+		for (int frame = 0; frame <= numFrames; frame++)
+		{
+			//one timer tick worth of new audio per frame, like a live session
+			writeAudio(1.0 / 40.0);
+
+			numAllocations = 0;
+			allocatedBytes = 0;
+			countAllocations = true;
+			auto start = juce::Time::getHighResolutionTicks();
+			{
+				editor.timerCallback();
+				juce::Graphics g(image);
+				editor.paintEntireComponent(g, true);
+			}
+			auto end = juce::Time::getHighResolutionTicks();
+			countAllocations = false;
+
+			double millis = juce::Time::highResolutionTicksToSeconds(end - start) * 1000.0;
+			if (frame == 0)
+			{
+				//the first frame renders every visible tile
+				coldMillis = millis;
+				continue;
+			}
+			frameTimes.add(millis);
+			frameAllocations += numAllocations;
+			frameBytes += allocatedBytes;
+		}
+
+		std::sort(frameTimes.begin(), frameTimes.end());
+		double sum = 0.0;
+		for (auto t : frameTimes)
+			sum += t;
+
+		auto* result = new juce::DynamicObject();
+		static const char* themeNames[] = { "Rainbow", "Light", "Dark", "Matrix" };
+		result->setProperty("theme", themeNames[theme]);
+		result->setProperty("width", width);
+		result->setProperty("height", height);
+		result->setProperty("bufferSeconds", bufferSeconds);
+		result->setProperty("frames", numFrames);
+		result->setProperty("coldFrameMs", coldMillis);
+		result->setProperty("meanFrameMs", sum / juce::jmax(1, frameTimes.size()));
+		result->setProperty("p50FrameMs", frameTimes[frameTimes.size() / 2]);
+		result->setProperty("p95FrameMs", frameTimes[juce::jmin(frameTimes.size() - 1, frameTimes.size() * 95 / 100)]);
+		result->setProperty("maxFrameMs", frameTimes.getLast());
+		result->setProperty("allocationsPerFrame", static_cast<double>(frameAllocations) / juce::jmax(1, numFrames));
+		result->setProperty("allocatedBytesPerFrame", static_cast<double>(frameBytes) / juce::jmax(1, numFrames));
+		result->setProperty("tileCacheBytes", static_cast<juce::int64>(editor.tileCache.getMemoryUsage()));
+		return juce::var(result);
+	}
+
+	//time from the editor constructor to its first painted frame, as the editor measures it
+	static double paintFirstFrame(ReSamplerAudioProcessorEditor& editor)
+	{
+		juce::Image image(juce::Image::ARGB, editor.getWidth(), editor.getHeight(), true);
+		juce::Graphics g(image);
+		editor.paintEntireComponent(g, true);
+		return editor.firstFrameMillis;
+	}
+
+	static int run(const juce::ArgumentList& args)
+	{
+		int numFrames = args.containsOption("--frames") ? args.getValueForOption("--frames").getIntValue() : 120;
+		bool quick = args.containsOption("--quick");
+
+		juce::Array<int> bufferLengths = quick ? juce::Array<int>{ 30 } : juce::Array<int>{ 15, 30, 60, 120, 300, 600 };
+		juce::Array<juce::Point<int>> sizes = quick ? juce::Array<juce::Point<int>>{ { 800, 100 } }
+			: juce::Array<juce::Point<int>>{ { 600, 75 }, { 800, 100 }, { 1280, 160 }, { 1920, 240 }, { 2560, 320 }, { 3840, 480 } };
+		juce::Array<Theme> themes{ Theme::Rainbow, Theme::Dark, Theme::Light, Theme::Matrix };
+
+		ReSamplerAudioProcessor processor;
+		processor.prepareToPlay(sampleRate, blockSize);
+		auto editor = std::make_unique<ReSamplerAudioProcessorEditor>(processor);
+		double firstFrameMillis = paintFirstFrame(*editor);
+
+		//the editor saves its settings, put the user's back afterwards
+		Theme originalTheme = editor->properties.theme;
+		int originalWidth = editor->getWidth();
+		int originalHeight = editor->getHeight();
+		int originalLength = processor.bufferManager->getBufferLength();
+
+		EditorBenchmark benchmark{ processor, *editor };
+		juce::Array<juce::var> results;
+		for (int seconds : bufferLengths)
+		{
+			benchmark.editor.setBufferLength(seconds);
+			benchmark.writeAudio(seconds);
+
+			for (auto size : sizes)
+			{
+				for (auto theme : themes)
+				{
+					results.add(benchmark.runCase(theme, size.x, size.y, seconds, numFrames));
+					std::cerr << ".";
+				}
+			}
+		}
+		std::cerr << std::endl;
+
+		//opening again with a full history and the tiles the last editor left
+		editor.reset();
+		editor = std::make_unique<ReSamplerAudioProcessorEditor>(processor);
+		double reopenMillis = paintFirstFrame(*editor);
+
+		editor->setBufferLength(originalLength);
+		editor->setTheme(originalTheme);
+		editor->setSize(originalWidth, originalHeight);
+		editor.reset();
+
+		auto* report = new juce::DynamicObject();
+		report->setProperty("sampleRate", sampleRate);
+		report->setProperty("firstFrameMs", firstFrameMillis);
+		report->setProperty("reopenFirstFrameMs", reopenMillis);
+		report->setProperty("results", results);
+		juce::String json = juce::JSON::toString(juce::var(report));
+
+		if (args.containsOption("--output"))
+			return juce::File::getCurrentWorkingDirectory().getChildFile(args.getValueForOption("--output")).replaceWithText(json) ? 0 : 1;
+		std::cout << json << std::endl;
+		return 0;
+	}
+};
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+	juce::ScopedJuceInitialiser_GUI juceInitialiser;
+	juce::ArgumentList args(argc, argv);
+	return EditorBenchmark::run(args);
+}
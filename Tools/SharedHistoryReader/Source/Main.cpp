@@ -0,0 +1,224 @@
+/*
+  ==============================================================================
+
+	Main.cpp
+	Created: 19 Oct 2026 3:44:19pm
+	Author:  Tokamak
+
+	Reference reader for the shared memory history feed. Maps the segment
+	read-only and follows the protocol described in SharedHistoryLayout.h,
+	without any part of the plugin.
+
+	SharedHistoryReader [--name /ReSampler] --info
+	SharedHistoryReader [--name /ReSampler] --follow
+	SharedHistoryReader [--name /ReSampler] --seconds N --output file.wav
+
+	--follow prints the peak of every new stretch of audio, computed directly on
+	the mapped planes. --seconds copies the last N seconds and writes a WAV.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "../../../Source/SharedHistoryLayout.h"
+
+//==============================================================================
+struct SharedHistoryReader
+{
+	~SharedHistoryReader()
+	{
+		unmap();
+	}
+
+	bool map(const juce::String& name)
+	{
+		unmap();
+		int fd = shm_open(name.toRawUTF8(), O_RDONLY, 0);
+		if (fd < 0)
+			return false;
+
+		struct stat info;
+		if (fstat(fd, &info) == 0 && static_cast<size_t>(info.st_size) >= SharedHistoryLayout::dataOffset)
+		{
+			size = static_cast<size_t>(info.st_size);
+			void* data = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+			header = data != MAP_FAILED ? static_cast<const SharedHistoryLayout::Header*>(data) : nullptr;
+		}
+		::close(fd);
+
+		if (header == nullptr)
+			return false;
+		if (std::memcmp(header->magic, SharedHistoryLayout::magic, sizeof(header->magic)) != 0
+			|| header->version != SharedHistoryLayout::version
+			|| size < SharedHistoryLayout::getSegmentSize(header->numChannels, header->ringSamples))
+		{
+			unmap();
+			return false;
+		}
+		return true;
+	}
+
+	void unmap()
+	{
+		if (header != nullptr)
+			munmap(const_cast<SharedHistoryLayout::Header*>(header), size);
+		header = nullptr;
+	}
+
+	bool isRetired() const
+	{
+		return header->retired.load(std::memory_order_acquire) != 0;
+	}
+
+	//copies [start, start + numSamples) into dest, false if the writer lapped the copy or relaid the ring
+	bool read(std::int64_t start, juce::AudioBuffer<float>& dest, int numSamples) const
+	{
+		std::uint32_t generation = header->generation.load(std::memory_order_acquire);
+		std::int64_t written = header->samplesWritten.load(std::memory_order_acquire);
+		std::int64_t ringSamples = header->ringSamples;
+		if (numSamples > ringSamples || start < written - ringSamples || start + numSamples > written)
+			return false;
+
+		int position = static_cast<int>(start % ringSamples);
+		int firstPart = juce::jmin(numSamples, static_cast<int>(ringSamples) - position);
+		for (std::uint32_t channel = 0; channel < juce::jmin<std::uint32_t>(header->numChannels, static_cast<std::uint32_t>(dest.getNumChannels())); channel++)
+		{
+			const float* plane = SharedHistoryLayout::getChannel(header, channel);
+			dest.copyFrom(static_cast<int>(channel), 0, plane + position, firstPart);
+			if (firstPart < numSamples)
+				dest.copyFrom(static_cast<int>(channel), firstPart, plane, numSamples - firstPart);
+		}
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+		return header->generation.load(std::memory_order_relaxed) == generation && !isRetired()
+			&& start >= header->writeEnd.load(std::memory_order_relaxed) - ringSamples;
+	}
+
+	//peak of [start, start + numSamples) read in place, no copy
+	float peak(std::int64_t start, int numSamples) const
+	{
+		float level = 0.0f;
+		int position = static_cast<int>(start % header->ringSamples);
+		int firstPart = juce::jmin(numSamples, static_cast<int>(header->ringSamples) - position);
+		for (std::uint32_t channel = 0; channel < header->numChannels; channel++)
+		{
+			const float* plane = SharedHistoryLayout::getChannel(header, channel);
+			level = juce::jmax(level, juce::FloatVectorOperations::findMaximum(plane + position, firstPart),
+				-juce::FloatVectorOperations::findMinimum(plane + position, firstPart));
+			if (firstPart < numSamples)
+				level = juce::jmax(level, juce::FloatVectorOperations::findMaximum(plane, numSamples - firstPart),
+					-juce::FloatVectorOperations::findMinimum(plane, numSamples - firstPart));
+		}
+		return level;
+	}
+
+	const SharedHistoryLayout::Header* header = nullptr;
+	size_t size = 0;
+};
+
+//==============================================================================
+static void printInfo(const SharedHistoryReader& reader)
+{
+	auto* header = reader.header;
+	std::cout << "channels      " << header->numChannels << std::endl
+		<< "sampleRate    " << header->sampleRate << std::endl
+		<< "ringSamples   " << header->ringSamples << std::endl
+		<< "generation    " << header->generation.load() << std::endl
+		<< "samplesWritten " << header->samplesWritten.load() << std::endl
+		<< "writerPid     " << header->writerProcessId << std::endl
+		<< "retired       " << header->retired.load() << std::endl;
+}
+
+static int follow(SharedHistoryReader& reader, const juce::String& name)
+{
+	std::int64_t next = reader.header->samplesWritten.load(std::memory_order_acquire);
+	for (;;)
+	{
+		juce::Thread::sleep(500);
+		if (reader.isRetired())
+		{
+			//the writer changed the ring layout or closed, follow the name to the new segment
+			std::cout << "segment retired, remapping" << std::endl;
+			while (!reader.map(name))
+				juce::Thread::sleep(1000);
+			next = reader.header->samplesWritten.load(std::memory_order_acquire);
+			continue;
+		}
+
+		std::int64_t written = reader.header->samplesWritten.load(std::memory_order_acquire);
+		std::int64_t oldest = reader.header->writeEnd.load(std::memory_order_acquire) - reader.header->ringSamples;
+		if (next < oldest)
+		{
+			std::cout << "lapped, skipped " << (oldest - next) << " samples" << std::endl;
+			next = oldest;
+		}
+		int numSamples = static_cast<int>(juce::jmin<std::int64_t>(written - next, reader.header->ringSamples));
+		if (numSamples <= 0)
+			continue;
+
+		float level = reader.peak(next, numSamples);
+		std::cout << written << "  +" << numSamples << "  peak " << juce::Decibels::toString(juce::Decibels::gainToDecibels(level)) << std::endl;
+		next += numSamples;
+	}
+}
+
+static int capture(const SharedHistoryReader& reader, double seconds, const juce::File& file)
+{
+	auto* header = reader.header;
+	//leave 100 ms of slack at the old end so the write head cannot lap the copy straight away
+	std::int64_t slack = header->sampleRate / 10;
+	int maxSamples = static_cast<int>(juce::jmin<double>(seconds * header->sampleRate, static_cast<double>(header->ringSamples - slack)));
+	juce::AudioBuffer<float> audio(static_cast<int>(header->numChannels), juce::jmax(1, maxSamples));
+
+	for (int attempt = 0; attempt < 3; attempt++)
+	{
+		std::int64_t written = header->samplesWritten.load(std::memory_order_acquire);
+		int numSamples = static_cast<int>(juce::jmin<std::int64_t>(maxSamples, written));
+		if (numSamples <= 0)
+			return 1;
+		if (!reader.read(written - numSamples, audio, numSamples))
+			continue;
+
+		juce::WavAudioFormat wavFormat;
+		file.deleteFile();
+		std::unique_ptr<juce::FileOutputStream> stream(file.createOutputStream());
+		if (stream == nullptr)
+			return 1;
+		std::unique_ptr<juce::AudioFormatWriter> writer(wavFormat.createWriterFor(stream.get(), header->sampleRate, header->numChannels, 24, {}, 0));
+		if (writer == nullptr)
+			return 1;
+		stream.release();
+		std::cout << "wrote " << numSamples << " samples to " << file.getFullPathName() << std::endl;
+		return writer->writeFromAudioSampleBuffer(audio, 0, numSamples) ? 0 : 1;
+	}
+	std::cerr << "the writer kept lapping the copy" << std::endl;
+	return 1;
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+	juce::ArgumentList args(argc, argv);
+	juce::String name = args.containsOption("--name") ? args.getValueForOption("--name") : juce::String(SharedHistoryLayout::defaultName);
+
+	SharedHistoryReader reader;
+	if (!reader.map(name))
+	{
+		std::cerr << "cannot map " << name << ", is SharedMemory enabled in the plugin menu?" << std::endl;
+		return 1;
+	}
+
+	if (args.containsOption("--follow"))
+		return follow(reader, name);
+	if (args.containsOption("--seconds"))
+		return capture(reader, args.getValueForOption("--seconds").getDoubleValue(),
+			juce::File::getCurrentWorkingDirectory().getChildFile(args.containsOption("--output") ? args.getValueForOption("--output") : juce::String("history.wav")));
+
+	printInfo(reader);
+	return 0;
+}